@@ -0,0 +1,872 @@
+#include "constraints.h"
+#include "forces.h"
+#include "scene.h"
+#include "soft_body.h"
+#include "utils.h"
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Micro-benchmarks for the physics library.
+ * Run with no arguments to run every benchmark,
+ * or with the name of one benchmark to run just that one.
+ * Build with "make bench" so the library is compiled with optimizations.
+ */
+
+#define BENCH_BODIES 10000
+// Large enough that the scene's bodies do not fit in cache
+#define BENCH_LARGE_BODIES 200000
+#define BENCH_LARGE_TICKS 10
+#define BENCH_TICKS 100
+#define BENCH_DT 1e-3
+// Simulated seconds for measuring each integrator's energy drift
+#define BENCH_DRIFT_TIME 10.0
+// A stiff mesh of springs, and the simulated seconds it is run for
+#define BENCH_MESH_SIDE ((size_t) 20)
+#define BENCH_MESH_K 1e5
+#define BENCH_MESH_DRAG 0.1
+#define BENCH_MESH_TIME 2.0
+// Symplectic Euler's energy oscillates, so it is stable if it stays bounded
+#define BENCH_MESH_GROWTH 1.1
+// A chain of distance constraints dropped from horizontal, and the simulated
+// seconds it is run for
+#define BENCH_ROPE_LINKS ((size_t) 50)
+#define BENCH_ROPE_TIME 2.0
+// A square cloth hanging from its top corners, and the simulated seconds
+// it is run for
+#define BENCH_CLOTH_SIDE ((size_t) 100)
+#define BENCH_CLOTH_TIME 1.0
+
+/*
+ * Runs the benchmark function if it was selected on the command line.
+ * Like DO_TEST in test_util.h, but with the arguments in a global.
+ */
+#define DO_BENCH(BENCH_FN) \
+if (!selected || strcmp(selected, #BENCH_FN) == 0) { \
+    BENCH_FN(); \
+}
+
+char *selected = NULL;
+
+/** Returns the current time in seconds, for measuring intervals */
+double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/** Prints one result line: the benchmark name and the time per operation */
+void report(const char *name, size_t ops, double seconds) {
+    printf("%-32s %10zu ops %12.1f ns/op\n", name, ops, seconds / ops * 1e9);
+}
+
+/** Returns a square of side 2 centered at the given point */
+List *bench_shape(Vector center) {
+    return get_rectangle(center, 2, 2);
+}
+
+/** Returns a scene of n bodies on a grid, each moving with a random velocity */
+Scene *bench_scene(size_t n) {
+    Scene *scene = scene_init();
+    size_t side = 1;
+    while (side * side < n) side++;
+    for (size_t i = 0; i < n; i++) {
+        Vector center = {(i % side) * 4.0, (i / side) * 4.0};
+        BodyHandle handle = scene_spawn_body(scene, bench_shape(center), 1, \
+            (RGBColor) {0, 0, 0}, NULL, NULL);
+        body_set_velocity(scene_get_body_by_handle(scene, handle), \
+            (Vector) {pseudo_rand_decimal(-1, 1), pseudo_rand_decimal(-1, 1)});
+    }
+    return scene;
+}
+
+/** Measures creating and freeing bodies, including their shapes */
+void bench_body_create() {
+    Body **bodies = malloc(BENCH_BODIES * sizeof(Body *));
+    double start = now();
+    for (size_t i = 0; i < BENCH_BODIES; i++) {
+        bodies[i] = body_init(bench_shape(VEC_ZERO), 1, (RGBColor) {0, 0, 0});
+    }
+    for (size_t i = 0; i < BENCH_BODIES; i++) {
+        body_free(bodies[i]);
+    }
+    report("body_create", BENCH_BODIES, now() - start);
+    free(bodies);
+}
+
+/** Prints the bytes each body record occupies (not a timing) */
+void bench_body_layout() {
+    printf("%-32s %10zu bytes hot %6zu bytes cold\n", "body_layout", \
+        body_size(), body_cold_size());
+}
+
+/** Measures scene_tick() on free bodies with no force creators */
+void bench_scene_tick() {
+    Scene *scene = bench_scene(BENCH_BODIES);
+    double start = now();
+    for (size_t i = 0; i < BENCH_TICKS; i++) {
+        scene_tick(scene, BENCH_DT);
+    }
+    report("scene_tick (per body)", BENCH_BODIES * BENCH_TICKS, now() - start);
+    scene_free(scene);
+}
+
+/**
+ * Measures a frame that moves bodies by both forces and acceleration,
+ * first with the deprecated pair of tick functions (which move each body's
+ * vertices twice) and then with a single scene_tick().
+ */
+void bench_scene_tick_motion() {
+    Scene *scene = bench_scene(BENCH_BODIES);
+    double start = now();
+    for (size_t i = 0; i < BENCH_TICKS; i++) {
+        scene_tick(scene, BENCH_DT);
+        scene_tick_no_forces(scene, BENCH_DT);
+    }
+    report("scene_tick + scene_tick_no_forces", BENCH_BODIES * BENCH_TICKS, \
+        now() - start);
+    for (size_t i = 0; i < scene_bodies(scene); i++) {
+        body_set_motion(scene_get_body(scene, i), \
+            MOTION_FORCES | MOTION_ACCELERATION);
+    }
+    start = now();
+    for (size_t i = 0; i < BENCH_TICKS; i++) {
+        scene_tick(scene, BENCH_DT);
+    }
+    report("scene_tick with both motions", BENCH_BODIES * BENCH_TICKS, \
+        now() - start);
+    scene_free(scene);
+}
+
+/** Measures scene_tick() on the same scene with its bodies in body arrays */
+void bench_scene_tick_arrays() {
+    Scene *scene = bench_scene(BENCH_BODIES);
+    scene_set_body_arrays(scene, true);
+    double start = now();
+    for (size_t i = 0; i < BENCH_TICKS; i++) {
+        scene_tick(scene, BENCH_DT);
+    }
+    report("scene_tick arrays (per body)", BENCH_BODIES * BENCH_TICKS, \
+        now() - start);
+    scene_free(scene);
+}
+
+/**
+ * Measures scene_tick() on 1, 2 and 4 threads, at the size of a demo scene
+ * (which stays serial) and at BENCH_BODIES.
+ */
+void bench_scene_tick_threads() {
+    const size_t SIZES[] = {100, BENCH_BODIES};
+    const size_t THREADS[] = {1, 2, 4};
+    for (size_t s = 0; s < 2; s++) {
+        for (size_t t = 0; t < 3; t++) {
+            Scene *scene = bench_scene(SIZES[s]);
+            scene_set_threads(scene, THREADS[t]);
+            size_t ticks = BENCH_TICKS * (BENCH_BODIES / SIZES[s]);
+            double start = now();
+            for (size_t i = 0; i < ticks; i++) {
+                scene_tick(scene, BENCH_DT);
+            }
+            char name[64];
+            snprintf(name, sizeof(name), "scene_tick %zu bodies, %zu threads", \
+                SIZES[s], THREADS[t]);
+            report(name, SIZES[s] * ticks, now() - start);
+            scene_free(scene);
+        }
+    }
+}
+
+/**
+ * Measures scene_tick() on a chain of BENCH_BODIES bodies joined by springs
+ * and slowed by drag, where most of the tick is spent in force creators,
+ * on 1, 2 and 4 threads.
+ */
+void bench_scene_forces_threads() {
+    const size_t THREADS[] = {1, 2, 4};
+    for (size_t t = 0; t < 3; t++) {
+        Scene *scene = bench_scene(BENCH_BODIES);
+        scene_set_threads(scene, THREADS[t]);
+        for (size_t i = 0; i < BENCH_BODIES; i++) {
+            Body *body = scene_get_body(scene, i);
+            create_drag(scene, 0.1, body);
+            if (i > 0) {
+                create_spring(scene, 1, scene_get_body(scene, i - 1), body);
+            }
+        }
+        double start = now();
+        for (size_t i = 0; i < BENCH_TICKS; i++) {
+            scene_tick(scene, BENCH_DT);
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "scene_tick springs, %zu threads", \
+            THREADS[t]);
+        report(name, BENCH_BODIES * BENCH_TICKS, now() - start);
+        scene_free(scene);
+    }
+}
+
+/**
+ * Measures scene_tick() on a scene far larger than the cache,
+ * where time per body is dominated by cache misses on body records.
+ */
+void bench_scene_tick_large() {
+    Scene *scene = bench_scene(BENCH_LARGE_BODIES);
+    double start = now();
+    for (size_t i = 0; i < BENCH_LARGE_TICKS; i++) {
+        scene_tick(scene, BENCH_DT);
+    }
+    report("scene_tick large (per body)", \
+        BENCH_LARGE_BODIES * BENCH_LARGE_TICKS, now() - start);
+    scene_free(scene);
+}
+
+/** Measures dropping a scene of bodies built in its arena and rebuilding it */
+void bench_scene_reset() {
+    Scene *scene = scene_init();
+    utils_set_shape_allocator(arena_allocator(scene_get_arena(scene)));
+    double start = now();
+    for (size_t i = 0; i < BENCH_TICKS; i++) {
+        scene_reset(scene);
+        for (size_t j = 0; j < BENCH_BODIES; j++) {
+            scene_spawn_body(scene, bench_shape(VEC_ZERO), 1, \
+                (RGBColor) {0, 0, 0}, NULL, NULL);
+        }
+    }
+    report("scene_reset + respawn (per body)", BENCH_BODIES * BENCH_TICKS, \
+        now() - start);
+    utils_set_shape_allocator(NULL);
+    scene_free(scene);
+}
+
+/** Measures rebuilding the same scene from a prefab in one batch */
+void bench_scene_spawn_many() {
+    Scene *scene = scene_init();
+    ShapePrefab *prefab = prefab_init(bench_shape(VEC_ZERO));
+    Transform *transforms = malloc(BENCH_BODIES * sizeof(Transform));
+    assert(transforms);
+    for (size_t i = 0; i < BENCH_BODIES; i++) {
+        transforms[i] = (Transform) {(Vector) {i, 0}, 0};
+    }
+    double start = now();
+    for (size_t i = 0; i < BENCH_TICKS; i++) {
+        scene_reset(scene);
+        scene_spawn_many(scene, prefab, transforms, BENCH_BODIES, 1, \
+            (RGBColor) {0, 0, 0}, NULL);
+    }
+    report("scene_reset + scene_spawn_many (per body)", \
+        BENCH_BODIES * BENCH_TICKS, now() - start);
+    free(transforms);
+    prefab_release(prefab);
+    scene_free(scene);
+}
+
+/** Measures ticking a scene where half of the bodies are removed at once */
+void bench_scene_remove() {
+    Scene *scene = scene_init();
+    utils_set_shape_allocator(arena_allocator(scene_get_arena(scene)));
+    double elapsed = 0;
+    for (size_t i = 0; i < BENCH_TICKS / 10; i++) {
+        scene_reset(scene);
+        for (size_t j = 0; j < BENCH_BODIES; j++) {
+            BodyHandle handle = scene_spawn_body(scene, \
+                bench_shape((Vector) {j, 0}), 1, (RGBColor) {0, 0, 0}, \
+                NULL, NULL);
+            if (j % 2 == 0) {
+                body_remove(scene_get_body_by_handle(scene, handle));
+            }
+        }
+        double start = now();
+        scene_tick(scene, 1e-3);
+        elapsed += now() - start;
+    }
+    report("scene_tick removing half (per body)", \
+        BENCH_BODIES * (BENCH_TICKS / 10), elapsed);
+    utils_set_shape_allocator(NULL);
+    scene_free(scene);
+}
+
+/** Measures registering (and resetting) gravity between every pair of bodies */
+void bench_gravity_pairs() {
+    const size_t n = 300;
+    Scene *scene = scene_init();
+    utils_set_shape_allocator(arena_allocator(scene_get_arena(scene)));
+    size_t pairs = 0;
+    double start = now();
+    for (size_t round = 0; round < BENCH_TICKS / 10; round++) {
+        scene_reset(scene);
+        for (size_t i = 0; i < n; i++) {
+            scene_spawn_body(scene, bench_shape((Vector) {i, 0}), 1, \
+                (RGBColor) {0, 0, 0}, NULL, NULL);
+        }
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = i + 1; j < n; j++) {
+                create_newtonian_gravity(scene, 1, scene_get_body(scene, i), \
+                    scene_get_body(scene, j));
+                pairs++;
+            }
+        }
+    }
+    report("create_newtonian_gravity (per pair)", pairs, now() - start);
+    utils_set_shape_allocator(NULL);
+    scene_free(scene);
+}
+
+/** Measures ticking a scene of 300 bodies with gravity between every pair */
+void bench_gravity_tick() {
+    const size_t n = 300;
+    Scene *scene = scene_init();
+    for (size_t i = 0; i < n; i++) {
+        Vector center = {(i % 20) * 10.0, (i / 20) * 10.0};
+        scene_spawn_body(scene, bench_shape(center), 1, \
+            (RGBColor) {0, 0, 0}, NULL, NULL);
+    }
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = i + 1; j < n; j++) {
+            create_newtonian_gravity(scene, 1, scene_get_body(scene, i), \
+                scene_get_body(scene, j));
+        }
+    }
+    double start = now();
+    for (size_t i = 0; i < BENCH_TICKS; i++) {
+        scene_tick(scene, BENCH_DT);
+    }
+    report("scene_tick gravity (per pair)", n * (n - 1) / 2 * BENCH_TICKS, \
+        now() - start);
+    scene_free(scene);
+}
+
+/**
+ * Measures ticking scenes of up to 20000 bodies with create_nbody_gravity(),
+ * with fewer ticks for more bodies so each size does about the same work
+ */
+/**
+ * Compares pulling falling bodies towards an Earth-sized body, one
+ * newtonian gravity force per body, with the scene's uniform gravity field.
+ */
+void bench_uniform_gravity() {
+    const size_t n = 2000;
+    for (int field = 0; field < 2; field++) {
+        Scene *scene = scene_init();
+        Body *earth = NULL;
+        if (field) {
+            scene_set_gravity(scene, (Vector) {0, -9.8});
+        } else {
+            BodyHandle handle = scene_spawn_body(scene, \
+                bench_shape(VEC_ZERO), 6E24, (RGBColor) {0, 0, 0}, NULL, NULL);
+            earth = scene_get_body_by_handle(scene, handle);
+            body_set_centroid(earth, (Vector) {0, -6.4E6});
+            body_set_type(earth, BODY_STATIC);
+        }
+        for (size_t i = 0; i < n; i++) {
+            Vector center = {(i % 50) * 10.0, (i / 50) * 10.0};
+            BodyHandle handle = scene_spawn_body(scene, bench_shape(center), 1, \
+                (RGBColor) {0, 0, 0}, NULL, NULL);
+            if (!field) {
+                create_newtonian_gravity(scene, 6.67E-11, earth, \
+                    scene_get_body_by_handle(scene, handle));
+            }
+        }
+        double start = now();
+        for (size_t i = 0; i < BENCH_TICKS; i++) {
+            scene_tick(scene, BENCH_DT);
+        }
+        report(field ? "scene_tick gravity field (per body)" \
+            : "scene_tick gravity body (per body)", n * BENCH_TICKS, \
+            now() - start);
+        scene_free(scene);
+    }
+}
+
+void bench_nbody_gravity() {
+    const size_t SIZES[] = {300, 1000, 5000, 20000};
+    for (size_t s = 0; s < sizeof(SIZES) / sizeof(SIZES[0]); s++) {
+        size_t n = SIZES[s];
+        size_t ticks = 20000 * 20000 / (n * n);
+        Scene *scene = bench_scene(n);
+        List *bodies = list_init(n, NULL);
+        for (size_t i = 0; i < n; i++) {
+            list_add(bodies, scene_get_body(scene, i));
+        }
+        create_nbody_gravity(scene, 1, bodies, 1);
+        list_free(bodies);
+        double start = now();
+        for (size_t i = 0; i < ticks; i++) {
+            scene_tick(scene, BENCH_DT);
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "n-body gravity, %zu bodies", n);
+        report(name, n * (n - 1) / 2 * ticks, now() - start);
+        scene_free(scene);
+    }
+}
+
+/**
+ * Returns a scene of n bodies at rest, with masses from 1 to 10, at random
+ * points of a square that holds about 100 square units per body.
+ * It is the same every time for a given n.
+ */
+Scene *bench_cluster(size_t n, List *bodies) {
+    srand(1);
+    double side = sqrt(n) * 10;
+    Scene *scene = scene_init();
+    for (size_t i = 0; i < n; i++) {
+        Vector center = {pseudo_rand_decimal(0, side), \
+            pseudo_rand_decimal(0, side)};
+        BodyHandle handle = scene_spawn_body(scene, bench_shape(center), \
+            pseudo_rand_decimal(1, 10), (RGBColor) {0, 0, 0}, NULL, NULL);
+        list_add(bodies, scene_get_body_by_handle(scene, handle));
+    }
+    return scene;
+}
+
+/**
+ * Returns the relative root-mean-square difference between the velocities
+ * of two scenes' bodies, which is that of their forces after one tick
+ */
+double bench_velocity_error(Scene *scene, Scene *exact) {
+    double error = 0, total = 0;
+    for (size_t i = 0; i < scene_bodies(exact); i++) {
+        Vector velocity = body_get_velocity(scene_get_body(exact, i));
+        Vector difference = vec_subtract(velocity, \
+            body_get_velocity(scene_get_body(scene, i)));
+        error += vec_dot(difference, difference);
+        total += vec_dot(velocity, velocity);
+    }
+    return sqrt(error / total);
+}
+
+/**
+ * Measures a tick of Barnes-Hut gravity at several opening angles, against
+ * exact n-body gravity where that is fast enough to run, and reports each
+ * angle's error in the forces relative to the exact ones
+ */
+void bench_barnes_hut() {
+    const size_t SIZES[] = {5000, 20000, 100000};
+    const double THETAS[] = {0.3, 0.5, 1};
+    const double SOFTENING = 1;
+    for (size_t s = 0; s < sizeof(SIZES) / sizeof(SIZES[0]); s++) {
+        size_t n = SIZES[s];
+        char name[64];
+        Scene *exact = NULL;
+        if (n <= 20000) {
+            List *bodies = list_init(n, NULL);
+            exact = bench_cluster(n, bodies);
+            create_nbody_gravity(exact, 1, bodies, SOFTENING);
+            list_free(bodies);
+            double start = now();
+            scene_tick(exact, BENCH_DT);
+            snprintf(name, sizeof(name), "exact n-body, %zu bodies", n);
+            report(name, n, now() - start);
+        }
+        for (size_t t = 0; t < sizeof(THETAS) / sizeof(THETAS[0]); t++) {
+            List *bodies = list_init(n, NULL);
+            Scene *scene = bench_cluster(n, bodies);
+            create_barnes_hut_gravity(scene, 1, bodies, SOFTENING, THETAS[t]);
+            list_free(bodies);
+            double start = now();
+            scene_tick(scene, BENCH_DT);
+            double elapsed = now() - start;
+            snprintf(name, sizeof(name), "Barnes-Hut %.1f, %zu bodies", \
+                THETAS[t], n);
+            report(name, n, elapsed);
+            if (exact) {
+                printf("%-32s %12.3e force error\n", "", \
+                    bench_velocity_error(scene, exact));
+            }
+            scene_free(scene);
+        }
+        if (exact) {
+            scene_free(exact);
+        }
+    }
+}
+
+/**
+ * Measures a tick in which 10 bodies need 10 substeps each,
+ * first by ticking the whole scene 10 times as often
+ * and then by substepping just those bodies.
+ */
+void bench_scene_substep() {
+    const size_t FAST = 10, SUBSTEPS = 10;
+    for (int substep = 0; substep < 2; substep++) {
+        Scene *scene = bench_scene(BENCH_BODIES);
+        for (size_t i = 0; i < FAST; i++) {
+            Body *body = scene_get_body(scene, i * (BENCH_BODIES / FAST));
+            body_set_velocity(body, (Vector) {100, 0});
+            if (substep) {
+                body_set_max_displacement(body, 100 * BENCH_DT / SUBSTEPS);
+            }
+        }
+        double start = now();
+        for (size_t i = 0; i < BENCH_TICKS; i++) {
+            if (substep) {
+                scene_tick(scene, BENCH_DT);
+                continue;
+            }
+            for (size_t j = 0; j < SUBSTEPS; j++) {
+                scene_tick(scene, BENCH_DT / SUBSTEPS);
+            }
+        }
+        report(substep ? "scene_tick substepping 10 bodies" \
+            : "scene_tick at 10x rate", BENCH_TICKS, now() - start);
+        scene_free(scene);
+    }
+}
+
+/**
+ * Measures ticking a pile of bodies at rest, each checked for collisions with
+ * its neighbor, first awake and then once they have all gone to sleep.
+ */
+void bench_scene_sleeping() {
+    const size_t n = 2000;
+    for (int sleeping = 0; sleeping < 2; sleeping++) {
+        Scene *scene = scene_init();
+        for (size_t i = 0; i < n; i++) {
+            scene_spawn_body(scene, bench_shape((Vector) {i * 4.0, 0}), 1, \
+                (RGBColor) {0, 0, 0}, NULL, NULL);
+        }
+        for (size_t i = 0; i + 1 < n; i++) {
+            create_physics_collision(scene, 0, scene_get_body(scene, i), \
+                scene_get_body(scene, i + 1));
+        }
+        if (sleeping) {
+            scene_set_sleeping(scene, 1e-3, 1);
+            scene_tick(scene, BENCH_DT);
+            assert(scene_sleeping_bodies(scene) == n);
+        }
+        double start = now();
+        for (size_t i = 0; i < BENCH_TICKS; i++) {
+            scene_tick(scene, BENCH_DT);
+        }
+        report(sleeping ? "scene_tick 2000 sleeping bodies" \
+            : "scene_tick 2000 resting bodies", BENCH_TICKS, now() - start);
+        scene_free(scene);
+    }
+}
+
+const char *INTEGRATOR_NAMES[] = {
+    "average", "symplectic", "verlet", "rk4", "adaptive"
+};
+
+/** The total energy of two bodies joined by a spring or gravity */
+double bench_energy(Body *body1, Body *body2, double constant, bool spring) {
+    Vector v1 = body_get_velocity(body1), v2 = body_get_velocity(body2);
+    double kinetic = body_get_mass(body1) * vec_dot(v1, v1) / 2 + \
+        body_get_mass(body2) * vec_dot(v2, v2) / 2;
+    double r = vec_distance(body_get_centroid(body1), body_get_centroid(body2));
+    if (spring) {
+        return kinetic + constant * r * r / 2;
+    }
+    return kinetic - \
+        constant * body_get_mass(body1) * body_get_mass(body2) / r;
+}
+
+/**
+ * Runs two bodies on an eccentric orbit or a spring for BENCH_DRIFT_TIME
+ * with an integrator and step, reporting the wall-clock time taken and
+ * the largest relative energy error seen.
+ * The tolerance is only used by INTEGRATOR_ADAPTIVE.
+ */
+void bench_drift_run(
+    bool spring, Integrator integrator, double dt, double tolerance
+) {
+    const double M1 = 4.5, M2 = 7.3, G = 1e3, K = 3;
+    Scene *scene = scene_init();
+    scene_set_integrator(scene, integrator);
+    scene_set_tolerance(scene, tolerance);
+    Body *body1 = body_init(bench_shape(VEC_ZERO), M1, (RGBColor) {0, 0, 0});
+    Body *body2 = body_init(bench_shape((Vector) {10, 20}), M2, \
+        (RGBColor) {0, 0, 0});
+    scene_add_body(scene, body1);
+    scene_add_body(scene, body2);
+    // Relative speed 0.8 of a circular orbit's, with zero total momentum
+    double r = vec_distance(body_get_centroid(body1), body_get_centroid(body2));
+    double circular = spring ? r * sqrt(K * (M1 + M2) / (M1 * M2)) \
+        : sqrt(G * (M1 + M2) / r);
+    double speed = 0.8 * circular;
+    Vector across = vec_unit_vector((Vector) {-20, 10});
+    body_set_velocity(body1, vec_multiply(-speed * M2 / (M1 + M2), across));
+    body_set_velocity(body2, vec_multiply(speed * M1 / (M1 + M2), across));
+    double constant = spring ? K : G;
+    if (spring) {
+        create_spring(scene, K, body1, body2);
+    } else {
+        create_newtonian_gravity(scene, G, body1, body2);
+    }
+
+    double initial = bench_energy(body1, body2, constant, spring);
+    double drift = 0;
+    size_t ticks = (size_t) round(BENCH_DRIFT_TIME / dt);
+    double elapsed = 0;
+    for (size_t i = 0; i < ticks; i++) {
+        double start = now();
+        scene_tick(scene, dt);
+        elapsed += now() - start;
+        double error = fabs(bench_energy(body1, body2, constant, spring) / \
+            initial - 1);
+        drift = fmax(drift, error);
+    }
+    printf("%-8s %-10s dt=%-6g %10.3f ms %12.3e drift", \
+        spring ? "spring" : "gravity", INTEGRATOR_NAMES[integrator], dt, \
+        elapsed * 1e3, drift);
+    if (integrator == INTEGRATOR_ADAPTIVE) {
+        printf("  tol=%g %zu steps %zu rejected", tolerance, \
+            scene_steps_taken(scene), scene_steps_rejected(scene));
+    }
+    printf("\n");
+    scene_free(scene);
+}
+
+/**
+ * Reports energy drift against wall-clock time for each integrator
+ * on a two-body orbit and a spring, over several step sizes,
+ * and for INTEGRATOR_ADAPTIVE over several tolerances.
+ */
+void bench_integrator_drift() {
+    const double STEPS[] = {1e-2, 1e-3, 1e-4};
+    const double TOLERANCES[] = {1e-6, 1e-9, 1e-12};
+    for (int spring = 0; spring < 2; spring++) {
+        for (Integrator integrator = INTEGRATOR_AVERAGE_VELOCITY; \
+                integrator <= INTEGRATOR_RK4; integrator++) {
+            for (size_t i = 0; i < sizeof(STEPS) / sizeof(STEPS[0]); i++) {
+                bench_drift_run(spring, integrator, STEPS[i], 1);
+            }
+        }
+        for (size_t i = 0; i < sizeof(TOLERANCES) / sizeof(TOLERANCES[0]); i++) {
+            bench_drift_run(spring, INTEGRATOR_ADAPTIVE, 0.1, TOLERANCES[i]);
+        }
+    }
+}
+
+/**
+ * Makes a side x side grid of bodies, each joined to its neighbours by springs.
+ * Explicit springs are integrated with INTEGRATOR_SYMPLECTIC_EULER,
+ * the integrator that keeps them stable at the largest step.
+ */
+Scene *bench_mesh(size_t side, double k, bool implicit) {
+    Scene *scene = scene_init();
+    if (!implicit) {
+        scene_set_integrator(scene, INTEGRATOR_SYMPLECTIC_EULER);
+    }
+    srand(3);
+    for (size_t i = 0; i < side * side; i++) {
+        Vector center = {i % side, i / side};
+        BodyHandle handle = scene_spawn_body(scene, bench_shape(center), 1, \
+            (RGBColor) {0, 0, 0}, NULL, NULL);
+        body_set_velocity(scene_get_body_by_handle(scene, handle), \
+            (Vector) {pseudo_rand_decimal(-1, 1), pseudo_rand_decimal(-1, 1)});
+    }
+    SpringNetwork *network = implicit ? create_spring_network(scene) : NULL;
+    for (size_t i = 0; i < side * side; i++) {
+        Body *body = scene_get_body(scene, i);
+        // The bodies to its left and below it, or itself at an edge
+        size_t neighbours[] = {i % side > 0 ? i - 1 : i, \
+            i >= side ? i - side : i};
+        for (size_t n = 0; n < 2; n++) {
+            if (neighbours[n] == i) {
+                continue;
+            }
+            Body *other = scene_get_body(scene, neighbours[n]);
+            if (implicit) {
+                spring_network_add_spring(network, k, other, body);
+            } else {
+                create_spring(scene, k, other, body);
+            }
+        }
+        if (implicit) {
+            spring_network_add_drag(network, BENCH_MESH_DRAG, body);
+        } else {
+            create_drag(scene, BENCH_MESH_DRAG, body);
+        }
+    }
+    return scene;
+}
+
+/** The kinetic energy of a bench_mesh(), plus its springs' potential energy */
+double bench_mesh_energy(Scene *scene, size_t side, double k) {
+    double energy = 0;
+    for (size_t i = 0; i < side * side; i++) {
+        Body *body = scene_get_body(scene, i);
+        Vector v = body_get_velocity(body);
+        energy += body_get_mass(body) * vec_dot(v, v) / 2;
+        size_t neighbours[] = {i % side > 0 ? i - 1 : i, \
+            i >= side ? i - side : i};
+        for (size_t n = 0; n < 2; n++) {
+            double r = vec_distance(body_get_centroid(body), \
+                body_get_centroid(scene_get_body(scene, neighbours[n])));
+            energy += k * r * r / 2;
+        }
+    }
+    return energy;
+}
+
+/**
+ * Runs a bench_mesh() for BENCH_MESH_TIME with a step, returning the
+ * wall-clock time taken and storing the largest energy seen relative to the
+ * initial energy in growth.
+ */
+double bench_mesh_run(bool implicit, double dt, double *growth) {
+    Scene *scene = bench_mesh(BENCH_MESH_SIDE, BENCH_MESH_K, implicit);
+    double initial = bench_mesh_energy(scene, BENCH_MESH_SIDE, BENCH_MESH_K);
+    size_t ticks = (size_t) round(BENCH_MESH_TIME / dt);
+    double elapsed = 0;
+    *growth = 0;
+    for (size_t i = 0; i < ticks; i++) {
+        double start = now();
+        scene_tick(scene, dt);
+        elapsed += now() - start;
+        double energy = bench_mesh_energy(scene, BENCH_MESH_SIDE, BENCH_MESH_K);
+        // A blown-up mesh has infinite or NaN energy
+        *growth = energy <= *growth * initial ? *growth : energy / initial;
+    }
+    scene_free(scene);
+    return elapsed;
+}
+
+/**
+ * Compares explicit springs with a spring network on a stiff mesh at equal
+ * stability: the explicit springs at the largest power-of-2 fraction of
+ * 1/60 s that keeps the mesh's energy within BENCH_MESH_GROWTH of where it
+ * started, and the network at 1/60 s.
+ */
+void bench_spring_network() {
+    for (int implicit = 0; implicit < 2; implicit++) {
+        double dt = 1.0 / 60;
+        double growth;
+        double elapsed = bench_mesh_run(implicit, dt, &growth);
+        while (!implicit && !(growth <= BENCH_MESH_GROWTH)) {
+            dt /= 2;
+            elapsed = bench_mesh_run(implicit, dt, &growth);
+        }
+        size_t ticks = (size_t) round(BENCH_MESH_TIME / dt);
+        printf("%-8s %zu springs dt=%-9.3g %6zu ticks %10.3f ms " \
+            "%10.0f steps/s %8.3f energy growth\n", \
+            implicit ? "network" : "explicit", \
+            2 * BENCH_MESH_SIDE * (BENCH_MESH_SIDE - 1), dt, ticks, \
+            elapsed * 1e3, ticks / elapsed, growth);
+    }
+}
+
+/**
+ * Makes a chain of links of length 1 hanging from a static body, held
+ * horizontal at first, joined by distance constraints
+ */
+Scene *bench_rope(size_t iterations) {
+    Scene *scene = scene_init();
+    scene_set_gravity(scene, (Vector) {0, -10});
+    Body *previous = NULL;
+    for (size_t i = 0; i <= BENCH_ROPE_LINKS; i++) {
+        BodyHandle handle = scene_spawn_body(scene, \
+            get_rectangle((Vector) {i, 0}, 0.1, 0.1), 1, \
+            (RGBColor) {0, 0, 0}, NULL, NULL);
+        Body *body = scene_get_body_by_handle(scene, handle);
+        if (previous) {
+            create_distance_constraint(scene, previous, body, 1);
+        } else {
+            body_set_type(body, BODY_STATIC);
+        }
+        previous = body;
+    }
+    constraints_set_iterations(scene, iterations);
+    return scene;
+}
+
+/**
+ * Measures a falling chain of distance constraints at 1/60 s with several
+ * solver iteration counts, and how far from its length the chain's most
+ * stretched link got, which shrinks as the iterations grow
+ */
+void bench_constraints() {
+    const size_t ITERATIONS[] = {CONSTRAINT_DEFAULT_ITERATIONS, 50, 200};
+    const double DT = 1.0 / 60;
+    size_t ticks = (size_t) round(BENCH_ROPE_TIME / DT);
+    for (size_t k = 0; k < 3; k++) {
+        Scene *scene = bench_rope(ITERATIONS[k]);
+        double elapsed = 0, stretch = 0;
+        for (size_t i = 0; i < ticks; i++) {
+            double start = now();
+            scene_tick(scene, DT);
+            elapsed += now() - start;
+            for (size_t j = 1; j <= BENCH_ROPE_LINKS; j++) {
+                double length = vec_distance( \
+                    body_get_centroid(scene_get_body(scene, j - 1)), \
+                    body_get_centroid(scene_get_body(scene, j)));
+                stretch = fmax(stretch, fabs(length - 1));
+            }
+        }
+        printf("constraints %zu links %4zu iterations %6zu ticks " \
+            "%10.3f ms %10.2g stretch\n", BENCH_ROPE_LINKS, ITERATIONS[k], \
+            ticks, elapsed * 1e3, stretch);
+        scene_free(scene);
+    }
+}
+
+/**
+ * Measures a BENCH_CLOTH_SIDE by BENCH_CLOTH_SIDE cloth falling onto a
+ * static box at 60 ticks per second, with the default substeps,
+ * on 1, 2 and 4 threads
+ */
+void bench_cloth() {
+    const size_t THREADS[] = {1, 2, 4};
+    const double DT = 1.0 / 60;
+    size_t ticks = (size_t) round(BENCH_CLOTH_TIME / DT);
+    for (size_t t = 0; t < 3; t++) {
+        Scene *scene = scene_init();
+        scene_set_threads(scene, THREADS[t]);
+        scene_set_gravity(scene, (Vector) {0, -10});
+        BodyHandle handle = scene_spawn_body(scene, \
+            get_rectangle((Vector) {5, -8}, 4, 2), 1, (RGBColor) {0, 0, 0}, \
+            NULL, NULL);
+        Body *box = scene_get_body_by_handle(scene, handle);
+        body_set_type(box, BODY_STATIC);
+        SoftBody *cloth = create_cloth(scene, VEC_ZERO, BENCH_CLOTH_SIDE, \
+            BENCH_CLOTH_SIDE, 0.1, 0.01, 0, 1e-2);
+        soft_body_pin(cloth, 0);
+        soft_body_pin(cloth, BENCH_CLOTH_SIDE - 1);
+        soft_body_add_collider(cloth, box);
+        double start = now();
+        for (size_t i = 0; i < ticks; i++) {
+            scene_tick(scene, DT);
+        }
+        double elapsed = now() - start;
+        printf("cloth %zux%zu %zu threads %6zu ticks %10.3f ms/tick\n", \
+            BENCH_CLOTH_SIDE, BENCH_CLOTH_SIDE, THREADS[t], ticks, \
+            elapsed / ticks * 1e3);
+        scene_free(scene);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        selected = argv[1];
+    }
+
+    DO_BENCH(bench_body_layout)
+    DO_BENCH(bench_body_create)
+    DO_BENCH(bench_scene_tick)
+    DO_BENCH(bench_scene_tick_arrays)
+    DO_BENCH(bench_scene_tick_threads)
+    DO_BENCH(bench_scene_forces_threads)
+    DO_BENCH(bench_scene_tick_motion)
+    DO_BENCH(bench_scene_tick_large)
+    DO_BENCH(bench_scene_reset)
+    DO_BENCH(bench_scene_spawn_many)
+    DO_BENCH(bench_scene_remove)
+    DO_BENCH(bench_gravity_pairs)
+    DO_BENCH(bench_gravity_tick)
+    DO_BENCH(bench_uniform_gravity)
+    DO_BENCH(bench_nbody_gravity)
+    DO_BENCH(bench_barnes_hut)
+    DO_BENCH(bench_scene_substep)
+    DO_BENCH(bench_scene_sleeping)
+    DO_BENCH(bench_integrator_drift)
+    DO_BENCH(bench_spring_network)
+    DO_BENCH(bench_constraints)
+    DO_BENCH(bench_cloth)
+
+    return 0;
+}
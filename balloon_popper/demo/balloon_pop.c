@@ -23,11 +23,8 @@ const RGBColor BLACK = (RGBColor) {0, 0, 0};
 // screen dimensions
 #define LENGTH_AND_HEIGHT (Vector){1000, 500}
 
-// Constants for gravity
-#define G 6.67E-11 // N m^2 / kg^2
-#define M 6E24 // kg
+// Acceleration due to gravity
 #define g 9.8 // m / s^2
-#define R (sqrt(G * M / g)) // m
 
 const RGBColor RED = (RGBColor) {1, 0, 0};
 const RGBColor ORANGE = (RGBColor) {1, 127.0/255, 0};
@@ -40,8 +37,7 @@ const RGBColor WHITE = (RGBColor) {1, 1, 1};
 const Vector OUTER_BAR_CENTER = {-375, -225};
 const double OUTER_BAR_WIDTH = 100;
 const double BAR_HEIGHT = 20;
-const int POWER_DIVISIONS = 100;
-const int BALLOON_IDX_START = POWER_DIVISIONS+3;
+#define POWER_DIVISIONS 100
 
 const double ARROW_WIDTH = 60;
 const double ARROW_HEIGHT = 4;
@@ -80,45 +76,76 @@ const int SCORE_TEXT_WIDTH = 320;
 const int SCORE_TEXT_HEIGHT = 30;
 const Vector SCORE_TEXT_POSITION = {-160, -215};
 
+/*
+ * Bodies are looked up through handles rather than scene indices,
+ * since indices shift whenever a balloon or dart is removed.
+ */
 typedef struct {
     double power;
     int level;
     int dartsLeft;
     int target;
+    BodyHandle power_bars[POWER_DIVISIONS];
+    BodyHandle arrow;
+    BodyHandle wall;
+    BodyHandle dart;
+    // Every balloon and power bar is a copy of one of these
+    ShapePrefab *balloon_prefab;
+    ShapePrefab *bar_prefab;
 } AdditionalInfo;
 
 void free_additional_info(void* data) {
     AdditionalInfo* i = data;
+    prefab_release(i->balloon_prefab);
+    prefab_release(i->bar_prefab);
     free(i);
 }
 
-bool no_darts_on_screen(Scene *scene) {
-    if (body_get_role(scene_get_body(scene, scene_bodies(scene) - 1)) \
-        == REMOVE_ON_COLLISION) {
-            return true;
-    }
-    return false;
+bool no_darts_on_screen(GameInfo *game_info) {
+    AdditionalInfo* info = get_additional_info(game_info);
+    return scene_get_body_by_handle(get_scene(game_info), info->dart) == NULL;
+}
+
+/** Allocates a body's role in the scene's arena, so scene_reset() drops it */
+Role *new_role(Scene *scene, Role role) {
+    Role *type = arena_alloc(scene_get_arena(scene), sizeof(Role));
+    *type = role;
+    return type;
+}
+
+bool is_balloon(Body *body) {
+    return body_get_role(body) == REMOVE_ON_COLLISION;
 }
 
 void initialize_power_bars(GameInfo* game_info) {
     Scene* scene = get_scene(game_info);
+    AdditionalInfo* info = get_additional_info(game_info);
     Vector outer_bar_center = {ARCHER_POSITION.x + 25, ARCHER_POSITION.y - 103};
     double outer_bar_left = outer_bar_center.x - (OUTER_BAR_WIDTH / 2);
     double bar_width = (OUTER_BAR_WIDTH / POWER_DIVISIONS);
     Vector center = vec_init(outer_bar_left + (bar_width / 2), outer_bar_center.y);
 
+    Transform transforms[POWER_DIVISIONS];
     for (size_t i = 0; i < POWER_DIVISIONS; i++) {
-        List *bar_points = get_rectangle(center, bar_width, BAR_HEIGHT);
-        scene_add_special_body(scene, BLACK, bar_points, -1, VEC_ZERO, VEC_ZERO, VEC_ZERO);
+        Vector position = vec_add(center, prefab_get_centroid(info->bar_prefab));
+        transforms[i] = (Transform) {position, 0};
         center = vec_add(center, (Vector){bar_width, 0});
     }
+    scene_spawn_many(scene, info->bar_prefab, transforms, POWER_DIVISIONS, \
+        DEFAULT_MASS, BLACK, info->power_bars);
+    // The bars stay put in the scene's gravity
+    for (size_t i = 0; i < POWER_DIVISIONS; i++) {
+        body_set_gravity_scale( \
+            scene_get_body_by_handle(scene, info->power_bars[i]), 0);
+    }
 }
 
 void update_power_bars(GameInfo* game_info) {
     Scene* scene = get_scene(game_info);
-    double power = ((AdditionalInfo*)(get_additional_info(game_info)))->power;
+    AdditionalInfo* info = get_additional_info(game_info);
+    double power = info->power;
     for (size_t i = 1; i <= POWER_DIVISIONS; i++) {
-        Body *bar_to_color = scene_get_body(scene, i-1);
+        Body *bar_to_color = scene_get_body_by_handle(scene, info->power_bars[i-1]);
         if (i <= power * POWER_DIVISIONS) {
             body_set_color(bar_to_color, RED);
         } else {
@@ -130,41 +157,26 @@ void update_power_bars(GameInfo* game_info) {
  * Spawns arrow onto the scene
  * @param scene the scene
  */
-void spawn_arrow(GameInfo *game_info) {
+void spawn_arrow(GameInfo *game_info, double angle) {
     Scene* scene = get_scene(game_info);
     Vector arrow_pivot = vec_add(ARCHER_POSITION, (Vector){ARCHER_WIDTH/2, -ARCHER_HEIGHT/2+2});
     List* points = get_arrow_points(arrow_pivot, ARROW_WIDTH, ARROW_HEIGHT, ARROW_LENGTH);
-    Role *type = malloc(sizeof(Role));
-    assert(type);
-    *type = BULLET;
-    Body* arrow = body_init_with_info(points, DEFAULT_MASS, ORANGE, type, free);
-    scene_add_body(scene, arrow);
-}
-
-/** Creates an Earth-like mass to accelerate the balls */
-void spawn_gravity_body(GameInfo *game_info) {
-    Scene* scene = get_scene(game_info);
-    // Will be offscreen, so shape is irrelevant
-    List *gravity_ball = get_circle_points(VEC_ZERO, 1);
-    Role *type = malloc(sizeof(*type));
-    *type = NEVER_REMOVE_ON_COLLISION;
-    Body *body = body_init_with_info(gravity_ball, M, BLACK, type, free);
-
-    // Move a distance R below the scene
-    Vector gravity_center = {.x = LENGTH_AND_HEIGHT.x/2, .y = -R};
-    body_set_centroid(body, gravity_center);
-    scene_add_body(scene, body);
+    AdditionalInfo* info = get_additional_info(game_info);
+    info->arrow = scene_spawn_body(scene, points, DEFAULT_MASS, ORANGE, \
+        new_role(scene, BULLET), arena_release);
+    body_set_gravity_scale(scene_get_body_by_handle(scene, info->arrow), 0);
+    body_set_rotation_custom(scene_get_body_by_handle(scene, info->arrow), \
+        angle, arrow_pivot);
 }
 
 void spawn_wall(GameInfo* game_info) {
     Scene* scene = get_scene(game_info);
     List* points = get_rectangle((Vector){-150, 0}, \
      15, 100);
-    Role *type = malloc(sizeof(Role));
-    assert(type);
-    *type = NEVER_REMOVE_ON_COLLISION;
-    Body* wall = body_init_with_info(points, INFINITY, BLACK, type, free);
-    scene_add_body(scene, wall);
+    AdditionalInfo* info = get_additional_info(game_info);
+    info->wall = scene_spawn_body(scene, points, INFINITY, BLACK, \
+        new_role(scene, NEVER_REMOVE_ON_COLLISION), arena_release);
+    body_set_type(scene_get_body_by_handle(scene, info->wall), BODY_STATIC);
 }
 
 Body* spawn_dart(GameInfo *game_info) {
@@ -172,20 +184,18 @@ Body* spawn_dart(GameInfo *game_info) {
     Vector offset = (Vector){45, -43};
     Vector center = vec_add(ARCHER_POSITION, offset);
     List* dart_pts = get_dart_points(center, DART_LENGTH, DART_THICKNESS);
-    Role *type = malloc(sizeof(Role));
-    assert(type);
-    *type = PLAYER;
-    Body* dart = body_init_with_info(dart_pts, DART_MASS, BLACK, type, free);
-
-    /*
-     * Now, we have to add the gravity force to the ball. We know that the
-     * gravity body was instantiated after POWER_DIVISIONS bodies, followed by
-     * a single arrow body.
-     */
-    Body* gravity_body = scene_get_body(scene, POWER_DIVISIONS + 1);
-    assert(body_get_role(gravity_body) == (Role) NEVER_REMOVE_ON_COLLISION);
-    create_newtonian_gravity(scene, G, gravity_body, dart);
-    scene_add_body(scene, dart);
+    AdditionalInfo* info = get_additional_info(game_info);
+    info->dart = scene_spawn_body(scene, dart_pts, DART_MASS, BLACK, \
+        new_role(scene, PLAYER), arena_release);
+    Body* dart = scene_get_body_by_handle(scene, info->dart);
+
+    // Pop balloons the dart hits, and stop it at the wall if there is one
+    for (size_t i = 0; i < scene_bodies(scene); i++) {
+        Body *body = scene_get_body(scene, i);
+        if (is_balloon(body) || body_get_handle(body) == info->wall) {
+            create_destructive_collision(scene, body, dart);
+        }
+    }
     return dart;
 }
 
@@ -203,7 +213,7 @@ void on_key(char key, KeyEventType type, double held_time, void* info) {
     GameInfo* game_info = info;
     AdditionalInfo* i = get_additional_info(game_info);
     Scene* scene = get_scene(game_info);
-    Body* arrow = scene_get_body(scene, POWER_DIVISIONS);
+    Body* arrow = scene_get_body_by_handle(scene, i->arrow);
     List* points = body_get_shape(arrow);
     Vector arrow_pivot = vec_multiply(0.5, \
         vec_add(*((Vector*)list_get(points, 0)), *((Vector*)list_get(points, 1))));
@@ -220,7 +230,7 @@ void on_key(char key, KeyEventType type, double held_time, void* info) {
                 break;
             case ' ':
             {
-              if (no_darts_on_screen(scene)) {
+              if (no_darts_on_screen(game_info)) {
                   double power = i->power;
                   Body* dart = spawn_dart(game_info);
                   Vector dart_velocity = (Vector){MAX_DART_VELOCITY * cos(angle), MAX_DART_VELOCITY * sin(angle)};
@@ -247,7 +257,7 @@ void on_key(char key, KeyEventType type, double held_time, void* info) {
                 break;
             case ' ':
             {
-                if (no_darts_on_screen(scene)) {
+                if (no_darts_on_screen(game_info)) {
                     double new_power;
                     double modulus_time = (held_time - ((int) held_time / (int) POWER_BAR_TIME) * POWER_BAR_TIME);
                     if (((int) held_time / (int) POWER_BAR_TIME) % 2 == 1) {
@@ -264,9 +274,34 @@ void on_key(char key, KeyEventType type, double held_time, void* info) {
     }
 }
 
-void spawn_balloons_l1(GameInfo* game_info) {
+/** Spawns a balloon at each transform, each with a random color */
+void spawn_balloons(GameInfo* game_info, Transform *transforms, size_t count) {
     Scene *scene = get_scene(game_info);
+    AdditionalInfo* info = get_additional_info(game_info);
     const RGBColor RAINBOW_COLORS[7] = {RED, ORANGE, YELLOW, GREEN, BLUE, INDIGO, VIOLET};
+    BodyHandle handles[count];
+    scene_spawn_many(scene, info->balloon_prefab, transforms, count, INFINITY, \
+        BLACK, handles);
+    for (size_t i = 0; i < count; i++) {
+        Body *balloon = scene_get_body_by_handle(scene, handles[i]);
+        body_set_type(balloon, BODY_STATIC);
+        body_set_role(balloon, REMOVE_ON_COLLISION);
+        int color = pseudo_rand_int(0,6);
+        body_set_color(balloon, RAINBOW_COLORS[color]);
+    }
+}
+
+/** Gets where to place a balloon built around the given center */
+Transform balloon_transform(GameInfo* game_info, Vector balloon_center) {
+    AdditionalInfo* info = get_additional_info(game_info);
+    Vector position = vec_add(balloon_center, \
+        prefab_get_centroid(info->balloon_prefab));
+    return (Transform) {position, 0};
+}
+
+void spawn_balloons_l1(GameInfo* game_info) {
+    Transform transforms[NUM_ROWS1 * NUM_COLS1];
+    size_t count = 0;
     Vector top_left = (Vector){-(NUM_COLS1 + (GAP + BALLOON_WIDTH) * NUM_COLS1) / 2, (BUFFER + NUM_ROWS1 + (GAP + BALLOON_HEIGHT) * NUM_ROWS1)/ 2};
 
     for (size_t i = 0; i < NUM_ROWS1; i++) {
@@ -275,21 +310,16 @@ void spawn_balloons_l1(GameInfo* game_info) {
             Vector balloon_center = (Vector){GAP + top_left.x + \
                 (BALLOON_WIDTH + GAP) * j + BALLOON_WIDTH / 2, y_coord};
             if ((i != 0 && i != NUM_ROWS1 - 1) || (j != 0 && j != NUM_COLS1 - 1) ) {
-            List* balloon_pts = get_bloon_points(balloon_center, BALLOON_WIDTH, BALLOON_HEIGHT);
-            Role *type = malloc(sizeof(Role));
-            assert(type);
-            *type = REMOVE_ON_COLLISION;
-            int color = pseudo_rand_int(0,6);
-            Body* balloon = body_init_with_info(balloon_pts, INFINITY, RAINBOW_COLORS[color], type, free);
-            scene_add_body(scene, balloon);
+            transforms[count++] = balloon_transform(game_info, balloon_center);
           }
         }
     }
+    spawn_balloons(game_info, transforms, count);
 }
 
 void spawn_balloons_l2(GameInfo* game_info) {
-    Scene *scene = get_scene(game_info);
-    const RGBColor RAINBOW_COLORS[7] = {RED, ORANGE, YELLOW, GREEN, BLUE, INDIGO, VIOLET};
+    Transform transforms[NUM_ROWS2 * NUM_COLS2];
+    size_t count = 0;
     Vector top_left = (Vector){-(NUM_COLS2 + (GAP + BALLOON_WIDTH) * NUM_COLS2) / 2, (BUFFER + NUM_ROWS2 + (GAP + BALLOON_HEIGHT) * NUM_ROWS2)/ 2};
 
     for (size_t i = 0; i < NUM_ROWS2; i++) {
@@ -298,22 +328,17 @@ void spawn_balloons_l2(GameInfo* game_info) {
             Vector balloon_center = (Vector){GAP + top_left.x + \
                 (BALLOON_WIDTH + GAP) * j + BALLOON_WIDTH / 2, y_coord};
             if (i != 3 && i != 4 && j != 3 && j != 4) {
-            List* balloon_pts = get_bloon_points(balloon_center, BALLOON_WIDTH, BALLOON_HEIGHT);
-            Role *type = malloc(sizeof(Role));
-            assert(type);
-            *type = REMOVE_ON_COLLISION;
-            int color = pseudo_rand_int(0,6);
-            Body* balloon = body_init_with_info(balloon_pts, INFINITY, RAINBOW_COLORS[color], type, free);
-            scene_add_body(scene, balloon);
+            transforms[count++] = balloon_transform(game_info, balloon_center);
           }
         }
     }
+    spawn_balloons(game_info, transforms, count);
 }
 
 void spawn_balloons_l3(GameInfo* game_info) {
-    Scene *scene = get_scene(game_info);
     spawn_wall(game_info);
-    const RGBColor RAINBOW_COLORS[7] = {RED, ORANGE, YELLOW, GREEN, BLUE, INDIGO, VIOLET};
+    Transform transforms[NUM_ROWS3 * NUM_COLS3];
+    size_t count = 0;
     Vector top_left = (Vector){-(NUM_COLS3 + (GAP + BALLOON_WIDTH) * NUM_COLS3) / 2, (BUFFER + NUM_ROWS3 + (GAP + BALLOON_HEIGHT) * NUM_ROWS3)/ 2};
 
     for (size_t i = 0; i < NUM_ROWS3; i++) {
@@ -322,16 +347,11 @@ void spawn_balloons_l3(GameInfo* game_info) {
             Vector balloon_center = (Vector){GAP + top_left.x + \
                 (BALLOON_WIDTH + GAP) * j + BALLOON_WIDTH / 2, y_coord};
             if ((i != 0 && i != NUM_ROWS3 - 1) || (j != 0 && j != NUM_COLS3 - 1) ) {
-            List* balloon_pts = get_bloon_points(balloon_center, BALLOON_WIDTH, BALLOON_HEIGHT);
-            Role *type = malloc(sizeof(Role));
-            assert(type);
-            *type = REMOVE_ON_COLLISION;
-            int color = pseudo_rand_int(0,6);
-            Body* balloon = body_init_with_info(balloon_pts, INFINITY, RAINBOW_COLORS[color], type, free);
-            scene_add_body(scene, balloon);
+            transforms[count++] = balloon_transform(game_info, balloon_center);
           }
         }
     }
+    spawn_balloons(game_info, transforms, count);
 }
 
 void spawn_sprite(GameInfo* game_info, char* filename, Vector position, int width,
@@ -349,36 +369,37 @@ void spawn_text(GameInfo* game_info, char* t, Vector position, RGBColor color, \
 GameInfo* setup_game(void) {
     initialize_window(LENGTH_AND_HEIGHT);
     Scene* scene = initialize_scene();
+    // Bodies move under both their forces and their own acceleration
+    scene_set_default_motion(scene, MOTION_FORCES | MOTION_ACCELERATION);
+    // Only the dart is dropped by gravity; it persists across scene_reset()
+    scene_set_gravity(scene, (Vector) {0, -g});
     AdditionalInfo* info = malloc(sizeof(AdditionalInfo));
     assert(info);
+    info->balloon_prefab = prefab_init(
+        get_bloon_points(VEC_ZERO, BALLOON_WIDTH, BALLOON_HEIGHT));
+    info->bar_prefab = prefab_init(
+        get_rectangle(VEC_ZERO, OUTER_BAR_WIDTH / POWER_DIVISIONS, BAR_HEIGHT));
+    // Everything in a level comes from the scene's arena, so it can be reset
+    utils_set_shape_allocator(arena_allocator(scene_get_arena(scene)));
     info->power = 0;
     info->level = 1;
     info->dartsLeft = 5;
     info->target = 15;
+    info->arrow = BODY_HANDLE_NULL;
+    info->wall = BODY_HANDLE_NULL;
+    info->dart = BODY_HANDLE_NULL;
     GameInfo* game_info = game_info_init(scene, info, free_additional_info);
     return game_info;
 }
 
-void clear_balloons(GameInfo* game_info) {
-    Scene *scene = get_scene(game_info);
-
-    for (size_t i = BALLOON_IDX_START-1; i < scene_bodies(scene); i++) {
-        Body* body = scene_get_body(scene, i);
-
-        if (body_get_role(body) == REMOVE_ON_COLLISION) {
-            body_remove(body);
-        }
-    }
-}
-
 int balloons_left(GameInfo* game_info) {
     Scene *scene = get_scene(game_info);
     size_t count = 0;
 
-    for (size_t i = BALLOON_IDX_START; i < scene_bodies(scene); i++) {
+    for (size_t i = 0; i < scene_bodies(scene); i++) {
         Body* body = scene_get_body(scene, i);
 
-        if (body_get_role(body) == REMOVE_ON_COLLISION) {
+        if (is_balloon(body) && !body_is_removed(body)) {
             count++;
         }
     }
@@ -386,20 +407,10 @@ int balloons_left(GameInfo* game_info) {
     return count;
 }
 
-void destroy_balloons(Scene *scene, Body* dart, GameInfo* game_info) {
-    int left = balloons_left(game_info);
-
-    for (size_t i = BALLOON_IDX_START; i < BALLOON_IDX_START+left+1; i++) {
-        Body *curr_body = scene_get_body(scene, i);
-        create_destructive_collision(scene, curr_body, dart);
-    }
-}
-
 int restart(GameInfo* game_info) {
     AdditionalInfo* info = get_additional_info(game_info);
-    Scene *scene = get_scene(game_info);
 
-    if ((info->dartsLeft == 0) && (balloons_left(game_info) > info->target) && (no_darts_on_screen(scene)))  {
+    if ((info->dartsLeft == 0) && (balloons_left(game_info) > info->target) && (no_darts_on_screen(game_info)))  {
         return 1;
     } else {
         return 0;
@@ -407,31 +418,40 @@ int restart(GameInfo* game_info) {
 }
 
 int level_completed(GameInfo* game_info) {
-    Scene *scene = get_scene(game_info);
     AdditionalInfo* info = get_additional_info(game_info);
 
-    if ((info->dartsLeft == 0) && (balloons_left(game_info) <= info->target) && (no_darts_on_screen(scene))) {
+    if ((info->dartsLeft == 0) && (balloons_left(game_info) <= info->target) && (no_darts_on_screen(game_info))) {
         return 1;
     } else {
         return 0;
     }
 }
 
-void destroy_bullet(Scene *scene) {
-    for (size_t i = BALLOON_IDX_START - 3; i < scene_bodies(scene); i++) {
-        Body *body = scene_get_body(scene, i);
-        if (body_get_role(body) == PLAYER) {
-            if (body_get_centroid(body).y + DART_LENGTH < (LENGTH_AND_HEIGHT.y * -0.5) || fabs(body_get_centroid(body).x + DART_LENGTH) > (LENGTH_AND_HEIGHT.x * 0.5)) {
-                body_remove(body);
-            }
+void destroy_bullet(GameInfo* game_info) {
+    AdditionalInfo* info = get_additional_info(game_info);
+    Body *body = scene_get_body_by_handle(get_scene(game_info), info->dart);
+    if (body) {
+        if (body_get_centroid(body).y + DART_LENGTH < (LENGTH_AND_HEIGHT.y * -0.5) || fabs(body_get_centroid(body).x + DART_LENGTH) > (LENGTH_AND_HEIGHT.x * 0.5)) {
+            body_remove(body);
         }
     }
 }
 
+/** Drops everything in the scene and rebuilds it for the current level */
 void load_level(GameInfo* game_info) {
+    Scene *scene = get_scene(game_info);
     AdditionalInfo* info = get_additional_info(game_info);
     info->dartsLeft = 5;
-    clear_balloons(game_info);
+    // Keep the player's aim across levels
+    Body *arrow = scene_get_body_by_handle(scene, info->arrow);
+    double angle = arrow ? body_get_angle(arrow) : 0;
+
+    scene_reset(scene);
+    info->wall = BODY_HANDLE_NULL;
+    info->dart = BODY_HANDLE_NULL;
+    initialize_power_bars(game_info);
+    update_power_bars(game_info);
+    spawn_arrow(game_info, angle);
 
     if (info->level == 1) {
         spawn_balloons_l1(game_info);
@@ -448,11 +468,6 @@ int main(int argc, char* argv[]) {
     GameInfo* game_info = setup_game();
     double dt;
     double time_elapsed = 0;
-    /* The ordering of initialization is very important because we use the
-     * ordering to determine which index a certain body of the scene is at. */
-    initialize_power_bars(game_info);
-    spawn_arrow(game_info);
-    spawn_gravity_body(game_info);
     load_level(game_info);
     spawn_sprite(game_info, PLAYER_SPRITE_PATH, ARCHER_POSITION, ARCHER_WIDTH, \
         ARCHER_HEIGHT);
@@ -473,13 +488,8 @@ int main(int argc, char* argv[]) {
         time_elapsed += dt;
         // Multiply by constant to speed up physics
         scene_tick(scene, 3 * dt);
-        scene_tick_no_forces(scene, 3 * dt);
 
-        if (!no_darts_on_screen(scene)) {
-            Body* dart = scene_get_body(scene, scene_bodies(scene) - 1);
-            destroy_balloons(scene, dart, game_info);
-            destroy_bullet(scene);
-        }
+        destroy_bullet(game_info);
 
         sdl_render_game(game_info);
 
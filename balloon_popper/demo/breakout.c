@@ -35,6 +35,9 @@ const Vector BALL_VELOCITY = {200, 200};
 const Vector PLAYER_VELOCITY = {500, 0};
 const double BALL_RADIUS = 20;
 const double BALL_MASS = 20;
+// The player and ball are found by handle, since removals shift scene indices
+BodyHandle player_handle = BODY_HANDLE_NULL;
+BodyHandle ball_handle = BODY_HANDLE_NULL;
 
 void spawn_blocks(Scene *scene) {
     const RGBColor RAINBOW_COLORS[7] = {RED, ORANGE, YELLOW, GREEN, BLUE, INDIGO, VIOLET};
@@ -54,9 +57,9 @@ void spawn_blocks(Scene *scene) {
             else {
               *type = REMOVE_ON_COLLISION;
             }
-            Body* block = body_init_with_info(block_pts, INFINITY, RAINBOW_COLORS[j], type, free);
-            body_set_velocity(block, VEC_ZERO);
-            scene_add_body(scene, block);
+            BodyHandle block = scene_spawn_body(scene, block_pts, INFINITY, \
+                RAINBOW_COLORS[j], type, free);
+            body_set_type(scene_get_body_by_handle(scene, block), BODY_STATIC);
         }
     }
 }
@@ -65,8 +68,12 @@ void spawn_blocks(Scene *scene) {
  * Deletes all enemy blocks from the scene
  */
 void delete_blocks(Scene *scene) {
-  for (size_t i = 2; i < scene_bodies(scene); i++) {
-      body_remove(scene_get_body(scene, i));
+  for (size_t i = 0; i < scene_bodies(scene); i++) {
+      Body *body = scene_get_body(scene, i);
+      BodyHandle handle = body_get_handle(body);
+      if (handle != player_handle && handle != ball_handle) {
+          body_remove(body);
+      }
   }
 }
 
@@ -81,9 +88,12 @@ void spawn_ball(Scene *scene) {
     Role *type = malloc(sizeof(Role));
     assert(type);
     *type = BULLET;
-    Body* ball = body_init_with_info(ball_pts, BALL_MASS, RED, type, free);
+    ball_handle = scene_spawn_body(scene, ball_pts, BALL_MASS, RED, type, free);
+    Body *ball = scene_get_body_by_handle(scene, ball_handle);
     body_set_velocity(ball, BALL_VELOCITY);
-    scene_add_body(scene, ball);
+    // Check the ball against the blocks every half radius it moves,
+    // so a long frame cannot carry it through one
+    body_set_max_displacement(ball, BALL_RADIUS / 2);
 }
 
 void spawn_player(Scene *scene) {
@@ -93,20 +103,27 @@ void spawn_player(Scene *scene) {
     Role *type = malloc(sizeof(Role));
     assert(type);
     *type = PLAYER;
-    Body* player = body_init_with_info(player_pts, INFINITY, RED, type, free);
-    // Player will start out stationary
+    player_handle = scene_spawn_body(scene, player_pts, INFINITY, RED, type, free);
+    // The player moves only at the velocity the keys give it,
+    // and starts out stationary
+    Body *player = scene_get_body_by_handle(scene, player_handle);
+    body_set_type(player, BODY_KINEMATIC);
     body_set_velocity(player, VEC_ZERO);
-    scene_add_body(scene, player);
 }
 
 /**
  * Spawns destructive forces between ball and enemy blocks
- * @param scene    the scene
- * @param ball   the ball
+ * @param scene             the scene
+ * @param ball              the ball
+ * @param include_player    whether to also bounce the ball off the player
  */
-void spawn_physics_collisions(Scene* scene, Body* ball, size_t idx_start) {
-    for (size_t i = idx_start; i < scene_bodies(scene); i++) {
+void spawn_physics_collisions(Scene* scene, Body* ball, bool include_player) {
+    for (size_t i = 0; i < scene_bodies(scene); i++) {
         Body *curr_body = scene_get_body(scene, i);
+        if (body_is_removed(curr_body) || (!include_player && \
+            body_get_handle(curr_body) == player_handle)) {
+            continue;
+        }
         if (body_get_role(curr_body) != BULLET) {
           create_physics_collision(scene, ELASTICITY.y, ball, curr_body);
         }
@@ -129,7 +146,7 @@ void restart_game(Scene *scene, Body *player, Body *ball) {
     body_set_velocity(ball, BALL_VELOCITY);
     delete_blocks(scene);
     spawn_blocks(scene);
-    spawn_physics_collisions(scene, ball, 2);
+    spawn_physics_collisions(scene, ball, false);
     body_set_velocity(player, VEC_ZERO);
 }
 
@@ -151,8 +168,8 @@ bool game_is_over(Scene *scene) {
 * If the ball hits the bottom wall then we will have to restart the game
 */
 void check_corner_bounds(Scene* scene) {
-        Body *player = scene_get_body(scene, 0);
-        Body *ball = scene_get_body(scene, 1);
+        Body *player = scene_get_body_by_handle(scene, player_handle);
+        Body *ball = scene_get_body_by_handle(scene, ball_handle);
         check_out_of_bounds(ball, vec_multiply(-0.5, LENGTH_AND_HEIGHT), \
             true, double_less_then, ELASTICITY);
         check_out_of_bounds(ball, vec_multiply(0.5, LENGTH_AND_HEIGHT), \
@@ -170,7 +187,7 @@ void check_corner_bounds(Scene* scene) {
  * @param scene the scene
  */
 void keep_player_bounds(Scene* scene) {
-    Body *player = scene_get_body(scene, 0);
+    Body *player = scene_get_body_by_handle(scene, player_handle);
     int wall_hit = which_wall_hit(player, LENGTH_AND_HEIGHT, false);
     if (wall_hit == RIGHT_WALL || wall_hit == LEFT_WALL) {
         body_set_velocity(player, VEC_ZERO);
@@ -188,7 +205,7 @@ void keep_player_bounds(Scene* scene) {
  */
 void on_key(char key, KeyEventType type, double held_time, void* info) {
     GameInfo* i = info;
-    Body *player = scene_get_body(i->scene, 0);
+    Body *player = scene_get_body_by_handle(i->scene, player_handle);
     int wall_hit = which_wall_hit(player, LENGTH_AND_HEIGHT, false);
     if (type == KEY_RELEASED) {
         body_set_velocity(player, VEC_ZERO);
@@ -212,10 +229,13 @@ void on_key(char key, KeyEventType type, double held_time, void* info) {
 int main(int argc, char* argv[]) {
     initialize_window(LENGTH_AND_HEIGHT);
     Scene* scene = initialize_scene();
+    // Bodies move under both their forces and their own acceleration
+    scene_set_default_motion(scene, MOTION_FORCES | MOTION_ACCELERATION);
     spawn_player(scene);
     spawn_ball(scene);
     spawn_blocks(scene);
-    spawn_physics_collisions(scene, scene_get_body(scene, 1), 0);
+    spawn_physics_collisions(scene, scene_get_body_by_handle(scene, ball_handle), \
+        true);
     GameInfo* gameInfo = malloc(sizeof(GameInfo));
     assert(gameInfo);
     gameInfo->scene = scene;
@@ -224,10 +244,10 @@ int main(int argc, char* argv[]) {
 
     while (!sdl_is_done() && !game_is_over(scene)) {
         dt = time_since_last_tick();
-        body_set_time_since_last_collision(scene_get_body(scene, 1), \
-            body_get_time_since_last_collision(scene_get_body(scene, 1)) + dt);
+        Body *ball = scene_get_body_by_handle(scene, ball_handle);
+        body_set_time_since_last_collision(ball, \
+            body_get_time_since_last_collision(ball) + dt);
         scene_tick(scene, dt);
-        scene_tick_no_forces(scene, dt);
         keep_player_bounds(scene);
         check_corner_bounds(scene);
         sdl_render_scene(scene);
@@ -20,6 +20,8 @@
 #define PEG_RADIUS 0.5
 #define BALL_RADIUS 1.0
 #define DROP_INTERVAL 1.0 // s
+#define PHYSICS_STEP (1.0 / 240) // s
+#define MAX_SUBSTEPS 16
 #define ELASTICITY 0.3
 #define WALL_WIDTH 1.0
 #define DELTA_X 1.0
@@ -32,20 +34,16 @@
 #define PEG_COLOR ((RGBColor) {0, 1, 0})
 #define WALL_COLOR ((RGBColor) {0, 0, 1})
 
-#define G 6.67E-11 // N m^2 / kg^2
-#define M 6E24 // kg
 #define g 9.8 // m / s^2
-#define R (sqrt(G * M / g)) // m
 
 typedef enum {
     BALL,
     FROZEN,
-    WALL, // or peg
-    GRAVITY
-} BodyType;
+    WALL // or peg
+} ObjectType;
 
-BodyType get_type(Body *body) {
-    return *(BodyType *) body_get_info(body);
+ObjectType get_type(Body *body) {
+    return *(ObjectType *) body_get_info(body);
 }
 
 /** Generates a random number between 0 and 1 */
@@ -96,25 +94,10 @@ Vector get_peg_center(int row, int col) {
     return center;
 }
 
-/** Creates an Earth-like mass to accelerate the balls */
-Body *get_gravity_body() {
-    // Will be offscreen, so shape is irrelevant
-    List *gravity_ball = rect_init(1, 1);
-    BodyType *type = malloc(sizeof(*type));
-    *type = GRAVITY;
-    Body *body = body_init_with_info(gravity_ball, M, WALL_COLOR, type, free);
-
-    // Move a distnace R below the scene
-    Vector gravity_center = {.x = MAX.x / 2, .y = -R};
-    body_set_centroid(body, gravity_center);
-
-    return body;
-}
-
 /** Creates a ball with the given starting position and velocity */
 Body *get_ball(Vector center, Vector velocity) {
     List *shape = circle_init(BALL_RADIUS);
-    BodyType *info = malloc(sizeof(*info));
+    ObjectType *info = malloc(sizeof(*info));
     *info = BALL;
     Body *ball = body_init_with_info(shape, BALL_MASS, BALL_COLOR, info, free);
 
@@ -132,20 +115,21 @@ void freeze(Body *ball, Body *target, Vector axis, void *aux) {
     // Replace the ball with a frozen version
     Scene *scene = (Scene *) aux;
     Body *frozen = get_ball(body_get_centroid(ball), VEC_ZERO);
-    *((BodyType *) body_get_info(frozen)) = FROZEN;
+    *((ObjectType *) body_get_info(frozen)) = FROZEN;
+    body_set_type(frozen, BODY_STATIC);
     scene_add_body(scene, frozen);
     // Make other falling bodies freeze when they collide with this body
     size_t body_count = scene_bodies(scene);
     for (size_t i = 0; i < body_count; i++) {
         Body *body = scene_get_body(scene, i);
         if (get_type(body) == BALL && body != ball) {
-            create_collision(scene, body, ball, freeze, scene, NULL);
+            create_collision(scene, body, frozen, freeze, scene, NULL);
         }
     }
 }
 
 /** Adds a ball to the scene */
-void add_ball(Scene *scene, Body *gravity_body, List *obstacles) {
+void add_ball(Scene *scene, List *obstacles) {
     // Add the ball to the scene.
     Vector ball_center = {
         .x = MAX.x / 2 + (rand_double() - 0.5) * DELTA_X,
@@ -154,9 +138,6 @@ void add_ball(Scene *scene, Body *gravity_body, List *obstacles) {
     Body *ball = get_ball(ball_center, START_VELOCITY);
     scene_add_body(scene, ball);
 
-    // Simulate earth's gravity acting on the ball.
-    create_newtonian_gravity(scene, G, gravity_body, ball);
-
     // Add collisions between all bodies
     size_t obstacle_count = list_size(obstacles);
     for (size_t i = 0; i < obstacle_count; i++) {
@@ -182,10 +163,11 @@ List *add_obstacles(Scene *scene){
     for (int i = 1; i <= N_ROWS; i++) {
         for (int j = 0; j <= i; j++) {
             List *polygon = circle_init(PEG_RADIUS);
-            BodyType *type = malloc(sizeof(*type));
+            ObjectType *type = malloc(sizeof(*type));
             *type = WALL;
             Body *body =
                 body_init_with_info(polygon, INFINITY, PEG_COLOR, type, free);
+            body_set_type(body, BODY_STATIC);
             body_set_centroid(body, get_peg_center(i, j));
             scene_add_body(scene, body);
             list_add(obstacles, body);
@@ -196,9 +178,10 @@ List *add_obstacles(Scene *scene){
     List *rect = rect_init(WALL_LENGTH, WALL_WIDTH);
     polygon_translate(rect, (Vector) {.x = WALL_LENGTH / 2, .y = 0.0});
     polygon_rotate(rect, WALL_ANGLE, VEC_ZERO);
-    BodyType *type = malloc(sizeof(*type));
+    ObjectType *type = malloc(sizeof(*type));
     *type = WALL;
     Body *body = body_init_with_info(rect, INFINITY, WALL_COLOR, type, free);
+    body_set_type(body, BODY_STATIC);
     scene_add_body(scene, body);
     list_add(obstacles, body);
 
@@ -208,6 +191,7 @@ List *add_obstacles(Scene *scene){
     type = malloc(sizeof(*type));
     *type = WALL;
     body = body_init_with_info(rect, INFINITY, WALL_COLOR, type, free);
+    body_set_type(body, BODY_STATIC);
     scene_add_body(scene, body);
     list_add(obstacles, body);
 
@@ -216,6 +200,7 @@ List *add_obstacles(Scene *scene){
     type = malloc(sizeof(*type));
     *type = FROZEN;
     body = body_init_with_info(rect, INFINITY, WALL_COLOR, type, free);
+    body_set_type(body, BODY_STATIC);
     body_set_centroid(body, (Vector) {.x = MAX.x / 2, .y = WALL_WIDTH / 2});
     scene_add_body(scene, body);
 
@@ -229,15 +214,14 @@ int main(int argc, char **argv){
     // Initialize scene
     sdl_init(VEC_ZERO, MAX);
     Scene *scene = scene_init();
+    // Simulate earth's gravity acting on the balls
+    scene_set_gravity(scene, (Vector) {0, -g});
 
-    // Add the gravity body to the scene
-    Body *gravity_body = get_gravity_body();
     // Add pegs and walls
     List *obstacles = add_obstacles(scene);
-    //add_ball(scene, gravity_body, obstacles);
-    scene_add_body(scene, gravity_body);
 
-    // Repeatedly render scene
+    // Repeatedly render scene, running the physics at a fixed rate
+    GameLoop *loop = game_loop_init(PHYSICS_STEP, MAX_SUBSTEPS);
     double time_since_drop = INFINITY;
     while (!sdl_is_done()){
         double dt = time_since_last_tick();
@@ -245,15 +229,16 @@ int main(int argc, char **argv){
         // Add a new ball every DROP_INTERVAL seconds
         time_since_drop += dt;
         if (time_since_drop > DROP_INTERVAL) {
-            add_ball(scene, gravity_body, obstacles);
+            add_ball(scene, obstacles);
             time_since_drop = 0.0;
         }
 
-        scene_tick(scene, dt);
-        sdl_render_scene(scene);
+        game_loop_tick_scene(loop, scene, dt);
+        sdl_render_scene_interpolated(scene, loop);
     }
 
     // Clean up scene
+    game_loop_free(loop);
     scene_free(scene);
     // list_free(obstacles);
     return 0;
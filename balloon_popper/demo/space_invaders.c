@@ -31,6 +31,8 @@ const double PLAYER_WIDTH = 80;
 const double BULLET_HEIGHT = 15;
 const double BULLET_WIDTH = 3;
 const double SPAWN_INTERVAL = 1;
+// The player is found by handle, since removals shift scene indices
+BodyHandle player_handle = BODY_HANDLE_NULL;
 
 /**
  * Spawns invaders onto the scene
@@ -49,9 +51,10 @@ void spawn_invaders(Scene *scene) {
             Role *type = malloc(sizeof(Role));
             assert(type);
             *type = ENEMY;
-            Body* invader = body_init_with_info(invader_pts, DEFAULT_MASS, GRAY, type, free);
-            body_set_velocity(invader, INVADER_VELOCITY);
-            scene_add_body(scene, invader);
+            BodyHandle invader = scene_spawn_body(scene, invader_pts, \
+                DEFAULT_MASS, GRAY, type, free);
+            body_set_velocity(scene_get_body_by_handle(scene, invader), \
+                INVADER_VELOCITY);
         }
     }
 }
@@ -61,7 +64,10 @@ void spawn_invaders(Scene *scene) {
  * @param scene the scene
  */
 void keep_player_bounds(Scene* scene) {
-    Body *player = scene_get_body(scene, 0);
+    Body *player = scene_get_body_by_handle(scene, player_handle);
+    if (!player) {
+        return;
+    }
     int wall_hit = which_wall_hit(player, LENGTH_AND_HEIGHT, false);
     if (wall_hit == RIGHT_WALL || wall_hit == LEFT_WALL) {
         body_set_velocity(player, VEC_ZERO);
@@ -85,7 +91,7 @@ void shift_invaders_down(Body *body) {
  * @param dt    the amount of time
  */
 void move_invaders(Scene *scene, double dt) {
-    for (size_t i = 1; i < scene_bodies(scene); i++) {
+    for (size_t i = 0; i < scene_bodies(scene); i++) {
         Body *curr_body = scene_get_body(scene, i);
         if (body_get_role(curr_body) == ENEMY) {
             if(check_out_of_bounds(curr_body, vec_multiply(0.5, LENGTH_AND_HEIGHT), \
@@ -105,11 +111,11 @@ void move_invaders(Scene *scene, double dt) {
  * @param bullet   the bullet
  */
 void spawn_destructive_force(Scene* scene, bool is_alien, Body* bullet) {
-    Body* player = scene_get_body(scene, 0);
+    Body* player = scene_get_body_by_handle(scene, player_handle);
     if (is_alien) {
         create_destructive_collision(scene, bullet, player);
     } else {
-        for (size_t i = 1; i < scene_bodies(scene); i++) {
+        for (size_t i = 0; i < scene_bodies(scene); i++) {
             Body *curr_body = scene_get_body(scene, i);
             if (body_get_role(curr_body) == ENEMY) {
                 create_destructive_collision(scene, bullet, curr_body);
@@ -124,7 +130,7 @@ void spawn_destructive_force(Scene* scene, bool is_alien, Body* bullet) {
  * @param is_alien whether to spawn a bullet from an alien or not
  */
 void spawn_bullet(Scene *scene, bool is_alien) {
-    Body *player_body = scene_get_body(scene, 0);
+    Body *player_body = scene_get_body_by_handle(scene, player_handle);
     Role *type = malloc(sizeof(Role));
     assert(type);
     *type = BULLET;
@@ -132,7 +138,7 @@ void spawn_bullet(Scene *scene, bool is_alien) {
     if (is_alien) {
         double smallest_dist = LENGTH_AND_HEIGHT.x;
         Body *closest_body;
-        for (size_t i = 1; i < scene_bodies(scene); i++) {
+        for (size_t i = 0; i < scene_bodies(scene); i++) {
             Body *curr_body = scene_get_body(scene, i);
             if (body_get_role(curr_body) == ENEMY) {
                 if (fabs(body_get_centroid(curr_body).x - \
@@ -158,6 +164,8 @@ void spawn_bullet(Scene *scene, bool is_alien) {
         bullet = body_init_with_info(points, DEFAULT_MASS, GREEN, type, free);
         body_set_velocity(bullet, vec_multiply(-1, BULLET_VELOCITY));
     }
+    // Bullets are thin, so they are checked every half their length
+    body_set_max_displacement(bullet, BULLET_HEIGHT / 2);
     spawn_destructive_force(scene, is_alien, bullet);
     scene_add_body(scene, bullet);
 }
@@ -172,7 +180,10 @@ void spawn_bullet(Scene *scene, bool is_alien) {
  */
 void on_key(char key, KeyEventType type, double held_time, void* info) {
     GameInfo* i = info;
-    Body *player = scene_get_body(i->scene, 0);
+    Body *player = scene_get_body_by_handle(i->scene, player_handle);
+    if (!player || body_is_removed(player)) {
+        return;
+    }
     int wall_hit = which_wall_hit(player, LENGTH_AND_HEIGHT, false);
     if (type == KEY_RELEASED) {
         body_set_velocity(player, VEC_ZERO);
@@ -204,10 +215,9 @@ void spawn_player(Scene *scene) {
     Role *type = malloc(sizeof(Role));
     assert(type);
     *type = PLAYER;
-    Body* player = body_init_with_info(points, DEFAULT_MASS, GREEN, type, free);
+    player_handle = scene_spawn_body(scene, points, DEFAULT_MASS, GREEN, type, free);
     // Player starts out still
-    body_set_velocity(player, VEC_ZERO);
-    scene_add_body(scene, player);
+    body_set_velocity(scene_get_body_by_handle(scene, player_handle), VEC_ZERO);
 }
 
 /**
@@ -215,7 +225,7 @@ void spawn_player(Scene *scene) {
  * @param scene the scene
  */
 void destroy_bullet(Scene *scene) {
-    for (size_t i = 1; i < scene_bodies(scene); i++) {
+    for (size_t i = 0; i < scene_bodies(scene); i++) {
         Body *body = scene_get_body(scene, i);
         if (body_get_role(body) == BULLET) {
             if (fabs(body_get_centroid(body).y) > (LENGTH_AND_HEIGHT.y * 0.5)) {
@@ -239,13 +249,15 @@ void spawn_alien_bullet(double* time_since_last_spawn, Scene* scene) {
 
 
 int game_is_over(Scene *scene) {
-    if (body_get_role(scene_get_body(scene, 0)) != PLAYER) {
+    // A stale handle means the player was shot and freed
+    Body *player = scene_get_body_by_handle(scene, player_handle);
+    if (!player || body_is_removed(player)) {
         return 1;
     }
 
     int invader_count = 0;
 
-    for (size_t i = 1; i < scene_bodies(scene); i++) {
+    for (size_t i = 0; i < scene_bodies(scene); i++) {
         Body *curr_body = scene_get_body(scene, i);
         if (body_get_role(curr_body) == ENEMY) {
             if (body_get_centroid(curr_body).y - RADIUS_INVADERS < -LENGTH_AND_HEIGHT.y / 2) {
@@ -266,6 +278,8 @@ int game_is_over(Scene *scene) {
 int main(int argc, char* argv[]) {
     initialize_window(LENGTH_AND_HEIGHT);
     Scene* scene = initialize_scene();
+    // Bodies move under both their forces and their own acceleration
+    scene_set_default_motion(scene, MOTION_FORCES | MOTION_ACCELERATION);
     GameInfo* gameInfo = malloc(sizeof(GameInfo));
     assert(gameInfo);
     gameInfo->scene = scene;
@@ -284,7 +298,6 @@ int main(int argc, char* argv[]) {
         destroy_bullet(scene);
         move_invaders(scene, dt);
         scene_tick(scene, dt);
-        scene_tick_no_forces(scene, dt);
         keep_player_bounds(scene);
         sdl_render_scene(scene);
     }
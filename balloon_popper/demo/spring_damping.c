@@ -16,6 +16,8 @@ const double CIRCLE_RADIUS = 10.0;
 const RGBColor WHITE = (RGBColor) {1, 1, 1};
 const double SPRING_CONSTANT = 2;
 const double DRAG_COEFFICIENT = .3;
+const double PHYSICS_STEP = 1.0 / 120;
+const size_t MAX_SUBSTEPS = 8;
 
 /**
  * Initializes the scene. Adds Pacman and a preset number of pellets.
@@ -47,21 +49,25 @@ int main(int argc, char* argv[]) {
     sdl_init(bottom_left, top_right);
     Scene* scene = initialize_scene_spring();
 
+    // Integrated implicitly, so a stiffer SPRING_CONSTANT needs no smaller step
+    SpringNetwork *network = create_spring_network(scene);
     for (size_t i = 0; i < scene_bodies(scene); i += 2) {
         Body *body1 = scene_get_body(scene, i);
         Body *body2 = scene_get_body(scene, i+1);
-        create_spring(scene, SPRING_CONSTANT, body1, body2);
+        spring_network_add_spring(network, SPRING_CONSTANT, body1, body2);
 
         if (i < scene_bodies(scene) / 2) {
-            create_drag(scene, DRAG_COEFFICIENT, body2);
+            spring_network_add_drag(network, DRAG_COEFFICIENT, body2);
         }
     }
 
+    GameLoop *loop = game_loop_init(PHYSICS_STEP, MAX_SUBSTEPS);
     while (!sdl_is_done()) {
         double dt = time_since_last_tick();
 
-        scene_tick(scene, dt);
-        sdl_render_scene(scene);
+        game_loop_tick_scene(loop, scene, dt);
+        sdl_render_scene_interpolated(scene, loop);
     }
+    game_loop_free(loop);
     scene_free(scene);
 }
@@ -0,0 +1,89 @@
+#ifndef __ALLOCATOR_H__
+#define __ALLOCATOR_H__
+
+#include <stddef.h>
+
+/**
+ * A source of memory, e.g. the heap, an arena, a pool,
+ * or a wrapper that tracks how much memory is in use.
+ * Each function is passed the allocator's context as its first argument.
+ * The library allocates through allocator_global() unless it is given a
+ * specific allocator (see list_init_with_allocator() and
+ * scene_init_with_allocator()), so any of these can be used without
+ * changing the library.
+ */
+typedef struct allocator {
+    /** Gets a block of at least size bytes, like malloc() */
+    void *(*alloc)(void *context, size_t size);
+    /** Resizes a block from this allocator (or NULL), like realloc() */
+    void *(*realloc)(void *context, void *block, size_t size);
+    /** Returns a block from this allocator (or NULL), like free() */
+    void (*free)(void *context, void *block);
+    void *context;
+} Allocator;
+
+/**
+ * Gets the allocator that uses malloc(), realloc() and free().
+ *
+ * @return a pointer to the heap allocator
+ */
+const Allocator *allocator_heap(void);
+
+/**
+ * Gets the allocator the library uses when it is not given one.
+ * This is allocator_heap() unless allocator_set_global() has been called.
+ *
+ * @return a pointer to the global allocator
+ */
+const Allocator *allocator_global(void);
+
+/**
+ * Changes the allocator the library uses when it is not given one.
+ * Memory is freed with the allocator it came from, so this should be called
+ * before anything is allocated (or after everything has been freed).
+ * The allocator must stay valid until it is replaced.
+ *
+ * @param allocator the new global allocator, or NULL for allocator_heap()
+ */
+void allocator_set_global(const Allocator *allocator);
+
+/**
+ * Gets a block of memory from an allocator.
+ * Asserts that the memory was allocated.
+ *
+ * @param allocator a pointer to an allocator
+ * @param size the number of bytes needed
+ * @return a pointer to at least size bytes
+ */
+void *allocator_alloc(const Allocator *allocator, size_t size);
+
+/**
+ * Resizes a block of memory from an allocator.
+ * Asserts that the memory was allocated.
+ *
+ * @param allocator the allocator the block came from
+ * @param block a pointer returned from this allocator, or NULL
+ * @param size the number of bytes needed
+ * @return a block holding the first size bytes of the old block
+ */
+void *allocator_realloc(const Allocator *allocator, void *block, size_t size);
+
+/**
+ * Returns a block of memory to an allocator.
+ *
+ * @param allocator the allocator the block came from
+ * @param block a pointer returned from this allocator, or NULL
+ */
+void allocator_free(const Allocator *allocator, void *block);
+
+/**
+ * A FreeFunc for containers whose elements were allocated from the
+ * container's own allocator (see list_init_with_allocator()).
+ * The container passes those elements to its allocator's free function
+ * instead of calling this, so it must not be called directly.
+ *
+ * @param block an element of such a container
+ */
+void allocator_owned(void *block);
+
+#endif // #ifndef __ALLOCATOR_H__
@@ -0,0 +1,132 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "allocator.h"
+
+/**
+ * A region allocator.
+ * Blocks are carved out of large chunks, so allocating one is usually just
+ * popping a free list or bumping a pointer. Released blocks are kept for
+ * reuse by later allocations of a similar size.
+ * arena_reset() drops every block at once without visiting any of them,
+ * and keeps the chunks so the next round of allocations reuses them
+ * instead of going back to the heap.
+ */
+typedef struct arena Arena;
+
+/**
+ * Allocates memory for an empty arena.
+ * Asserts that the required memory was allocated.
+ *
+ * @param chunk_size the number of bytes to request from the heap at a time
+ * @return a pointer to the newly allocated arena
+ */
+Arena *arena_init(size_t chunk_size);
+
+/**
+ * Allocates memory for an empty arena whose chunks come from an allocator
+ * instead of allocator_global().
+ *
+ * @param allocator the allocator to get the arena and its chunks from
+ * @param chunk_size the number of bytes to request from it at a time
+ * @return a pointer to the newly allocated arena
+ */
+Arena *arena_init_with_allocator(
+    const Allocator *allocator, size_t chunk_size
+);
+
+/**
+ * Releases the memory allocated for an arena, including every block in it.
+ * Blocks still in use are not finalized in any way.
+ *
+ * @param arena a pointer to an arena returned from arena_init()
+ */
+void arena_free(Arena *arena);
+
+/**
+ * Gets a block of memory from an arena.
+ * The contents of the block are undefined.
+ *
+ * @param arena a pointer to an arena returned from arena_init()
+ * @param size the number of bytes needed, which must be positive
+ * @return a pointer to at least size bytes owned by the arena
+ */
+void *arena_alloc(Arena *arena, size_t size);
+
+/**
+ * Resizes a block allocated from an arena, like realloc().
+ *
+ * @param arena a pointer to an arena returned from arena_init()
+ * @param block a block from arena_alloc() on the same arena, or NULL
+ * @param size the number of bytes needed, which must be positive
+ * @return a block holding the first size bytes of the old block
+ */
+void *arena_realloc(Arena *arena, void *block, size_t size);
+
+/**
+ * Returns a block to the arena it was allocated from so it can be reused.
+ * Blocks record their arena, so this can be used as a FreeFunc.
+ *
+ * @param block a pointer returned from arena_alloc(), or NULL
+ */
+void arena_release(void *block);
+
+/**
+ * Gets the number of bytes of chunk space a new block of a given size uses,
+ * including the arena's bookkeeping.
+ *
+ * @param size the number of bytes that would be passed to arena_alloc()
+ * @return the space the block takes out of a chunk
+ */
+size_t arena_footprint(size_t size);
+
+/**
+ * Makes sure the next allocations totaling the given number of bytes
+ * (as measured by arena_footprint()) are carved from a single chunk,
+ * requesting at most one new chunk from the heap for all of them.
+ *
+ * @param arena a pointer to an arena returned from arena_init()
+ * @param bytes the total footprint of the upcoming allocations
+ */
+void arena_reserve(Arena *arena, size_t bytes);
+
+/**
+ * Releases every block allocated from an arena at once.
+ * Takes the same time no matter how many blocks are in use.
+ * All pointers into the arena become invalid.
+ *
+ * @param arena a pointer to an arena returned from arena_init()
+ */
+void arena_reset(Arena *arena);
+
+/**
+ * Returns whether a pointer points into memory owned by an arena.
+ *
+ * @param arena a pointer to an arena returned from arena_init()
+ * @param memory any pointer
+ * @return whether memory lies in one of the arena's chunks
+ */
+bool arena_contains(Arena *arena, const void *memory);
+
+/**
+ * Gets an allocator that allocates from an arena,
+ * e.g. to pass to list_init_with_allocator().
+ * Its free function is arena_release(). It is valid until arena_free().
+ *
+ * @param arena a pointer to an arena returned from arena_init()
+ * @return the arena's allocator
+ */
+const Allocator *arena_allocator(Arena *arena);
+
+/**
+ * Gets the number of chunks an arena has requested from the heap.
+ * This only grows, since chunks are kept until arena_free().
+ *
+ * @param arena a pointer to an arena returned from arena_init()
+ * @return the number of chunks the arena owns
+ */
+size_t arena_chunks(Arena *arena);
+
+#endif // #ifndef __ARENA_H__
@@ -2,6 +2,7 @@
 #define __BODY_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "color.h"
 #include "list.h"
 #include "vector.h"
@@ -20,6 +21,41 @@ typedef enum {
     NEVER_REMOVE_ON_COLLISION,
 } Role;
 
+/**
+ * How a body is moved each tick (see body_integrate()).
+ * The flags may be combined, in which case both updates are applied.
+ */
+typedef enum {
+    // Moved by the forces and impulses applied to it, like body_tick()
+    MOTION_FORCES = 1,
+    // Moved by its own velocity and acceleration, like body_tick_no_forces()
+    MOTION_ACCELERATION = 2,
+    // Split into substeps when it would move too far in one tick.
+    // Only body_set_max_displacement() sets or clears this flag.
+    MOTION_SUBSTEP = 4
+} MotionFlags;
+
+/**
+ * The most ticks body_update_sleep() can require a body to be at rest,
+ * since the count is stored in a byte.
+ */
+#define BODY_MAX_REST_TICKS 255
+
+/**
+ * Whether and how a body moves.
+ * DYNAMIC bodies move according to their motion flags.
+ * KINEMATIC bodies follow the velocity and acceleration they are given, as if
+ * they had only MOTION_ACCELERATION; forces and impulses do not move them.
+ * STATIC bodies never move and are skipped when the scene is ticked.
+ * Collision handlers treat kinematic and static bodies as infinitely massive,
+ * and collisions between two static bodies are never checked.
+ */
+typedef enum {
+    BODY_DYNAMIC,
+    BODY_KINEMATIC,
+    BODY_STATIC
+} BodyType;
+
 /**
  * Defines existence state of bodies.
  */
@@ -37,11 +73,61 @@ enum {
 typedef struct body Body;
 
 /**
- * Contains additional information for a body. For space invader, we have
- * two ints, one to represent the role (enemy or player), and one to represent
- * its state of removal (not removed, to be removed, or removed)
+ * A stable reference to a body owned by a scene.
+ * The low BODY_HANDLE_INDEX_BITS bits select one of the scene's body slots and
+ * the remaining bits hold that slot's generation, which changes every time the
+ * slot is reused. A handle to a body that has since been freed is therefore
+ * detected as stale instead of referring to whichever body took its slot.
+ * See scene_get_body_by_handle().
  */
-typedef struct bodyInfo BodyInfo;
+typedef uint32_t BodyHandle;
+
+/**
+ * A handle that never refers to a body.
+ * Bodies that have not been added to a scene have this handle.
+ */
+#define BODY_HANDLE_NULL 0
+#define BODY_HANDLE_INDEX_BITS 20
+
+/**
+ * Structure-of-arrays storage for the dynamic state of a group of bodies.
+ * Element i of every array belongs to bodies[i], so integrating the group is
+ * a single pass over a handful of contiguous arrays.
+ * While a body is attached, its position, velocity, forces and impulses live
+ * here; the body_get_*() and body_set_*() functions read and write these
+ * arrays, so callers do not need to know which storage a body uses.
+ * The inverse mass of a body with infinite mass is 0.
+ */
+typedef struct bodyArrays {
+    double *pos_x;
+    double *pos_y;
+    double *vel_x;
+    double *vel_y;
+    double *force_x;
+    double *force_y;
+    double *impulse_x;
+    double *impulse_y;
+    double *inv_mass;
+    // Each body's gravity scale (see body_set_gravity_scale())
+    double *gravity_scale;
+    Body **bodies;
+    size_t size;
+    size_t capacity;
+    const Allocator *allocator;
+} BodyArrays;
+
+/**
+ * Per-thread accumulators for the forces and impulses added to bodies,
+ * indexed by the slot in each body's handle (see BodyHandle).
+ * Lets force creators on different threads add to the same body without
+ * racing; the buffers are summed into the bodies afterwards.
+ */
+typedef struct forceBuffer {
+    Vector *forces;
+    Vector *impulses;
+    // One more than the highest slot index the buffer has room for
+    size_t size;
+} ForceBuffer;
 
 /**
  * Initializes a body without any info.
@@ -49,15 +135,10 @@ typedef struct bodyInfo BodyInfo;
  */
 Body *body_init(List *shape, double mass, RGBColor color);
 
-/**
- * Initalizes a body info struct
- * @param  role the role of the body (player, enemy, etc.)
- * @return      pointer to body info
- */
-BodyInfo* body_info_init(void *role);
 void body_rotate_with_velocity(Body* body);
 /**
- * Allocates memory for a body with the given parameters.
+ * Allocates memory for a body with the given parameters
+ * from allocator_global().
  * The body is initially at rest.
  * Asserts that the mass is positive and that the required memory is allocated.
  *
@@ -65,7 +146,9 @@ void body_rotate_with_velocity(Body* body);
  * @param mass the mass of the body (if INFINITY, prevents the body from moving)
  * @param color the color of the body, used to draw it on the screen
  * @param info additional information to associate with the body,
- *   e.g. its type if the scene has multiple types of bodies
+ *   e.g. its type if the scene has multiple types of bodies.
+ *   If non-NULL, it must start with a Role, which becomes the body's role;
+ *   otherwise the role is NEVER_REMOVE_ON_COLLISION.
  * @param info_freer if non-NULL, a function call on the info to free it
  * @return a pointer to the newly allocated body
  */
@@ -73,6 +156,44 @@ Body *body_init_with_info(
     List *shape, double mass, RGBColor color, void *info, FreeFunc info_freer
 );
 
+/**
+ * Gets the number of bytes of a body's frequently used ("hot") fields,
+ * so callers can supply memory for body_init_at().
+ *
+ * @return sizeof(Body)
+ */
+size_t body_size(void);
+
+/**
+ * Gets the number of bytes of a body's rarely used ("cold") fields:
+ * its color, info, elasticity and collision bookkeeping.
+ *
+ * @return the size of the memory body_init_at() needs for cold fields
+ */
+size_t body_cold_size(void);
+
+/**
+ * Initializes a body in memory provided by the caller (e.g. a scene's arena)
+ * instead of allocating it. Otherwise acts like body_init_with_info().
+ * The cold fields are stored separately so that hot records of many bodies
+ * can be packed together.
+ * A body created this way must be released with body_destroy(),
+ * after which the caller is responsible for both blocks of memory.
+ *
+ * @param memory at least body_size() bytes to construct the body in
+ * @param cold_memory at least body_cold_size() bytes for the cold fields
+ * @return memory, as a pointer to the newly initialized body
+ */
+Body *body_init_at(
+    void *memory,
+    void *cold_memory,
+    List *shape,
+    double mass,
+    RGBColor color,
+    void *info,
+    FreeFunc info_freer
+);
+
 /**
  * Releases the memory allocated for a body.
  *
@@ -80,6 +201,116 @@ Body *body_init_with_info(
  */
 void body_free(void *b);
 
+/**
+ * Releases the resources owned by a body (its shape and info)
+ * without freeing the memory the body itself occupies.
+ *
+ * @param body a pointer to a body returned from body_init_at()
+ */
+void body_destroy(Body *body);
+
+/**
+ * Gets the memory holding a body's cold fields,
+ * so the caller of body_init_at() can release it.
+ *
+ * @param body a pointer to a body returned from body_init_at()
+ * @return the cold_memory passed to body_init_at()
+ */
+void *body_get_cold_memory(Body *body);
+
+/**
+ * Gets the handle a scene assigned to a body when it was added.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's handle, or BODY_HANDLE_NULL if it is not in a scene
+ */
+BodyHandle body_get_handle(Body *body);
+
+/**
+ * Records the handle a scene assigned to a body.
+ * Only the scene that owns the body should call this.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param handle the body's new handle
+ */
+void body_set_handle(Body *body, BodyHandle handle);
+
+/**
+ * Initializes an empty set of body arrays.
+ *
+ * @param arrays the arrays to initialize
+ * @param allocator the allocator to get the arrays' memory from
+ */
+void body_arrays_init(BodyArrays *arrays, const Allocator *allocator);
+
+/**
+ * Frees the memory used by a set of body arrays.
+ * Every body must have been detached first.
+ *
+ * @param arrays the arrays to free
+ */
+void body_arrays_free(BodyArrays *arrays);
+
+/**
+ * Moves a body's dynamic state into a set of arrays.
+ * Asserts that the body is not already attached to arrays.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param arrays the arrays to store the body's state in
+ */
+void body_attach_arrays(Body *body, BodyArrays *arrays);
+
+/**
+ * Moves a body's dynamic state out of its arrays and back into the body.
+ * The last body in the arrays takes the freed index.
+ * Does nothing if the body is not attached.
+ *
+ * @param body a pointer to a body returned from body_init()
+ */
+void body_detach_arrays(Body *body);
+
+/**
+ * Integrates every body in a set of arrays over a time interval,
+ * using the same update as body_integrate_with_gravity().
+ * Bodies with MOTION_SUBSTEP are left alone, to be ticked by body_integrate().
+ * Only the arrays are written; body_finish_tick() must then be called on each
+ * body to move its shape and reset its forces.
+ *
+ * @param arrays the arrays to integrate
+ * @param gravity the acceleration of gravity, scaled for each body by its
+ *   gravity scale, or VEC_ZERO for none
+ * @param dt the number of seconds elapsed since the last tick
+ */
+void body_arrays_tick(BodyArrays *arrays, Vector gravity, double dt);
+
+/**
+ * Like body_arrays_tick(), but only integrates the bodies at indices
+ * [start, end). Disjoint ranges may be integrated at the same time
+ * from different threads.
+ *
+ * @param arrays the arrays to integrate
+ * @param start the index of the first body to integrate
+ * @param end one past the index of the last body to integrate
+ * @param gravity the acceleration of gravity, as in body_arrays_tick()
+ * @param dt the number of seconds elapsed since the last tick
+ */
+void body_arrays_tick_range(
+    BodyArrays *arrays, size_t start, size_t end, Vector gravity, double dt
+);
+
+/**
+ * Completes body_arrays_tick() for one attached body:
+ * records its acceleration and resets its forces and impulses,
+ * applies the MOTION_ACCELERATION update if the body has it,
+ * then moves its vertices to its new position and rotates it with its
+ * velocity. The result matches body_integrate_with_gravity().
+ *
+ * @param body a body attached to the arrays that were just ticked
+ * @param gravity the acceleration of gravity the arrays were ticked with
+ * @param dt the number of seconds elapsed since the last tick
+ */
+void body_finish_tick(Body *body, Vector gravity, double dt);
+
 /**
  * Gets the current shape of a body.
  * Returns a newly allocated vector list, which must be list_free()d.
@@ -108,6 +339,22 @@ Vector body_get_centroid(Body *body);
  * @return the body's velocity vector
  */
 Vector body_get_velocity(Body *body);
+/**
+ * Gets the total force applied to a body so far this tick.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the sum of the forces passed to body_add_force()
+ */
+Vector body_get_force(Body *body);
+
+/**
+ * Gets the total impulse applied to a body so far this tick.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the sum of the impulses passed to body_add_impulse()
+ */
+Vector body_get_impulse(Body *body);
+
 /**
  * Gets the current accerleration of a body.
  *
@@ -182,6 +429,7 @@ double body_area(Body* body);
 
 /**
  * Changes a body's velocity (the time-derivative of its position).
+ * Wakes the body if it is sleeping.
  *
  * @param body a pointer to a body returned from body_init()
  * @param v the body's new velocity
@@ -190,6 +438,7 @@ void body_set_velocity(Body *body, Vector v);
 
 /**
  * Changes a body's acceleration.
+ * Wakes the body if it is sleeping.
  *
  * @param body a pointer to a body returned from body_init()
  * @param v the body's new acceleration
@@ -227,6 +476,7 @@ void body_set_rotation_custom(Body *body, double angle, Vector pivot);
 
 /**
  * sets a body's force vector
+ * Wakes the body if it is sleeping.
  *
  * @param body 		the body to alter
  * @param force 	the force to change body's to
@@ -276,18 +526,31 @@ void body_set_time_since_last_collision(Body *body, double time);
  * Applies a force to a body over the current tick.
  * If multiple forces are applied in the same tick, they should be added.
  * Should not change the body's position or velocity; see body_tick().
+ * Sleeping bodies ignore added forces, since force creators add them every
+ * tick; use body_set_force() or body_wake() to move one.
  *
  * @param body a pointer to a body returned from body_init()
  * @param force the force vector to apply
  */
 void body_add_force(Body *body, Vector force);
 
+/**
+ * Makes body_add_force() and body_add_impulse() on the calling thread add
+ * to a buffer instead of to the bodies, until this is called again with NULL.
+ * Only bodies in a scene (with a handle) may be given forces meanwhile,
+ * and sleeping bodies stay asleep until the buffer is summed into them.
+ *
+ * @param buffer the buffer to add to, or NULL to add to bodies again
+ */
+void body_redirect_forces(ForceBuffer *buffer);
+
 /**
  * Applies an impulse to a body.
  * An impulse causes an instantaneous change in velocity,
  * which is useful for modeling collisions.
  * If multiple impulses are applied in the same tick, they should be added.
  * Should not change the body's position or velocity; see body_tick().
+ * Wakes the body if it is sleeping.
  *
  * @param body a pointer to a body returned from body_init()
  * @param impulse the impulse vector to apply
@@ -316,6 +579,147 @@ void body_tick(Body *body, double dt);
  */
 void body_tick_no_forces(Body *body, double dt);
 
+/**
+ * Updates the body after a given time interval has elapsed,
+ * according to its motion flags: MOTION_FORCES applies body_tick()'s update
+ * and MOTION_ACCELERATION then applies body_tick_no_forces()'s update.
+ * Kinematic bodies only get the latter, and static bodies are left alone.
+ * Either way, the body's vertices are moved and rotated only once.
+ *
+ * @param body the body to tick
+ * @param dt the number of seconds elapsed since the last tick
+ */
+void body_integrate(Body *body, double dt);
+
+/**
+ * Like body_integrate(), but also accelerates the body by a uniform gravity
+ * times its gravity scale, along with the forces on it. Like them, gravity
+ * only moves bodies that have MOTION_FORCES and finite mass, and is recorded
+ * in the body's acceleration.
+ *
+ * @param body the body to tick
+ * @param gravity the acceleration of gravity, before the body's scale
+ * @param dt the number of seconds elapsed since the last tick
+ */
+void body_integrate_with_gravity(Body *body, Vector gravity, double dt);
+
+/**
+ * Gets how strongly a scene's gravity (see scene_set_gravity()) pulls a body.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's gravity scale
+ */
+double body_get_gravity_scale(Body *body);
+
+/**
+ * Sets how strongly a scene's gravity (see scene_set_gravity()) pulls a body,
+ * as a multiple of the scene's: 1 by default, 0 for a body that floats,
+ * and negative for one that rises. It is stored in single precision.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param scale the body's new gravity scale
+ */
+void body_set_gravity_scale(Body *body, double scale);
+
+/**
+ * Gets how a body is moved each tick.
+ * Bodies start out with MOTION_FORCES.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's motion flags
+ */
+MotionFlags body_get_motion(Body *body);
+
+/**
+ * Sets how a body is moved each tick (see body_integrate()).
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param motion a combination of MotionFlags
+ */
+void body_set_motion(Body *body, MotionFlags motion);
+
+/**
+ * Gets whether and how a body moves.
+ * Bodies start out BODY_DYNAMIC.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's type
+ */
+BodyType body_get_type(Body *body);
+
+/**
+ * Sets whether and how a body moves (see BodyType).
+ * Making a body static also stops it. Only dynamic bodies sleep,
+ * so giving a sleeping body another type wakes it.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param type the body's new type
+ */
+void body_set_type(Body *body, BodyType type);
+
+/**
+ * Whether a body is sleeping. Sleeping bodies stay where they are with no
+ * velocity, as if they were static, until something wakes them.
+ * Collisions between two bodies that are each sleeping or static
+ * are never checked.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return whether the body is sleeping
+ */
+bool body_is_sleeping(Body *body);
+
+/**
+ * Puts a dynamic body to sleep, stopping it and dropping the forces and
+ * impulses on it. Only dynamic bodies sleep; this does nothing to others.
+ *
+ * @param body a pointer to a body returned from body_init()
+ */
+void body_sleep(Body *body);
+
+/**
+ * Wakes a sleeping body and restarts its count of ticks at rest.
+ *
+ * @param body a pointer to a body returned from body_init()
+ */
+void body_wake(Body *body);
+
+/**
+ * Counts one more tick for an awake dynamic body if it is moving
+ * no faster than max_speed, or restarts its count otherwise,
+ * and puts it to sleep once it has been at rest for the given number of ticks.
+ * scene_tick() calls this on every body once sleeping is enabled
+ * (see scene_set_sleeping()).
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param max_speed the fastest a body at rest may move
+ * @param ticks how many ticks in a row the body must be at rest,
+ *   at least 1 and at most BODY_MAX_REST_TICKS
+ * @return whether the body is sleeping
+ */
+bool body_update_sleep(Body *body, double max_speed, size_t ticks);
+
+/**
+ * Limits how far a body may move in one step. When scene_tick() would move
+ * the body farther, it splits the tick into enough substeps for just this
+ * body, and re-runs the body's collision checks between them, so a fast body
+ * does not pass through thin ones. Other bodies still take one step.
+ * Scenes using another integrator than INTEGRATOR_AVERAGE_VELOCITY
+ * integrate the body with the others instead.
+ * Sets MOTION_SUBSTEP, or clears it if the limit is INFINITY.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param max_displacement the farthest the body may move in a step
+ */
+void body_set_max_displacement(Body *body, double max_displacement);
+
+/**
+ * Gets how far a body may move in one step.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the limit set by body_set_max_displacement(), or INFINITY if none
+ */
+double body_get_max_displacement(Body *body);
+
 /**
  * Marks a body for removal--future calls to body_is_removed() will return true.
  * Does not free the body.
@@ -92,5 +92,18 @@ void projection_min_max(List *shape, Vector projection_line, Vector *min_max);
  */
 bool is_between(double num, Vector *vec);
 
+/**
+ * Finds the shortest way out of a convex polygon for a point inside it.
+ * The polygon's vertices may be in either order, but must not all lie on
+ * one line.
+ *
+ * @param shape the polygon
+ * @param point the point
+ * @return the shortest translation that moves the point onto the polygon's
+ *   boundary, or VEC_ZERO if the point is outside the polygon or on its
+ *   boundary
+ */
+Vector find_point_collision(List *shape, Vector point);
+
 
 #endif // #ifndef __COLLISION_H__
@@ -0,0 +1,87 @@
+#ifndef __CONSTRAINTS_H__
+#define __CONSTRAINTS_H__
+
+#include "scene.h"
+
+/**
+ * The number of passes a scene's constraint solver makes over its
+ * constraints each tick, unless constraints_set_iterations() changes it.
+ */
+#define CONSTRAINT_DEFAULT_ITERATIONS 10
+
+/**
+ * Constraints hold bodies exactly where they are allowed to be, rather than
+ * pulling them there with forces like create_spring() does, so a chain or
+ * rope stays rigid at any step without stiff springs and substeps.
+ *
+ * The first constraint added to a scene gives it a solver (see
+ * scene_add_constraint_batch()), which runs each tick after the bodies move.
+ * It makes several Gauss-Seidel passes over all the scene's constraints,
+ * moving each constraint's bodies just far enough to satisfy it, split
+ * in inverse proportion to their masses, as in position-based dynamics
+ * (see https://matthias-research.github.io/pages/publications/posBasedDyn.pdf).
+ * The velocity of each body it moves then changes by the distance moved over
+ * scene_get_dt(), so the body keeps moving the way it was pulled.
+ * More passes get closer to satisfying every constraint at once.
+ *
+ * Bodies that forces do not move, such as static, kinematic, sleeping and
+ * infinitely massive ones, are never moved by a constraint, but the other
+ * bodies are still held to them. Constraints on a body marked for removal
+ * are dropped.
+ */
+
+/**
+ * Holds two bodies' centroids a fixed distance apart, like a rigid rod.
+ *
+ * @param scene the scene containing the bodies
+ * @param body1 the first body, which must already be in the scene
+ * @param body2 the second body, which must already be in the scene
+ * @param distance the distance to keep between the centroids, at least 0
+ */
+void create_distance_constraint(
+    Scene *scene, Body *body1, Body *body2, double distance
+);
+
+/**
+ * Holds a body's centroid at a fixed point, about which it can swing
+ * if it is also constrained to other bodies.
+ *
+ * @param scene the scene containing the body
+ * @param body the body to pin, which must already be in the scene
+ * @param point where to hold the body's centroid
+ */
+void create_pin_constraint(Scene *scene, Body *body, Vector point);
+
+/**
+ * Keeps two bodies' centroids at most a given distance apart, like a rope:
+ * it does nothing while they are closer, and acts like
+ * create_distance_constraint() once the rope is taut.
+ *
+ * @param scene the scene containing the bodies
+ * @param body1 the first body, which must already be in the scene
+ * @param body2 the second body, which must already be in the scene
+ * @param length the farthest apart the centroids may be, at least 0
+ */
+void create_rope_constraint(
+    Scene *scene, Body *body1, Body *body2, double length
+);
+
+/**
+ * Sets how many passes a scene's constraint solver makes each tick.
+ * Long chains need more passes to stay at their full stiffness.
+ *
+ * @param scene the scene whose constraints to solve
+ * @param iterations the number of passes, at least 1
+ */
+void constraints_set_iterations(Scene *scene, size_t iterations);
+
+/**
+ * Gets how many passes a scene's constraint solver makes each tick.
+ *
+ * @param scene the scene whose constraints to solve
+ * @return the number passed to constraints_set_iterations(),
+ *   or CONSTRAINT_DEFAULT_ITERATIONS if it was not called
+ */
+size_t constraints_get_iterations(Scene *scene);
+
+#endif // #ifndef __CONSTRAINTS_H__
@@ -23,6 +23,11 @@ typedef struct elas Elas;
  * Contain auxiliary information required for collisions.
  */
 typedef struct collisionAux CollisionAux;
+/**
+ * Springs and drag whose forces are integrated implicitly,
+ * returned from create_spring_network().
+ */
+typedef struct springNetwork SpringNetwork;
 
 
 /**
@@ -62,6 +67,56 @@ void addCollision(void *aux);
  */
 void create_newtonian_gravity(Scene *scene, double G, Body *body1, Body *body2);
 
+/**
+ * Adds Newtonian gravity between every pair of bodies in a list,
+ * computed for all the pairs at once from arrays of the bodies' positions
+ * and masses. This is much faster than create_newtonian_gravity() on each pair.
+ * Rather than being skipped when bodies are very close, the force is softened
+ * (see https://en.wikipedia.org/wiki/Softening): body2 pulls body1 with
+ * G * m1 * m2 * r / (|r|^2 + softening^2)^(3/2), where r points from body1
+ * to body2, so the force stays finite as the bodies meet.
+ * Bodies removed from the scene stop pulling and being pulled.
+ *
+ * @param scene the scene containing the bodies
+ * @param G the gravitational proportionality constant
+ * @param bodies the bodies that attract each other, each listed once;
+ *   the list is copied, so the caller still owns it
+ * @param softening the distance below which the force is smoothed out,
+ *   or 0 for none, in which case no two bodies may be at the same point
+ */
+void create_nbody_gravity(
+    Scene *scene, double G, List *bodies, double softening
+);
+
+/**
+ * Adds Newtonian gravity between every pair of bodies in a list, like
+ * create_nbody_gravity(), but approximated with a Barnes-Hut quadtree
+ * (see https://en.wikipedia.org/wiki/Barnes%E2%80%93Hut_simulation).
+ * Each tick the tree is rebuilt from the bodies' centroids and masses, and
+ * a group of bodies whose cell is smaller than theta times its distance
+ * pulls as a single body at its center of mass. That takes O(n log n) time
+ * rather than O(n^2), so it is the faster choice for thousands of bodies.
+ * Building and walking the tree are spread over the scene's threads
+ * (see scene_set_threads()), and the forces do not depend on the thread count.
+ *
+ * theta trades accuracy for speed. At 0 no group is approximated, and the
+ * forces match create_nbody_gravity()'s up to rounding, though they take
+ * longer to compute. Around 0.5 the forces are typically within a fraction of
+ * a percent of the exact ones, and larger values are faster but rougher.
+ *
+ * @param scene the scene containing the bodies
+ * @param G the gravitational proportionality constant
+ * @param bodies the bodies that attract each other, each listed once;
+ *   the list is copied, so the caller still owns it
+ * @param softening the distance below which the force is smoothed out,
+ *   as in create_nbody_gravity()
+ * @param theta the opening angle: the largest ratio of a group's size to
+ *   its distance at which it is treated as one body
+ */
+void create_barnes_hut_gravity(
+    Scene *scene, double G, List *bodies, double softening, double theta
+);
+
 /**
  * Adds a Hooke's-Law spring force between two bodies in a scene.
  * See https://en.wikipedia.org/wiki/Hooke%27s_law.
@@ -84,6 +139,57 @@ void create_spring(Scene *scene, double k, Body *body1, Body *body2);
  */
 void create_drag(Scene *scene, double gamma, Body *body);
 
+/**
+ * Adds a network of springs and drag to a scene whose forces are integrated
+ * implicitly, for stiff springs that create_spring() could only simulate
+ * with very small steps.
+ * Each tick, the network's springs and drag are assembled into a sparse
+ * linear system for its bodies' velocities at the end of the tick, as in
+ * backward Euler (see https://en.wikipedia.org/wiki/Backward_Euler_method),
+ * which is solved with the conjugate gradient method. The scene's gravity is
+ * part of the solve; other forces on the bodies are still explicit.
+ * The network is stable at any step, though stiff springs lose energy
+ * faster the larger the step.
+ *
+ * With INTEGRATOR_AVERAGE_VELOCITY, the network sets its bodies' velocities
+ * to their new ones, so they move with them for the whole tick. With other
+ * integrators it adds the springs' and drag's forces at the end of the tick
+ * instead, which is exact for INTEGRATOR_SYMPLECTIC_EULER. Either way it
+ * uses scene_get_dt(). Bodies whose velocities the network does not solve
+ * for, such as static, kinematic, sleeping and infinitely massive ones,
+ * still pull on the others. Large networks multiply their sparse matrix on
+ * the scene's threads, and their forces do not depend on the thread count.
+ *
+ * @param scene the scene to add the network to
+ * @return the new network, with no springs or drag, which the scene frees
+ */
+SpringNetwork *create_spring_network(Scene *scene);
+
+/**
+ * Adds a Hooke's-Law spring between two bodies to a spring network, like
+ * create_spring() but integrated implicitly. Springs on a body marked for
+ * removal are dropped from the network.
+ *
+ * @param network a network returned from create_spring_network()
+ * @param k the Hooke's constant for the spring, at least 0
+ * @param body1 the first body, which must already be in the network's scene
+ * @param body2 the second body, which must already be in the network's scene
+ */
+void spring_network_add_spring(
+    SpringNetwork *network, double k, Body *body1, Body *body2
+);
+
+/**
+ * Adds drag on a body to a spring network, like create_drag() but
+ * integrated implicitly.
+ *
+ * @param network a network returned from create_spring_network()
+ * @param gamma the proportionality constant between force and velocity,
+ *   at least 0
+ * @param body the body to slow down, which must already be in the scene
+ */
+void spring_network_add_drag(SpringNetwork *network, double gamma, Body *body);
+
 /**
  * Adds a ForceCreator to a scene that calls a given CollisionHandler
  * each time two bodies collide.
@@ -141,7 +247,8 @@ void create_physics_collision(
 
 /**
  * Frees memory associated with auxiliary argument needed for application of a
- * force
+ * force. The aux of gravity, springs and drag lives in the scene's arena,
+ * so this returns it there.
  * @param a the aux
  */
 void aux_freer(void *a);
@@ -0,0 +1,109 @@
+#ifndef __GAME_LOOP_H__
+#define __GAME_LOOP_H__
+
+#include <stddef.h>
+#include "scene.h"
+#include "vector.h"
+
+/**
+ * Drives a scene with a fixed physics timestep, whatever the frame rate.
+ * Each frame's elapsed time goes into an accumulator, and the scene is ticked
+ * once per whole step in it. The leftover fraction of a step is reported as
+ * an interpolation alpha, so rendering can blend the last two physics states
+ * instead of tying the physics rate to the frame rate.
+ *
+ * Example:
+ * ```
+ * GameLoop *loop = game_loop_init(1.0 / 120, 8);
+ * while (!sdl_is_done()) {
+ *     game_loop_tick_scene(loop, scene, time_since_last_tick());
+ *     sdl_render_scene_interpolated(scene, loop);
+ * }
+ * game_loop_free(loop);
+ * ```
+ */
+typedef struct gameLoop GameLoop;
+
+/**
+ * Allocates memory for a game loop with an empty accumulator.
+ *
+ * @param step the fixed time in seconds that each physics step simulates
+ * @param max_substeps the most steps to run in one frame. Time beyond that is
+ *   dropped, so a slow frame cannot make the next one slower still.
+ * @return the new game loop
+ */
+GameLoop *game_loop_init(double step, size_t max_substeps);
+
+/**
+ * Releases memory allocated for a game loop.
+ *
+ * @param loop a pointer to a game loop returned from game_loop_init()
+ */
+void game_loop_free(GameLoop *loop);
+
+/**
+ * Gets the fixed time each physics step simulates.
+ *
+ * @param loop a pointer to a game loop returned from game_loop_init()
+ * @return the step passed to game_loop_init(), in seconds
+ */
+double game_loop_get_step(GameLoop *loop);
+
+/**
+ * Adds a frame's elapsed time to the accumulator and takes out
+ * as many whole steps as may be run this frame.
+ * Use this to drive something other than scene_tick() with fixed steps:
+ * the caller runs the returned number of steps of game_loop_get_step().
+ *
+ * @param loop a pointer to a game loop returned from game_loop_init()
+ * @param frame_time the time in seconds since the last frame
+ * @return the number of steps to run, at most max_substeps
+ */
+size_t game_loop_advance(GameLoop *loop, double frame_time);
+
+/**
+ * Advances a scene by a frame's elapsed time in fixed steps,
+ * calling scene_tick() once per step.
+ * Also records where each body was before the last step,
+ * for game_loop_render_offsets().
+ *
+ * @param loop a pointer to a game loop returned from game_loop_init()
+ * @param scene the scene to advance
+ * @param frame_time the time in seconds since the last frame
+ * @return the number of steps run, at most max_substeps
+ */
+size_t game_loop_tick_scene(GameLoop *loop, Scene *scene, double frame_time);
+
+/**
+ * Gets how far the accumulator is into the next step.
+ * A renderer should draw each body at alpha of the way from its position
+ * before the last step to its current one.
+ *
+ * @param loop a pointer to a game loop returned from game_loop_init()
+ * @return the leftover time divided by the step, in [0, 1)
+ */
+double game_loop_alpha(GameLoop *loop);
+
+/**
+ * Gets the total time the loop has dropped because of max_substeps.
+ * If this keeps growing, the physics cannot keep up with real time.
+ *
+ * @param loop a pointer to a game loop returned from game_loop_init()
+ * @return the dropped time in seconds
+ */
+double game_loop_dropped_time(GameLoop *loop);
+
+/**
+ * Computes where to draw each body of a scene relative to its centroid
+ * so that it appears interpolated by game_loop_alpha().
+ * Only translation is interpolated; bodies are drawn at their current angle.
+ * Bodies added since the last step are drawn where they are.
+ *
+ * @param loop a pointer to a game loop that last ticked this scene
+ * @param scene the scene to draw
+ * @return an array with one offset per body in the scene, in index order,
+ *   which is valid until the next call on this loop
+ */
+const Vector *game_loop_render_offsets(GameLoop *loop, Scene *scene);
+
+#endif // #ifndef __GAME_LOOP_H__
@@ -2,6 +2,8 @@
 #define __LIST_H__
 
 #include <stddef.h>
+#include "allocator.h"
+#include "arena.h"
 
 /**
  * A growable array of pointers.
@@ -28,6 +30,71 @@ typedef void (*FreeFunc)(void *data);
  */
 List *list_init(size_t initial_size, FreeFunc freer);
 
+/**
+ * Allocates a new list from an allocator instead of allocator_global().
+ * The list's header and its internal array (as it grows) come from it.
+ * The first initial_size elements are stored in the same block as the header,
+ * so the list costs a single allocation until it grows past them.
+ * Otherwise acts like list_init().
+ *
+ * @param allocator the allocator to get the list's memory from
+ * @param initial_size the number of elements to allocate space for
+ * @param freer if non-NULL, a function to call on elements in the list,
+ *   or allocator_owned if they were also allocated from this allocator
+ * @return a pointer to the newly allocated list
+ */
+List *list_init_with_allocator(
+    const Allocator *allocator, size_t initial_size, FreeFunc freer
+);
+
+/**
+ * Gets the number of bytes list_init_in() needs for a list.
+ *
+ * @param inline_capacity the number of elements to store without allocating
+ * @return the size of the memory to pass to list_init_in()
+ */
+size_t list_inline_size(size_t inline_capacity);
+
+/**
+ * Creates a list in memory supplied by the caller, e.g. at the end of a
+ * struct that owns the list, so creating it does not allocate at all.
+ * The first inline_capacity elements are stored in that memory; the list only
+ * allocates (from the allocator) if it grows past them.
+ * list_free() frees the list's elements and any memory it allocated,
+ * but not the memory passed in.
+ *
+ * @param memory at least list_inline_size(inline_capacity) bytes,
+ *   aligned for a pointer
+ * @param allocator the allocator to get memory from if the list grows
+ * @param inline_capacity the number of elements to store without allocating
+ * @param freer if non-NULL, a function to call on elements in the list
+ * @return a pointer to the list, which is at memory
+ */
+List *list_init_in(
+    void *memory,
+    const Allocator *allocator,
+    size_t inline_capacity,
+    FreeFunc freer
+);
+
+/**
+ * Gets the space a list allocated from arena_allocator() takes out of the
+ * arena, not counting its elements, for use with arena_reserve().
+ *
+ * @param initial_size the number of elements to allocate space for
+ * @return the total arena_footprint() of the list's allocations
+ */
+size_t list_arena_footprint(size_t initial_size);
+
+/**
+ * Gets the allocator a list was allocated from.
+ *
+ * @param list a pointer to a list returned from list_init()
+ * @return the allocator passed to list_init_with_allocator(),
+ *   or the global allocator at the time list_init() was called
+ */
+const Allocator *list_get_allocator(List *list);
+
 /**
  * Releases the memory allocated for a list.
  *
@@ -0,0 +1,82 @@
+#ifndef __PREFAB_H__
+#define __PREFAB_H__
+
+#include <stddef.h>
+#include "allocator.h"
+#include "list.h"
+#include "vector.h"
+
+/**
+ * An immutable polygon in local space (centered on its centroid),
+ * shared by every body spawned from it.
+ * The shape is computed once, so spawning many copies of it only copies
+ * vertices instead of recomputing and allocating each one.
+ * Prefabs are reference counted: whoever holds a reference keeps it alive.
+ */
+typedef struct shapePrefab ShapePrefab;
+
+/**
+ * Where to place a copy of a prefab:
+ * it is rotated by angle about its centroid, then moved to position.
+ */
+typedef struct {
+    Vector position;
+    double angle;
+} Transform;
+
+/**
+ * Creates a prefab from a polygon.
+ * The polygon may be anywhere; the prefab is centered on its centroid.
+ * The caller holds the only reference to the new prefab.
+ *
+ * @param shape a list of vectors describing the polygon, which is freed
+ * @return a pointer to the newly allocated prefab
+ */
+ShapePrefab *prefab_init(List *shape);
+
+/**
+ * Takes another reference to a prefab.
+ *
+ * @param prefab a pointer to a prefab returned from prefab_init()
+ */
+void prefab_retain(ShapePrefab *prefab);
+
+/**
+ * Drops a reference to a prefab, freeing it when no references remain.
+ *
+ * @param prefab a pointer to a prefab returned from prefab_init()
+ */
+void prefab_release(ShapePrefab *prefab);
+
+/**
+ * Gets the number of vertices in a prefab.
+ *
+ * @param prefab a pointer to a prefab returned from prefab_init()
+ * @return the number of vertices in the polygon
+ */
+size_t prefab_size(ShapePrefab *prefab);
+
+/**
+ * Gets where the centroid of the polygon passed to prefab_init() was.
+ * Adding this to a position places a copy exactly where a polygon built
+ * around that position would have been.
+ *
+ * @param prefab a pointer to a prefab returned from prefab_init()
+ * @return the centroid of the original polygon
+ */
+Vector prefab_get_centroid(ShapePrefab *prefab);
+
+/**
+ * Creates a copy of a prefab's polygon placed by a transform.
+ *
+ * @param prefab a pointer to a prefab returned from prefab_init()
+ * @param transform where to place the copy
+ * @param allocator the allocator to allocate the copy from,
+ *   or NULL for allocator_global()
+ * @return a newly allocated list of vectors (see list_init_with_allocator())
+ */
+List *prefab_instantiate(
+    ShapePrefab *prefab, Transform transform, const Allocator *allocator
+);
+
+#endif // #ifndef __PREFAB_H__
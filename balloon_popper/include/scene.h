@@ -4,6 +4,8 @@
 #include <stdbool.h>
 #include "body.h"
 #include "list.h"
+#include "prefab.h"
+#include "thread_pool.h"
 
 /**
  * Enum to specify which wall of the scene a body may hit
@@ -37,6 +39,32 @@ typedef struct forceInfo ForceInfo;
  */
 typedef void (*ForceCreator)(void *aux);
 
+/**
+ * How scene_tick() moves bodies that are moved by forces (MOTION_FORCES).
+ * The higher-order integrators re-run the scene's pure force creators
+ * (see scene_add_pure_force_creator()) at trial positions and velocities
+ * within each tick, so they stay accurate with much larger steps.
+ * Other force creators, such as collisions, still run once per tick,
+ * and their forces and impulses are held fixed over it.
+ */
+typedef enum {
+    // The update of body_tick(): forces are evaluated once, and the body
+    // moves with the average of its velocities before and after the tick
+    INTEGRATOR_AVERAGE_VELOCITY,
+    // Semi-implicit Euler: the velocity is updated first, then the position
+    // with the new velocity. One force evaluation; energy stays bounded.
+    INTEGRATOR_SYMPLECTIC_EULER,
+    // Velocity Verlet: second-order and symplectic.
+    // Two force evaluations per tick.
+    INTEGRATOR_VELOCITY_VERLET,
+    // Classic fourth-order Runge-Kutta. Four force evaluations per tick.
+    INTEGRATOR_RK4,
+    // Dormand-Prince 5(4): each tick is split into as many substeps as it
+    // takes to keep the estimated error within the scene's tolerance
+    // (see scene_set_tolerance()). About six force evaluations per substep.
+    INTEGRATOR_ADAPTIVE
+} Integrator;
+
 /**
  * Releases memory allocated for a ForceInfo struct
  * @param force a pointer to the ForceInfo
@@ -52,6 +80,18 @@ void forceInfo_free(void *force);
  */
 Scene *scene_init(void);
 
+/**
+ * Allocates memory for an empty scene from an allocator
+ * instead of allocator_global().
+ * The scene's own bookkeeping and the chunks of its arenas come from the
+ * allocator; bodies and force creators it creates live in those arenas.
+ *
+ * @param allocator the allocator to get the scene's memory from,
+ *   which must stay valid until scene_free()
+ * @return the new scene
+ */
+Scene *scene_init_with_allocator(const Allocator *allocator);
+
 /**
  * Releases memory allocated for a given scene
  * and all the bodies and force creators it contains.
@@ -86,13 +126,70 @@ size_t scene_forces(Scene *scene);
  */
 Body *scene_get_body(Scene *scene, size_t index);
 
+/**
+ * Gets the body a handle refers to.
+ * Unlike an index, a handle keeps referring to the same body while other
+ * bodies are added and removed.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param handle a handle returned from scene_add_body() or scene_spawn_body()
+ * @return a pointer to the body, or NULL if the body has been freed
+ */
+Body *scene_get_body_by_handle(Scene *scene, BodyHandle handle);
+
 /**
  * Adds a body to a scene.
+ * The scene takes ownership of the body and frees it when it is removed.
  *
  * @param scene a pointer to a scene returned from scene_init()
  * @param body a pointer to the body to add to the scene
+ * @return a handle that refers to the body until it is removed
+ */
+BodyHandle scene_add_body(Scene *scene, Body *body);
+
+/**
+ * Creates a body in memory owned by the scene and adds it to the scene.
+ * Bodies created this way are allocated from the scene's arena, so they avoid
+ * a separate malloc() and sit next to each other in memory.
+ * The parameters are the same as for body_init_with_info().
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return a handle that refers to the new body until it is removed
  */
-void scene_add_body(Scene *scene, Body *body);
+BodyHandle scene_spawn_body(
+    Scene *scene,
+    List *shape,
+    double mass,
+    RGBColor color,
+    void *info,
+    FreeFunc info_freer
+);
+
+/**
+ * Spawns one body for each transform, all with copies of the same prefab,
+ * like calling scene_spawn_body() with prefab_instantiate() in a loop.
+ * The memory for the whole batch is reserved at once, and the shapes are
+ * allocated from the scene's arena.
+ * The scene keeps the prefab alive until scene_reset() or scene_free().
+ * The bodies have no info, so use body_set_role() to give them roles.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param prefab the shape of every body
+ * @param transforms where to place each body
+ * @param count the number of bodies to spawn
+ * @param mass the mass of every body
+ * @param color the color of every body
+ * @param handles if non-NULL, an array of count handles to fill in
+ */
+void scene_spawn_many(
+    Scene *scene,
+    ShapePrefab *prefab,
+    const Transform *transforms,
+    size_t count,
+    double mass,
+    RGBColor color,
+    BodyHandle *handles
+);
 
 /**
  * @deprecated Use body_remove() instead
@@ -142,6 +239,97 @@ void scene_add_bodies_force_creator(
     Scene *scene, ForceCreator forcer, void *aux, List *bodies, FreeFunc freer
 );
 
+/**
+ * A function that makes a batch of forces forget the bodies
+ * that have been marked for removal (see scene_add_force_batch()).
+ * Takes in the batch's auxiliary value.
+ */
+typedef void (*ForcePruner)(void *aux);
+
+/**
+ * Adds a pure force creator (see scene_add_pure_force_creator()) that
+ * applies many forces of one kind at once, like every spring in a scene.
+ * It is not freed when one of its bodies is removed: scene_tick() calls
+ * pruner instead, at the point where it would free other force creators,
+ * and the batch must stop touching the removed bodies.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param forcer the force creator function that applies the whole batch
+ * @param aux the batch, which is passed to forcer and pruner
+ * @param pruner the function that drops removed bodies from aux
+ * @param freer if non-NULL, a function to call in order to free aux
+ */
+void scene_add_force_batch(
+    Scene *scene, ForceCreator forcer, void *aux, ForcePruner pruner,
+    FreeFunc freer
+);
+
+/**
+ * Adds a force batch (see scene_add_force_batch()) whose force creator
+ * spreads its own work over the scene's threads, with
+ * scene_get_thread_pool(). So that it can start loops on the pool, it is
+ * always called from the thread that called scene_tick(), never alongside
+ * other force creators. Each body must get its forces from only one thread.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param forcer the force creator function that applies the whole batch
+ * @param aux the batch, which is passed to forcer and pruner
+ * @param pruner the function that drops removed bodies from aux
+ * @param freer if non-NULL, a function to call in order to free aux
+ */
+void scene_add_parallel_force_batch(
+    Scene *scene, ForceCreator forcer, void *aux, ForcePruner pruner,
+    FreeFunc freer
+);
+
+/**
+ * Adds a batch of constraints on the scene's bodies, like the joints in
+ * constraints.h. Rather than applying forces before the bodies move,
+ * scene_tick() calls solver once they have moved (including any substeps),
+ * so it can correct their positions and velocities directly.
+ * Batches are solved in the order they were added, from the thread that
+ * called scene_tick(), and are pruned like force batches
+ * (see scene_add_force_batch()). scene_get_force_batch() finds them too.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param solver the function that enforces the whole batch
+ * @param aux the batch, which is passed to solver and pruner
+ * @param pruner the function that drops removed bodies from aux
+ * @param freer if non-NULL, a function to call in order to free aux
+ */
+void scene_add_constraint_batch(
+    Scene *scene, ForceCreator solver, void *aux, ForcePruner pruner,
+    FreeFunc freer
+);
+
+/**
+ * Gets the newest batch added to a scene with a given force creator,
+ * so more forces of its kind can be added to it.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param forcer the force creator function the batch was added with
+ * @return the aux of the newest such batch, or NULL if there is none
+ */
+void *scene_get_force_batch(Scene *scene, ForceCreator forcer);
+
+/**
+ * Adds a force creator that only adds forces computed from the current
+ * positions and velocities of its bodies, and has no other effects.
+ * It is otherwise like scene_add_bodies_force_creator(), but integrators
+ * other than INTEGRATOR_AVERAGE_VELOCITY may call it several times per tick
+ * with the bodies moved to trial states (see Integrator), and scenes with
+ * several threads may call it on any of them (see scene_set_threads()).
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param forcer a force creator function
+ * @param aux an auxiliary value to pass to forcer when it is called
+ * @param bodies the list of bodies affected by the force creator
+ * @param freer if non-NULL, a function to call in order to free aux
+ */
+void scene_add_pure_force_creator(
+    Scene *scene, ForceCreator forcer, void *aux, List *bodies, FreeFunc freer
+);
+
 /**
  * Adds a circle to the scene at a random or given location
  * @param scene      		the scene
@@ -151,15 +339,215 @@ void scene_add_bodies_force_creator(
  * @param start_vel         starting velocity of the body
  * @param start_acc         starting acceleration of the body
  * @param elasticity        starting elasticity
+ * @return                  a handle to the new body
  */
-void scene_add_special_body( Scene* scene, RGBColor color, List *points,
+BodyHandle scene_add_special_body( Scene* scene, RGBColor color, List *points,
     double mass, Vector start_vel, Vector start_acc, Vector elasticity
 );
 
+/**
+ * Lets a scene put bodies to sleep once they come to rest (see
+ * body_is_sleeping()). After each tick, a dynamic body that has moved no
+ * faster than max_speed for the given number of ticks in a row is stopped,
+ * and scene_tick() skips it and its collisions with other resting bodies.
+ * It wakes when an awake body collides with it, or when its velocity, force,
+ * acceleration or type is set or an impulse is added to it.
+ * Sleeping is off by default. Calling this wakes every body in the scene.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param max_speed the fastest a body may move and still be at rest
+ * @param ticks how many ticks in a row a body must be at rest before it
+ *   sleeps, at most BODY_MAX_REST_TICKS; 0 turns sleeping off
+ */
+void scene_set_sleeping(Scene *scene, double max_speed, size_t ticks);
+
+/**
+ * Sets a uniform gravitational field over the whole scene.
+ * Every dynamic body with MOTION_FORCES and a finite mass accelerates by
+ * gravity times its gravity scale (see body_set_gravity_scale()) each tick,
+ * whatever its mass. The field is applied as bodies are integrated,
+ * so it needs no force creator and no body to pull towards.
+ * The scene has no gravity by default. Changing it wakes every body.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param gravity the acceleration due to gravity, e.g. (Vector) {0, -9.8}
+ */
+void scene_set_gravity(Scene *scene, Vector gravity);
+
+/**
+ * Gets a scene's uniform gravitational field.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the acceleration passed to scene_set_gravity(), or VEC_ZERO
+ */
+Vector scene_get_gravity(Scene *scene);
+
+/**
+ * Gets the length of the tick a scene is running, for force creators whose
+ * forces depend on it, such as create_spring_network()'s.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the dt passed to the scene_tick() in progress, or to the last one,
+ *   or 0 if the scene has not been ticked
+ */
+double scene_get_dt(Scene *scene);
+
+/**
+ * Gets how many of a scene's bodies are sleeping.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the number of sleeping bodies
+ */
+size_t scene_sleeping_bodies(Scene *scene);
+
+/**
+ * Gets how many of a scene's bodies scene_tick() moves:
+ * those that are neither sleeping nor static.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the number of awake bodies
+ */
+size_t scene_awake_bodies(Scene *scene);
+
+/**
+ * Sets how many threads scene_tick() integrates bodies on, counting the
+ * calling thread. The scene keeps a pool of threads - 1 workers that wait
+ * between ticks. Each body is integrated exactly as it would be on one
+ * thread, so this alone does not change the results.
+ * Scenes with a thousand bodies or fewer are still integrated serially,
+ * where starting the workers would cost more than it saves.
+ *
+ * Those larger scenes also run their pure force creators (see
+ * scene_add_pure_force_creator()) in parallel, before the others. Each
+ * thread adds to its own buffer of forces, and the buffers are summed in a
+ * fixed order, so the results are the same on every run with the same
+ * thread count, though their last bits may differ from a serial tick's.
+ * Only INTEGRATOR_AVERAGE_VELOCITY ticks in parallel. Defaults to 1.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param threads the number of threads to use, at least 1
+ */
+void scene_set_threads(Scene *scene, size_t threads);
+
+/**
+ * Gets how many threads scene_tick() integrates bodies on.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the count passed to scene_set_threads(), or 1 if it was not called
+ */
+size_t scene_get_threads(Scene *scene);
+
+/**
+ * Gets the pool of threads a scene ticks on, for force creators added with
+ * scene_add_parallel_force_batch(). It changes when scene_set_threads() is
+ * called, so it should be fetched each time it is used.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the scene's thread pool, or NULL if the scene has 1 thread
+ */
+ThreadPool *scene_get_thread_pool(Scene *scene);
+
+/**
+ * Chooses where a scene keeps its bodies' positions, velocities, forces and
+ * impulses. When enabled, they are stored as structure-of-arrays (see
+ * BodyArrays) and scene_tick() integrates every body in one tight loop before
+ * moving their shapes; the result is identical to the default storage.
+ * Bodies already in the scene are moved to the new storage.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param enabled whether the scene should use body arrays
+ */
+void scene_set_body_arrays(Scene *scene, bool enabled);
+
+/**
+ * Gets the arena a scene allocates its bodies and force creators from.
+ * Shapes, infos and force creator aux allocated here are dropped by
+ * scene_reset() without being visited; see arena_allocator() and
+ * utils_set_shape_allocator().
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the scene's arena
+ */
+Arena *scene_get_arena(Scene *scene);
+
+/**
+ * Removes every body and force creator from a scene, e.g. to load a level.
+ * Bodies whose shapes and infos (if they have info freers) were allocated from
+ * scene_get_arena(), and force creators whose aux was, are dropped all at once
+ * along with the arena. Only the others are freed individually, so a scene
+ * built entirely in its arena is reset in constant time. The arena keeps its
+ * memory, so rebuilding the scene does not need to allocate from the heap.
+ * Every handle into the scene becomes stale.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ */
+void scene_reset(Scene *scene);
+
+/**
+ * Sets the motion flags (see body_integrate()) that bodies get when they are
+ * added to a scene. Bodies already in the scene keep theirs, and
+ * body_set_motion() can still change any single body.
+ * Defaults to MOTION_FORCES.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param motion a combination of MotionFlags
+ */
+void scene_set_default_motion(Scene *scene, MotionFlags motion);
+
+/**
+ * Chooses how scene_tick() moves the scene's bodies that are moved by forces.
+ * Defaults to INTEGRATOR_AVERAGE_VELOCITY.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param integrator the integrator to use from the next tick on
+ */
+void scene_set_integrator(Scene *scene, Integrator integrator);
+
+/**
+ * Gets how scene_tick() moves the scene's bodies that are moved by forces.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the integrator passed to scene_set_integrator(), or
+ *   INTEGRATOR_AVERAGE_VELOCITY if it was not called
+ */
+Integrator scene_get_integrator(Scene *scene);
+
+/**
+ * Sets the error INTEGRATOR_ADAPTIVE allows per substep.
+ * A substep is rejected and retried with a smaller step if its estimated
+ * error in any body's position or velocity exceeds tolerance times one plus
+ * the size of that position or velocity. Defaults to 1e-6.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param tolerance the relative (and, for small values, absolute) error
+ *   to allow per substep
+ */
+void scene_set_tolerance(Scene *scene, double tolerance);
+
+/**
+ * Gets how many steps scene_tick() has taken since the scene was created:
+ * one per tick, or with INTEGRATOR_ADAPTIVE, each substep it accepted.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the number of steps taken
+ */
+size_t scene_steps_taken(Scene *scene);
+
+/**
+ * Gets how many substeps INTEGRATOR_ADAPTIVE has rejected and retried
+ * because their error was above the tolerance.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the number of steps rejected
+ */
+size_t scene_steps_rejected(Scene *scene);
+
 /**
  * Executes a tick of a given scene over a small time interval.
  * This requires executing all the force creators
- * and then ticking each body (see body_tick()).
+ * and then ticking each body according to its motion flags
+ * (see body_integrate()) and the scene's integrator
+ * (see scene_set_integrator()).
  * If any bodies are marked for removal, they should be removed from the scene
  * and freed, along with any force creators acting on them.
  *
@@ -169,6 +557,9 @@ void scene_add_special_body( Scene* scene, RGBColor color, List *points,
 void scene_tick(Scene *scene, double dt);
 
 /**
+ * @deprecated Give bodies MOTION_ACCELERATION (see scene_set_default_motion())
+ * and call scene_tick() instead, which moves each body's vertices only once
+ *
  * Executes a tick of a given scene over a small time interval
  * without forces. Just uses set acc/vels to update positions
  * of scene's bodies
@@ -9,6 +9,7 @@
 #include "sprite.h"
 #include "text.h"
 #include "game_info.h"
+#include "game_loop.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL2_gfxPrimitives.h>
 
@@ -94,6 +95,16 @@ void sdl_show(void);
  */
 void sdl_render_scene(Scene *scene);
 
+/**
+ * Draws all bodies in a scene between their last two physics states,
+ * as given by game_loop_alpha(). Like sdl_render_scene(), this internally
+ * calls sdl_clear() and sdl_show().
+ *
+ * @param scene the scene to draw
+ * @param loop the game loop that last ticked the scene
+ */
+void sdl_render_scene_interpolated(Scene *scene, GameLoop *loop);
+
 /**
  * Registers a function to be called every time a key is pressed.
  * Overwrites any existing handler.
@@ -0,0 +1,198 @@
+#ifndef __SOFT_BODY_H__
+#define __SOFT_BODY_H__
+
+#include "scene.h"
+
+/**
+ * The number of substeps a soft body splits each tick into,
+ * unless soft_body_set_substeps() changes it.
+ */
+#define SOFT_BODY_DEFAULT_SUBSTEPS 10
+
+/**
+ * A cloth or soft body: particles joined by constraints, which are simulated
+ * with extended position-based dynamics (XPBD, see
+ * https://matthias-research.github.io/pages/publications/XPBD.pdf).
+ *
+ * The particles are not bodies, so there can be many thousands of them.
+ * Each tick, after the scene's bodies move (see scene_add_constraint_batch()),
+ * a soft body splits scene_get_dt() into substeps. In each substep its
+ * particles fall under the scene's gravity, every constraint is solved once,
+ * and particles that end up inside one of its colliders are pushed out.
+ * The particles' velocities are then the distance they moved over the substep.
+ *
+ * A constraint's compliance is the inverse of its stiffness: 0 makes it rigid,
+ * and larger values let it stretch further under the same load, whatever
+ * the step. Constraints that share no particles are solved at the same time
+ * on the scene's threads (see scene_set_threads()), and the result does not
+ * depend on the number of threads.
+ */
+typedef struct softBody SoftBody;
+
+/**
+ * Adds a soft body with no particles to a scene.
+ *
+ * @param scene the scene to simulate the soft body in
+ * @return the new soft body, which the scene frees
+ */
+SoftBody *create_soft_body(Scene *scene);
+
+/**
+ * Adds a particle to a soft body, at rest.
+ *
+ * @param soft a soft body returned from create_soft_body()
+ * @param position where the particle starts
+ * @param mass the particle's mass, which must be positive
+ * @return the particle's index, which counts up from 0
+ */
+size_t soft_body_add_particle(SoftBody *soft, Vector position, double mass);
+
+/**
+ * Holds two particles at the distance they are apart now.
+ *
+ * @param soft a soft body returned from create_soft_body()
+ * @param particle1 the index of the first particle
+ * @param particle2 the index of the second particle
+ * @param compliance how easily the distance stretches, at least 0
+ */
+void soft_body_add_distance(
+    SoftBody *soft, size_t particle1, size_t particle2, double compliance
+);
+
+/**
+ * Holds the angle at particle2 between particle1 and particle3 at the
+ * angle it is now, so a line of particles resists being bent.
+ * Bends all the way around a loop whose distances are held too leave it
+ * with more constraints than it can move in, which a single pass per
+ * substep cannot keep stiff, so give those bends some compliance.
+ *
+ * @param soft a soft body returned from create_soft_body()
+ * @param particle1 the index of the particle on one side
+ * @param particle2 the index of the particle at the bend
+ * @param particle3 the index of the particle on the other side
+ * @param compliance how easily the angle bends, at least 0
+ */
+void soft_body_add_bending(
+    SoftBody *soft, size_t particle1, size_t particle2, size_t particle3,
+    double compliance
+);
+
+/**
+ * Holds the area enclosed by a loop of particles at the area it is now,
+ * like the pressure inside a ball. The loop is the particles from first to
+ * first + count - 1, in either order around the loop.
+ *
+ * @param soft a soft body returned from create_soft_body()
+ * @param first the index of the loop's first particle
+ * @param count the number of particles in the loop, at least 3
+ * @param compliance how easily the area changes, at least 0
+ */
+void soft_body_add_area(
+    SoftBody *soft, size_t first, size_t count, double compliance
+);
+
+/**
+ * Holds a particle where it is, as if it were infinitely massive.
+ *
+ * @param soft a soft body returned from create_soft_body()
+ * @param particle the index of the particle
+ */
+void soft_body_pin(SoftBody *soft, size_t particle);
+
+/**
+ * Keeps a soft body's particles out of a body's polygon,
+ * which must be convex. The body is not pushed back. A removed collider
+ * stops being checked.
+ *
+ * @param soft a soft body returned from create_soft_body()
+ * @param body a body in the soft body's scene
+ */
+void soft_body_add_collider(SoftBody *soft, Body *body);
+
+/**
+ * Sets how many substeps a soft body splits each tick into.
+ * More substeps make stiff constraints stiffer.
+ *
+ * @param soft a soft body returned from create_soft_body()
+ * @param substeps the number of substeps, at least 1
+ */
+void soft_body_set_substeps(SoftBody *soft, size_t substeps);
+
+/**
+ * Gets the number of particles in a soft body.
+ *
+ * @param soft a soft body returned from create_soft_body()
+ * @return the number of particles added with soft_body_add_particle()
+ */
+size_t soft_body_particles(SoftBody *soft);
+
+/**
+ * Gets where a particle of a soft body is.
+ *
+ * @param soft a soft body returned from create_soft_body()
+ * @param particle the index of the particle
+ * @return the particle's position
+ */
+Vector soft_body_get_position(SoftBody *soft, size_t particle);
+
+/**
+ * Gets how fast a particle of a soft body is moving.
+ *
+ * @param soft a soft body returned from create_soft_body()
+ * @param particle the index of the particle
+ * @return the particle's velocity
+ */
+Vector soft_body_get_velocity(SoftBody *soft, size_t particle);
+
+/**
+ * Sets how fast a particle of a soft body is moving.
+ * Pinned particles ignore their velocity.
+ *
+ * @param soft a soft body returned from create_soft_body()
+ * @param particle the index of the particle
+ * @param velocity the particle's new velocity
+ */
+void soft_body_set_velocity(SoftBody *soft, size_t particle, Vector velocity);
+
+/**
+ * Adds a rectangular cloth to a scene: a grid of particles, each held at
+ * its distance from its neighbours along the grid's rows and columns, with
+ * bending constraints along the rows and columns too. Particle
+ * row * columns + column starts at corner + (column, -row) * spacing, so
+ * row 0 is along the top; pin some of it with soft_body_pin() to hang it.
+ *
+ * @param scene the scene to simulate the cloth in
+ * @param corner where the first particle starts
+ * @param columns the number of particles along each row, at least 1
+ * @param rows the number of particles along each column, at least 1
+ * @param spacing the distance between neighbouring particles
+ * @param mass the mass of each particle
+ * @param compliance the compliance of the distances between neighbours
+ * @param bending_compliance the compliance of the bends along rows and columns
+ * @return the cloth, which the scene frees
+ */
+SoftBody *create_cloth(
+    Scene *scene, Vector corner, size_t columns, size_t rows, double spacing,
+    double mass, double compliance, double bending_compliance
+);
+
+/**
+ * Adds a soft ball to a scene: a ring of particles around a center, each
+ * held at its distance from its neighbours, which holds its area too, like
+ * a balloon. The particles go counterclockwise from the right of the center.
+ *
+ * @param scene the scene to simulate the ball in
+ * @param center the center of the ring
+ * @param radius the distance from the center to each particle
+ * @param count the number of particles, at least 3
+ * @param mass the mass of each particle
+ * @param compliance the compliance of the ring's distances
+ * @param area_compliance the compliance of the ball's area
+ * @return the ball, which the scene frees
+ */
+SoftBody *create_soft_ball(
+    Scene *scene, Vector center, double radius, size_t count, double mass,
+    double compliance, double area_compliance
+);
+
+#endif // #ifndef __SOFT_BODY_H__
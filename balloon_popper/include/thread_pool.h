@@ -0,0 +1,71 @@
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <stddef.h>
+
+/**
+ * A fixed set of worker threads that run parallel for loops.
+ * The workers are started once and wait between loops, so a loop costs a
+ * wake-up rather than creating threads. The thread that starts a loop works
+ * on it too, and returns only once every iteration has run.
+ * Iterations are handed out in chunks: whichever thread is free takes the
+ * next chunk, so uneven chunks do not leave threads idle.
+ */
+typedef struct threadPool ThreadPool;
+
+/**
+ * A function that runs iterations [start, end) of a parallel for loop.
+ * Different calls may run at the same time, so a function must only write
+ * to memory that belongs to its own iterations, or to its own thread.
+ *
+ * @param aux the aux passed to thread_pool_for()
+ * @param start the first iteration to run
+ * @param end one past the last iteration to run
+ * @param thread which of the pool's threads is running the chunk,
+ *   from 0 (the calling thread) to thread_pool_threads() - 1
+ */
+typedef void (*ParallelFunc)(void *aux, size_t start, size_t end, size_t thread);
+
+/**
+ * Allocates a thread pool and starts its workers.
+ *
+ * @param threads how many threads run each loop, counting the calling
+ *   thread, so a pool of 1 thread starts no workers and runs loops serially
+ * @return the new thread pool
+ */
+ThreadPool *thread_pool_init(size_t threads);
+
+/**
+ * Stops a thread pool's workers and releases its memory.
+ *
+ * @param pool a pointer to a thread pool returned from thread_pool_init()
+ */
+void thread_pool_free(ThreadPool *pool);
+
+/**
+ * Gets how many threads run each loop, counting the calling thread.
+ *
+ * @param pool a pointer to a thread pool returned from thread_pool_init()
+ * @return the number of threads passed to thread_pool_init()
+ */
+size_t thread_pool_threads(ThreadPool *pool);
+
+/**
+ * Runs iterations [0, count) of a loop on the pool's threads, in chunks of
+ * the given size, and waits for them all to finish.
+ * A loop of only one chunk runs on the calling thread without waking the
+ * workers, so small loops cost no more than a plain for loop.
+ * Only one thread may start loops on a pool at a time.
+ *
+ * @param pool a pointer to a thread pool returned from thread_pool_init(),
+ *   or NULL to run the loop serially
+ * @param count the number of iterations
+ * @param chunk how many iterations each call to func runs, at most
+ * @param func the function that runs each chunk
+ * @param aux the value to pass to func
+ */
+void thread_pool_for(
+    ThreadPool *pool, size_t count, size_t chunk, ParallelFunc func, void *aux
+);
+
+#endif // #ifndef __THREAD_POOL_H__
@@ -21,6 +21,16 @@ void initialize_window(Vector dimensions);
  */
 Scene* initialize_scene(void);
 
+/**
+ * Makes the shape functions below allocate their vertex lists and vertices
+ * from an allocator, e.g. arena_allocator(scene_get_arena(scene)), so that
+ * shapes are dropped along with the rest of the arena.
+ *
+ * @param allocator the allocator to allocate shapes from,
+ *   or NULL for allocator_global()
+ */
+void utils_set_shape_allocator(const Allocator *allocator);
+
 /**
 * Gets the points of an arrow given a pivot, width, height, and length
 *
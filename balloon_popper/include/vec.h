@@ -0,0 +1,157 @@
+#ifndef __VEC_H__
+#define __VEC_H__
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+#include "allocator.h"
+
+/*
+ * Typed growable arrays that store their elements inline, unlike List,
+ * which stores void pointers. DEFINE_VEC(Vector) defines the struct VectorVec
+ * and functions VectorVec_init(), VectorVec_push(), etc. below.
+ * DEFINE_VEC_NAMED(BodyPtrVec, Body *) does the same for types whose names
+ * cannot be pasted, such as pointers.
+ *
+ * The struct's fields may be read directly: data holds the size elements.
+ * VEC_AT() accesses an element without a bounds check unless VEC_CHECKED is
+ * defined (as it is in the debug build), so hot loops pay nothing for it in
+ * optimized builds.
+ */
+
+#ifdef VEC_CHECKED
+/** Asserts that an index is in bounds, evaluating it only once */
+static inline size_t vec_checked_index(size_t index, size_t size) {
+    assert(index < size);
+    return index;
+}
+#define VEC_AT(vec, index) \
+    ((vec)->data[vec_checked_index((index), (vec)->size)])
+#else
+#define VEC_AT(vec, index) ((vec)->data[(index)])
+#endif
+
+/**
+ * Loops over the elements of a vector in order, with item pointing at each.
+ * The vector must not grow or shrink inside the loop.
+ *
+ * @param T the element type of the vector
+ * @param item the name of the T* loop variable
+ * @param vec a pointer to the vector
+ */
+#define VEC_FOREACH(T, item, vec) \
+    for (T *item = (vec)->data; item < (vec)->data + (vec)->size; item++)
+
+#define DEFINE_VEC(T) DEFINE_VEC_NAMED(T##Vec, T)
+
+#define DEFINE_VEC_NAMED(Name, T) \
+typedef struct { \
+    T *data; \
+    size_t size; \
+    size_t capacity; \
+    const Allocator *allocator; \
+} Name; \
+\
+/** Initializes an empty vector that allocates from an allocator */ \
+static inline void Name##_init(Name *vec, const Allocator *allocator) { \
+    assert(vec); \
+    assert(allocator); \
+    vec->data = NULL; \
+    vec->size = 0; \
+    vec->capacity = 0; \
+    vec->allocator = allocator; \
+} \
+\
+/** Releases a vector's memory. Its elements are not finalized. */ \
+static inline void Name##_free(Name *vec) { \
+    assert(vec); \
+    allocator_free(vec->allocator, vec->data); \
+    Name##_init(vec, vec->allocator); \
+} \
+\
+/** Makes room for at least capacity elements without further allocation */ \
+static inline void Name##_reserve(Name *vec, size_t capacity) { \
+    assert(vec); \
+    if (capacity <= vec->capacity) { \
+        return; \
+    } \
+    vec->data = allocator_realloc(vec->allocator, vec->data, \
+        capacity * sizeof(T)); \
+    vec->capacity = capacity; \
+} \
+\
+/** Releases any capacity beyond the vector's current size */ \
+static inline void Name##_shrink(Name *vec) { \
+    assert(vec); \
+    if (vec->size == vec->capacity) { \
+        return; \
+    } \
+    if (vec->size == 0) { \
+        Name##_free(vec); \
+        return; \
+    } \
+    vec->data = allocator_realloc(vec->allocator, vec->data, \
+        vec->size * sizeof(T)); \
+    vec->capacity = vec->size; \
+} \
+\
+/** Appends an element, doubling the capacity if the vector is full */ \
+static inline void Name##_push(Name *vec, T value) { \
+    assert(vec); \
+    if (vec->size == vec->capacity) { \
+        Name##_reserve(vec, vec->capacity ? 2 * vec->capacity : 4); \
+    } \
+    vec->data[vec->size++] = value; \
+} \
+\
+/** Gets the element at an index, asserting that the index is valid */ \
+static inline T Name##_get(const Name *vec, size_t index) { \
+    assert(vec); \
+    assert(index < vec->size); \
+    return vec->data[index]; \
+} \
+\
+/** Sets the element at an index, asserting that the index is valid */ \
+static inline void Name##_set(Name *vec, size_t index, T value) { \
+    assert(vec); \
+    assert(index < vec->size); \
+    vec->data[index] = value; \
+} \
+\
+/** Removes and returns the last element */ \
+static inline T Name##_pop(Name *vec) { \
+    assert(vec); \
+    assert(vec->size > 0); \
+    return vec->data[--vec->size]; \
+} \
+\
+/** \
+ * Removes and returns the element at an index in constant time \
+ * by moving the last element into its place, so order is not kept. \
+ */ \
+static inline T Name##_swap_remove(Name *vec, size_t index) { \
+    assert(vec); \
+    assert(index < vec->size); \
+    T removed = vec->data[index]; \
+    vec->data[index] = vec->data[--vec->size]; \
+    return removed; \
+} \
+\
+/** Removes and returns the element at an index, keeping the others' order */ \
+static inline T Name##_remove(Name *vec, size_t index) { \
+    assert(vec); \
+    assert(index < vec->size); \
+    T removed = vec->data[index]; \
+    vec->size--; \
+    memmove(&vec->data[index], &vec->data[index + 1], \
+        (vec->size - index) * sizeof(T)); \
+    return removed; \
+} \
+\
+/** Removes every element, keeping the capacity */ \
+static inline void Name##_clear(Name *vec) { \
+    assert(vec); \
+    vec->size = 0; \
+}
+
+#endif // #ifndef __VEC_H__
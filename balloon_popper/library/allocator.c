@@ -0,0 +1,61 @@
+#include "allocator.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+void *heap_alloc(void *context, size_t size) {
+    return malloc(size);
+}
+
+void *heap_realloc(void *context, void *block, size_t size) {
+    return realloc(block, size);
+}
+
+void heap_free(void *context, void *block) {
+    free(block);
+}
+
+const Allocator HEAP_ALLOCATOR = {
+    .alloc = heap_alloc,
+    .realloc = heap_realloc,
+    .free = heap_free,
+    .context = NULL
+};
+
+const Allocator *global_allocator = &HEAP_ALLOCATOR;
+
+const Allocator *allocator_heap(void) {
+    return &HEAP_ALLOCATOR;
+}
+
+const Allocator *allocator_global(void) {
+    return global_allocator;
+}
+
+void allocator_set_global(const Allocator *allocator) {
+    global_allocator = allocator ? allocator : &HEAP_ALLOCATOR;
+}
+
+void *allocator_alloc(const Allocator *allocator, size_t size) {
+    assert(allocator);
+    void *block = allocator->alloc(allocator->context, size);
+    assert(block);
+    return block;
+}
+
+void *allocator_realloc(const Allocator *allocator, void *block, size_t size) {
+    assert(allocator);
+    block = allocator->realloc(allocator->context, block, size);
+    assert(block);
+    return block;
+}
+
+void allocator_free(const Allocator *allocator, void *block) {
+    assert(allocator);
+    allocator->free(allocator->context, block);
+}
+
+void allocator_owned(void *block) {
+    // Containers free these elements through their allocator instead
+    assert(false);
+}
@@ -0,0 +1,260 @@
+#include "arena.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Blocks up to this size come in multiples of ARENA_SMALL_STEP bytes
+#define ARENA_SMALL_LIMIT 256
+#define ARENA_SMALL_STEP 16
+#define ARENA_SMALL_CLASSES (ARENA_SMALL_LIMIT / ARENA_SMALL_STEP)
+// Larger blocks come in powers of two up to 2^ARENA_MAX_SHIFT bytes
+#define ARENA_MAX_SHIFT 24
+#define ARENA_LARGE_CLASSES (ARENA_MAX_SHIFT - 8)
+#define ARENA_CLASSES (ARENA_SMALL_CLASSES + ARENA_LARGE_CLASSES)
+#define ARENA_ALIGNMENT sizeof(double)
+
+/**
+ * The blocks of one size.
+ * Every block is preceded by a pointer to its class, which is how
+ * arena_release() finds the arena without being told.
+ * Released blocks are threaded into a free list through their own storage.
+ */
+typedef struct arenaClass {
+    struct arena *arena;
+    size_t size;
+    void *free_blocks;
+} ArenaClass;
+
+/**
+ * A region of memory requested from the heap.
+ * Its data immediately follows the header in the same allocation.
+ */
+typedef struct arenaChunk {
+    struct arenaChunk *next;
+    size_t size;
+} ArenaChunk;
+
+struct arena {
+    ArenaClass classes[ARENA_CLASSES];
+    ArenaChunk *first_chunk;
+    ArenaChunk *last_chunk;
+    // Chunk new blocks are currently carved from, and how much of it is used
+    ArenaChunk *current_chunk;
+    size_t used;
+    size_t chunk_size;
+    size_t chunk_count;
+    // Where the arena and its chunks come from
+    const Allocator *backing;
+    // The interface other code allocates from this arena through
+    Allocator allocator;
+};
+
+/** Gets the size of the blocks in the class with the given index */
+size_t arena_class_size(size_t index) {
+    if (index < ARENA_SMALL_CLASSES) {
+        return (index + 1) * ARENA_SMALL_STEP;
+    }
+    return (size_t) 1 << (index - ARENA_SMALL_CLASSES + 9);
+}
+
+void *arena_allocator_alloc(void *context, size_t size) {
+    return arena_alloc(context, size);
+}
+
+void *arena_allocator_realloc(void *context, void *block, size_t size) {
+    return arena_realloc(context, block, size);
+}
+
+void arena_allocator_free(void *context, void *block) {
+    arena_release(block);
+}
+
+Arena *arena_init(size_t chunk_size) {
+    return arena_init_with_allocator(allocator_global(), chunk_size);
+}
+
+Arena *arena_init_with_allocator(
+    const Allocator *allocator, size_t chunk_size
+) {
+    assert(allocator);
+    assert(chunk_size > 0);
+    Arena *arena = allocator_alloc(allocator, sizeof(Arena));
+    for (size_t i = 0; i < ARENA_CLASSES; i++) {
+        ArenaClass *class = &arena->classes[i];
+        class->arena = arena;
+        class->size = arena_class_size(i);
+        class->free_blocks = NULL;
+    }
+    arena->first_chunk = NULL;
+    arena->last_chunk = NULL;
+    arena->current_chunk = NULL;
+    arena->used = 0;
+    arena->chunk_size = chunk_size;
+    arena->chunk_count = 0;
+    arena->backing = allocator;
+    arena->allocator = (Allocator) {
+        .alloc = arena_allocator_alloc,
+        .realloc = arena_allocator_realloc,
+        .free = arena_allocator_free,
+        .context = arena
+    };
+    return arena;
+}
+
+void arena_free(Arena *arena) {
+    assert(arena);
+    ArenaChunk *chunk = arena->first_chunk;
+    while (chunk) {
+        ArenaChunk *next = chunk->next;
+        allocator_free(arena->backing, chunk);
+        chunk = next;
+    }
+    allocator_free(arena->backing, arena);
+}
+
+char *chunk_data(ArenaChunk *chunk) {
+    return (char *) (chunk + 1);
+}
+
+/** Gets the index of the smallest class that holds blocks of a size */
+size_t arena_class_index(size_t size) {
+    if (size <= ARENA_SMALL_LIMIT) {
+        return (size + ARENA_SMALL_STEP - 1) / ARENA_SMALL_STEP - 1;
+    }
+    size_t index = ARENA_SMALL_CLASSES;
+    while (arena_class_size(index) < size) {
+        index++;
+        assert(index < ARENA_CLASSES);
+    }
+    return index;
+}
+
+size_t round_to_alignment(size_t bytes) {
+    return (bytes + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+}
+
+/**
+ * Takes the next bytes off the current chunk,
+ * moving on to the next chunk (or a new one) if they do not fit.
+ */
+void *arena_bump(Arena *arena, size_t bytes) {
+    bytes = round_to_alignment(bytes);
+    while (arena->current_chunk && \
+        arena->used + bytes > arena->current_chunk->size) {
+        arena->current_chunk = arena->current_chunk->next;
+        arena->used = 0;
+    }
+    if (!arena->current_chunk) {
+        size_t size = bytes > arena->chunk_size ? bytes : arena->chunk_size;
+        ArenaChunk *chunk = allocator_alloc(arena->backing, \
+            sizeof(ArenaChunk) + size);
+        chunk->next = NULL;
+        chunk->size = size;
+        if (arena->last_chunk) {
+            arena->last_chunk->next = chunk;
+        } else {
+            arena->first_chunk = chunk;
+        }
+        arena->last_chunk = chunk;
+        arena->current_chunk = chunk;
+        arena->chunk_count++;
+    }
+    void *memory = chunk_data(arena->current_chunk) + arena->used;
+    arena->used += bytes;
+    return memory;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+    assert(arena);
+    assert(size > 0);
+    ArenaClass *class = &arena->classes[arena_class_index(size)];
+    void *block = class->free_blocks;
+    if (block) {
+        class->free_blocks = *(void **) block;
+        return block;
+    }
+    ArenaClass **header = arena_bump(arena, sizeof(ArenaClass *) + class->size);
+    *header = class;
+    return header + 1;
+}
+
+void *arena_realloc(Arena *arena, void *block, size_t size) {
+    assert(arena);
+    if (!block) {
+        return arena_alloc(arena, size);
+    }
+    ArenaClass *class = ((ArenaClass **) block)[-1];
+    assert(class->arena == arena);
+    if (size <= class->size) {
+        return block;
+    }
+    void *resized = arena_alloc(arena, size);
+    memcpy(resized, block, class->size);
+    arena_release(block);
+    return resized;
+}
+
+void arena_release(void *block) {
+    if (!block) {
+        return;
+    }
+    ArenaClass *class = ((ArenaClass **) block)[-1];
+    *(void **) block = class->free_blocks;
+    class->free_blocks = block;
+}
+
+size_t arena_footprint(size_t size) {
+    assert(size > 0);
+    return round_to_alignment(sizeof(ArenaClass *) + \
+        arena_class_size(arena_class_index(size)));
+}
+
+void arena_reserve(Arena *arena, size_t bytes) {
+    assert(arena);
+    if (bytes == 0) {
+        return;
+    }
+    // Move to a chunk with enough room, then give the room back
+    arena_bump(arena, bytes);
+    arena->used -= round_to_alignment(bytes);
+}
+
+void arena_reset(Arena *arena) {
+    assert(arena);
+    for (size_t i = 0; i < ARENA_CLASSES; i++) {
+        arena->classes[i].free_blocks = NULL;
+    }
+    arena->current_chunk = arena->first_chunk;
+    arena->used = 0;
+}
+
+bool chunk_contains(ArenaChunk *chunk, uintptr_t address) {
+    uintptr_t start = (uintptr_t) chunk_data(chunk);
+    return start <= address && address < start + chunk->size;
+}
+
+bool arena_contains(Arena *arena, const void *memory) {
+    assert(arena);
+    uintptr_t address = (uintptr_t) memory;
+    // Memory is usually checked right after it is allocated
+    if (arena->current_chunk && chunk_contains(arena->current_chunk, address)) {
+        return true;
+    }
+    for (ArenaChunk *chunk = arena->first_chunk; chunk; chunk = chunk->next) {
+        if (chunk_contains(chunk, address)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const Allocator *arena_allocator(Arena *arena) {
+    assert(arena);
+    return &arena->allocator;
+}
+
+size_t arena_chunks(Arena *arena) {
+    assert(arena);
+    return arena->chunk_count;
+}
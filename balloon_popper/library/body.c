@@ -5,78 +5,149 @@
 #include "test_util.h"
 #include <stdio.h>
 
-struct body {
-    List *points;
-    Vector *velocity;
-    Vector *acceleration;
-    Vector *centroid;
-    Vector *elasticity;
-    Vector *forces;
-    Vector *impulses;
+#define NUMBER_STARTING_ARRAY_BODIES 16
+
+/*
+ * Fields only read for drawing, by game logic or by collision handlers.
+ * They are kept out of struct body so the fields every tick touches
+ * pack more bodies into each cache line.
+ */
+typedef struct bodyCold {
     void *info;
     FreeFunc info_freer;
+    // The allocator a heap body came from, or NULL if it was given memory
+    const Allocator *allocator;
+    Body* other;
+    double time_since_last_collision;
+    double max_displacement;
+    Vector elasticity;
     RGBColor color;
+} BodyCold;
+
+/*
+ * Vector state is stored inline rather than behind pointers, so creating a
+ * body costs a single allocation and the getters used every tick read
+ * straight out of the body.
+ * While the body is attached to BodyArrays, its position, velocity, forces and
+ * impulses are read from the arrays instead, and centroid only records where
+ * the vertices currently are.
+ */
+struct body {
+    List *points;
+    Vector velocity;
+    Vector acceleration;
+    Vector centroid;
+    Vector forces;
+    Vector impulses;
     double mass;
     double angle;
-    Body* other;
-    double time_since_last_collision;
+    BodyArrays *arrays;
+    size_t array_index;
+    BodyCold *cold;
+    // Stored narrowly so these fit without growing the record
+    uint8_t role;
+    uint8_t existence;
+    uint8_t type;
+    uint8_t asleep;
+    // How many ticks in a row body_update_sleep() has found the body at rest
+    uint8_t rest_ticks;
+    uint8_t motion;
+    BodyHandle handle;
+    float gravity_scale;
 };
 
-struct bodyInfo {
-    void* info;
-    int existence;
-};
+// Where body_add_force() and body_add_impulse() add to on this thread,
+// or NULL for the bodies themselves
+_Thread_local ForceBuffer *force_redirect = NULL;
 
 Body *body_init(List *shape, double mass, RGBColor color) {
     return body_init_with_info(shape, mass, color, NULL, free);
 }
 
-BodyInfo* body_info_init(void* info) {
-    BodyInfo* b_i = malloc(sizeof(BodyInfo));
-    assert(b_i);
-    b_i->info = info;
-    b_i->existence = NOT_REMOVED;
-    return b_i;
+size_t body_size(void) {
+    return sizeof(Body);
+}
+
+size_t body_cold_size(void) {
+    return sizeof(BodyCold);
 }
 
 Body *body_init_with_info(
     List *shape, double mass, RGBColor color, void *info, FreeFunc info_freer
 ) {
+    // Heap bodies keep their cold fields in the same allocation
+    const Allocator *allocator = allocator_global();
+    Body *body = allocator_alloc(allocator, sizeof(Body) + sizeof(BodyCold));
+    body_init_at(body, body + 1, shape, mass, color, info, info_freer);
+    body->cold->allocator = allocator;
+    return body;
+}
+
+Body *body_init_at(
+    void *memory,
+    void *cold_memory,
+    List *shape,
+    double mass,
+    RGBColor color,
+    void *info,
+    FreeFunc info_freer
+) {
+    assert(memory);
+    assert(cold_memory);
     assert(mass > 0);
-    Body *body = malloc(sizeof(Body));
-    assert(body);
+    Body *body = memory;
+    BodyCold *cold = cold_memory;
     body->points = shape;
-    body->velocity = create_vector_p(VEC_ZERO);
-    body->acceleration = create_vector_p(VEC_ZERO);
-    body->elasticity = create_vector_p(VEC_ZERO);
-    body->centroid = create_vector_p(body_calculate_centroid(body));
-    body->forces = create_vector_p(VEC_ZERO);
-    body->impulses = create_vector_p(VEC_ZERO);
-    body->other = NULL;
-    BodyInfo* b_i = body_info_init(info);
-    body->info = b_i;
-    body->info_freer = info_freer;
-    body->color = color;
+    body->velocity = VEC_ZERO;
+    body->acceleration = VEC_ZERO;
+    body->centroid = body_calculate_centroid(body);
+    body->forces = VEC_ZERO;
+    body->impulses = VEC_ZERO;
+    body->cold = cold;
+    cold->elasticity = VEC_ZERO;
+    cold->other = NULL;
+    cold->info = info;
+    cold->info_freer = info_freer;
+    cold->allocator = NULL;
+    // Bodies that carry info have always stored their role at its start
+    body->role = info ? *(Role *) info : NEVER_REMOVE_ON_COLLISION;
+    body->existence = NOT_REMOVED;
+    body->type = BODY_DYNAMIC;
+    body->asleep = false;
+    body->rest_ticks = 0;
+    cold->color = color;
     body->mass = mass;
     body->angle = 0;
-    body->time_since_last_collision = 1;
+    cold->time_since_last_collision = 1;
+    cold->max_displacement = INFINITY;
+    body->handle = BODY_HANDLE_NULL;
+    body->motion = MOTION_FORCES;
+    body->gravity_scale = 1;
+    body->arrays = NULL;
+    body->array_index = 0;
     return body;
 }
 
 void body_free(void *b) {
-    assert(b);
-    Body* body = b;
+    Body *body = b;
+    const Allocator *allocator = body->cold->allocator;
+    assert(allocator);
+    body_destroy(body);
+    allocator_free(allocator, body);
+}
+
+void body_destroy(Body *body) {
+    assert(body);
+    body_detach_arrays(body);
     list_free(body->points);
-    vector_free(body->velocity);
-    vector_free(body->acceleration);
-    vector_free(body->forces);
-    vector_free(body->impulses);
-    vector_free(body->elasticity);
-    vector_free(body->centroid);
-    BodyInfo* i = body->info;
-    body->info_freer(i->info);
-    free(i);
-    free(body);
+    if (body->cold->info_freer) {
+        body->cold->info_freer(body->cold->info);
+    }
+}
+
+void *body_get_cold_memory(Body *body) {
+    assert(body);
+    return body->cold;
 }
 
 List *body_get_shape(Body *body) {
@@ -86,7 +157,7 @@ List *body_get_shape(Body *body) {
 
 void *body_get_info(Body *body) {
     assert(body);
-    return ((BodyInfo*)(body->info))->info;
+    return body->cold->info;
 }
 
 double body_get_angle(Body *body) {
@@ -96,22 +167,52 @@ double body_get_angle(Body *body) {
 
 Vector body_get_elasticity(Body *body) {
     assert(body);
-    return *body->elasticity;
+    return body->cold->elasticity;
 }
 
 Vector body_get_centroid(Body *body) {
     assert(body);
-    return *body->centroid;
+    BodyArrays *arrays = body->arrays;
+    if (arrays) {
+        size_t i = body->array_index;
+        return vec_init(arrays->pos_x[i], arrays->pos_y[i]);
+    }
+    return body->centroid;
 }
 
 Vector body_get_velocity(Body *body) {
     assert(body);
-    return *body->velocity;
+    BodyArrays *arrays = body->arrays;
+    if (arrays) {
+        size_t i = body->array_index;
+        return vec_init(arrays->vel_x[i], arrays->vel_y[i]);
+    }
+    return body->velocity;
+}
+
+Vector body_get_force(Body *body) {
+    assert(body);
+    BodyArrays *arrays = body->arrays;
+    if (arrays) {
+        size_t i = body->array_index;
+        return vec_init(arrays->force_x[i], arrays->force_y[i]);
+    }
+    return body->forces;
+}
+
+Vector body_get_impulse(Body *body) {
+    assert(body);
+    BodyArrays *arrays = body->arrays;
+    if (arrays) {
+        size_t i = body->array_index;
+        return vec_init(arrays->impulse_x[i], arrays->impulse_y[i]);
+    }
+    return body->impulses;
 }
 
 Vector body_get_acceleration(Body *body) {
     assert(body);
-    return *body->acceleration;
+    return body->acceleration;
 }
 
 double body_get_mass(Body *body) {
@@ -121,44 +222,61 @@ double body_get_mass(Body *body) {
 
 RGBColor body_get_color(Body *body) {
     assert(body);
-    return body->color;
+    return body->cold->color;
 }
 
 Role body_get_role(Body *body) {
     assert(body);
-    return *((Role*)(((BodyInfo*)(body->info))->info));
+    return body->role;
 }
 
 double body_get_time_since_last_collision(Body *body) {
   assert(body);
-  return body->time_since_last_collision;
+  return body->cold->time_since_last_collision;
 }
 
 void body_set_centroid(Body *body, Vector new_centroid) {
     assert(body);
-    Vector diff = vec_subtract(new_centroid, *(body->centroid));
+    Vector diff = vec_subtract(new_centroid, body->centroid);
 
-    *(body->centroid) = new_centroid;
+    body->centroid = new_centroid;
+    if (body->arrays) {
+        body->arrays->pos_x[body->array_index] = new_centroid.x;
+        body->arrays->pos_y[body->array_index] = new_centroid.y;
+    }
 
+    // Vertices are moved in place rather than replaced with new allocations
     for (size_t i = 0; i < list_size(body->points); i++) {
-        list_set(body_get_shape(body), i, create_vector_p(vec_add(diff, \
-            *(Vector *)list_get(body_get_shape(body), i))));
+        Vector *vertex = list_get(body->points, i);
+        *vertex = vec_add(diff, *vertex);
     }
 }
 
 void body_set_elasticity(Body *body, Vector v) {
     assert(body);
-    *(body->elasticity) = v;
+    body->cold->elasticity = v;
 }
 
 void body_set_acceleration(Body *body, Vector v) {
     assert(body);
-    *(body->acceleration) = v;
+    if (body->asleep) {
+        body_wake(body);
+    }
+    body->acceleration = v;
 }
 
 void body_set_velocity(Body *body, Vector v) {
     assert(body);
-    *(body->velocity) = v;
+    if (body->asleep) {
+        body_wake(body);
+    }
+    BodyArrays *arrays = body->arrays;
+    if (arrays) {
+        arrays->vel_x[body->array_index] = v.x;
+        arrays->vel_y[body->array_index] = v.y;
+        return;
+    }
+    body->velocity = v;
 }
 
 void body_set_rotation_custom(Body *body, double angle, Vector pivot) {
@@ -177,8 +295,7 @@ void body_set_rotation_custom(Body *body, double angle, Vector pivot) {
             */
         Vector v_i_origin = vec_subtract(*v_i, pivot);
         Vector v_i_origin_rotate = vec_rotate(v_i_origin, diff);
-        Vector rotated_vec = vec_add(v_i_origin_rotate, pivot);
-        list_set(points_list, i, create_vector_p(rotated_vec));
+        *v_i = vec_add(v_i_origin_rotate, pivot);
     }
     body->angle = angle;
 }
@@ -189,32 +306,285 @@ void body_set_rotation(Body *body, double angle) {
 
 void body_set_force(Body *body, Vector force) {
     assert(body);
-    *(body->forces) = force;
+    if (body->asleep) {
+        body_wake(body);
+    }
+    BodyArrays *arrays = body->arrays;
+    if (arrays) {
+        arrays->force_x[body->array_index] = force.x;
+        arrays->force_y[body->array_index] = force.y;
+        return;
+    }
+    body->forces = force;
 }
 
 void body_set_impulse(Body *body, Vector impulse) {
     assert(body);
-    *(body->impulses)= impulse;
+    BodyArrays *arrays = body->arrays;
+    if (arrays) {
+        arrays->impulse_x[body->array_index] = impulse.x;
+        arrays->impulse_y[body->array_index] = impulse.y;
+        return;
+    }
+    body->impulses = impulse;
+}
+
+BodyHandle body_get_handle(Body *body) {
+    assert(body);
+    return body->handle;
+}
+
+void body_set_handle(Body *body, BodyHandle handle) {
+    assert(body);
+    body->handle = handle;
+}
+
+void body_arrays_init(BodyArrays *arrays, const Allocator *allocator) {
+    assert(arrays);
+    assert(allocator);
+    arrays->pos_x = NULL;
+    arrays->pos_y = NULL;
+    arrays->vel_x = NULL;
+    arrays->vel_y = NULL;
+    arrays->force_x = NULL;
+    arrays->force_y = NULL;
+    arrays->impulse_x = NULL;
+    arrays->impulse_y = NULL;
+    arrays->inv_mass = NULL;
+    arrays->gravity_scale = NULL;
+    arrays->bodies = NULL;
+    arrays->size = 0;
+    arrays->capacity = 0;
+    arrays->allocator = allocator;
+}
+
+void body_arrays_free(BodyArrays *arrays) {
+    assert(arrays);
+    assert(arrays->size == 0);
+    const Allocator *allocator = arrays->allocator;
+    allocator_free(allocator, arrays->pos_x);
+    allocator_free(allocator, arrays->pos_y);
+    allocator_free(allocator, arrays->vel_x);
+    allocator_free(allocator, arrays->vel_y);
+    allocator_free(allocator, arrays->force_x);
+    allocator_free(allocator, arrays->force_y);
+    allocator_free(allocator, arrays->impulse_x);
+    allocator_free(allocator, arrays->impulse_y);
+    allocator_free(allocator, arrays->inv_mass);
+    allocator_free(allocator, arrays->gravity_scale);
+    allocator_free(allocator, arrays->bodies);
+    body_arrays_init(arrays, allocator);
+}
+
+double *resize_array(
+    const Allocator *allocator, double *array, size_t capacity
+) {
+    return allocator_realloc(allocator, array, capacity * sizeof(double));
+}
+
+void body_arrays_grow(BodyArrays *arrays) {
+    size_t capacity = arrays->capacity ? \
+        arrays->capacity * 2 : NUMBER_STARTING_ARRAY_BODIES;
+    const Allocator *allocator = arrays->allocator;
+    arrays->pos_x = resize_array(allocator, arrays->pos_x, capacity);
+    arrays->pos_y = resize_array(allocator, arrays->pos_y, capacity);
+    arrays->vel_x = resize_array(allocator, arrays->vel_x, capacity);
+    arrays->vel_y = resize_array(allocator, arrays->vel_y, capacity);
+    arrays->force_x = resize_array(allocator, arrays->force_x, capacity);
+    arrays->force_y = resize_array(allocator, arrays->force_y, capacity);
+    arrays->impulse_x = resize_array(allocator, arrays->impulse_x, capacity);
+    arrays->impulse_y = resize_array(allocator, arrays->impulse_y, capacity);
+    arrays->inv_mass = resize_array(allocator, arrays->inv_mass, capacity);
+    arrays->gravity_scale = resize_array(allocator, arrays->gravity_scale, \
+        capacity);
+    arrays->bodies = allocator_realloc(allocator, arrays->bodies, \
+        capacity * sizeof(Body *));
+    arrays->capacity = capacity;
+}
+
+/**
+ * Gets the motion flags that apply to a body given its type:
+ * kinematic bodies only follow their acceleration, and static and sleeping
+ * ones never move.
+ */
+MotionFlags body_effective_motion(Body *body) {
+    if (body->asleep) {
+        return 0;
+    }
+    switch ((BodyType) body->type) {
+        case BODY_DYNAMIC:
+            return body->motion;
+        case BODY_KINEMATIC:
+            return MOTION_ACCELERATION;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Gets the inverse mass body_arrays_tick() integrates a body with.
+ * It is 0 for bodies that forces do not move, which keeps them in place,
+ * and for bodies the scene substeps itself.
+ */
+double body_arrays_inv_mass(Body *body) {
+    if (!(body_effective_motion(body) & MOTION_FORCES)
+            || (body->motion & MOTION_SUBSTEP)) {
+        return 0;
+    }
+    // 1 / INFINITY is 0, which keeps immovable bodies in place
+    return 1 / body->mass;
+}
+
+void body_attach_arrays(Body *body, BodyArrays *arrays) {
+    assert(body);
+    assert(arrays);
+    assert(!body->arrays);
+    if (arrays->size == arrays->capacity) {
+        body_arrays_grow(arrays);
+    }
+    size_t i = arrays->size++;
+    arrays->pos_x[i] = body->centroid.x;
+    arrays->pos_y[i] = body->centroid.y;
+    arrays->vel_x[i] = body->velocity.x;
+    arrays->vel_y[i] = body->velocity.y;
+    arrays->force_x[i] = body->forces.x;
+    arrays->force_y[i] = body->forces.y;
+    arrays->impulse_x[i] = body->impulses.x;
+    arrays->impulse_y[i] = body->impulses.y;
+    arrays->inv_mass[i] = body_arrays_inv_mass(body);
+    arrays->gravity_scale[i] = body->gravity_scale;
+    arrays->bodies[i] = body;
+    body->arrays = arrays;
+    body->array_index = i;
+}
+
+void body_detach_arrays(Body *body) {
+    assert(body);
+    BodyArrays *arrays = body->arrays;
+    if (!arrays) {
+        return;
+    }
+    size_t i = body->array_index;
+    body->centroid = vec_init(arrays->pos_x[i], arrays->pos_y[i]);
+    body->velocity = vec_init(arrays->vel_x[i], arrays->vel_y[i]);
+    body->forces = vec_init(arrays->force_x[i], arrays->force_y[i]);
+    body->impulses = vec_init(arrays->impulse_x[i], arrays->impulse_y[i]);
+    body->arrays = NULL;
+
+    // Fill the hole with the last body so the arrays stay dense
+    size_t last = --arrays->size;
+    if (i != last) {
+        arrays->pos_x[i] = arrays->pos_x[last];
+        arrays->pos_y[i] = arrays->pos_y[last];
+        arrays->vel_x[i] = arrays->vel_x[last];
+        arrays->vel_y[i] = arrays->vel_y[last];
+        arrays->force_x[i] = arrays->force_x[last];
+        arrays->force_y[i] = arrays->force_y[last];
+        arrays->impulse_x[i] = arrays->impulse_x[last];
+        arrays->impulse_y[i] = arrays->impulse_y[last];
+        arrays->inv_mass[i] = arrays->inv_mass[last];
+        arrays->gravity_scale[i] = arrays->gravity_scale[last];
+        arrays->bodies[i] = arrays->bodies[last];
+        arrays->bodies[i]->array_index = i;
+    }
+}
+
+void body_arrays_tick(BodyArrays *arrays, Vector gravity, double dt) {
+    assert(arrays);
+    body_arrays_tick_range(arrays, 0, arrays->size, gravity, dt);
+}
+
+void body_arrays_tick_range(
+    BodyArrays *arrays, size_t start, size_t end, Vector gravity, double dt
+) {
+    assert(arrays);
+    assert(start <= end && end <= arrays->size);
+    double *restrict pos_x = arrays->pos_x;
+    double *restrict pos_y = arrays->pos_y;
+    double *restrict vel_x = arrays->vel_x;
+    double *restrict vel_y = arrays->vel_y;
+    const double *restrict force_x = arrays->force_x;
+    const double *restrict force_y = arrays->force_y;
+    const double *restrict impulse_x = arrays->impulse_x;
+    const double *restrict impulse_y = arrays->impulse_y;
+    const double *restrict inv_mass = arrays->inv_mass;
+    const double *restrict gravity_scale = arrays->gravity_scale;
+
+    // Mirrors body_integrate_with_gravity() operation for operation
+    // so both give the same bits
+    for (size_t i = start; i < end; i++) {
+        // Bodies with infinite mass do not move at all, even under gravity
+        double moves = inv_mass[i] != 0;
+        double fall = moves * gravity_scale[i] * dt;
+        double end_vel_x = vel_x[i] + inv_mass[i] * \
+            (impulse_x[i] + dt * force_x[i]) + fall * gravity.x;
+        double end_vel_y = vel_y[i] + inv_mass[i] * \
+            (impulse_y[i] + dt * force_y[i]) + fall * gravity.y;
+        pos_x[i] += moves * (dt * (0.5 * (vel_x[i] + end_vel_x)));
+        pos_y[i] += moves * (dt * (0.5 * (vel_y[i] + end_vel_y)));
+        vel_x[i] = end_vel_x;
+        vel_y[i] = end_vel_y;
+    }
+}
+
+void body_finish_tick(Body *body, Vector gravity, double dt) {
+    assert(body);
+    BodyArrays *arrays = body->arrays;
+    assert(arrays);
+    size_t i = body->array_index;
+    bool forced = arrays->inv_mass[i] != 0;
+    bool accelerated = body_effective_motion(body) & MOTION_ACCELERATION;
+    if (!forced && !accelerated) {
+        return;
+    }
+    if (forced) {
+        double scale = arrays->gravity_scale[i];
+        body->acceleration = vec_init( \
+            arrays->inv_mass[i] * arrays->force_x[i] + scale * gravity.x, \
+            arrays->inv_mass[i] * arrays->force_y[i] + scale * gravity.y);
+        arrays->force_x[i] = 0;
+        arrays->force_y[i] = 0;
+        arrays->impulse_x[i] = 0;
+        arrays->impulse_y[i] = 0;
+    }
+    if (accelerated) {
+        // Same update as body_tick_no_forces()
+        Vector a = body->acceleration;
+        arrays->pos_x[i] += dt * arrays->vel_x[i] + dt * dt * 0.5 * a.x;
+        arrays->pos_y[i] += dt * arrays->vel_y[i] + dt * dt * 0.5 * a.y;
+        arrays->vel_x[i] += dt * a.x;
+        arrays->vel_y[i] += dt * a.y;
+    }
+
+    // The arrays already hold the new position; bring the vertices along
+    Vector diff = vec_subtract(vec_init(arrays->pos_x[i], arrays->pos_y[i]), \
+        body->centroid);
+    body->centroid = vec_add(body->centroid, diff);
+    for (size_t j = 0; j < list_size(body->points); j++) {
+        Vector *vertex = list_get(body->points, j);
+        *vertex = vec_add(diff, *vertex);
+    }
+    body_rotate_with_velocity(body);
 }
 
 Body* body_get_colliding_body(Body *body) {
     assert(body);
-    return body->other;
+    return body->cold->other;
 }
 
 void body_set_colliding_body(Body *body, Body* other) {
     assert(body);
-    body->other = other;
+    body->cold->other = other;
 }
 
 void body_set_role(Body *body, Role role) {
   assert(body);
-  *((Role*)(((BodyInfo*)(body->info))->info)) = role;
+  body->role = role;
 }
 
 void body_set_color(Body *body, RGBColor color) {
   assert(body);
-  body->color = color;
+  body->cold->color = color;
 }
 
 
@@ -225,12 +595,12 @@ void body_set_angle(Body *body, double angle) {
 
 void body_set_time_since_last_collision(Body *body, double time) {
   assert(body);
-  body->time_since_last_collision = time;
+  body->cold->time_since_last_collision = time;
 }
 
 void body_rotate_with_velocity(Body *body) {
     // Rotate body to be in alignment with its velocity
-    Vector current_vel = *(body->velocity);
+    Vector current_vel = body_get_velocity(body);
     if (current_vel.x == 0 && current_vel.y == 0) return;
     body_set_rotation(body, vec_angle(current_vel));
 }
@@ -239,23 +609,24 @@ void body_tick(Body *body, double dt) {
     assert(body);
 
     // If mass is infinity, it should not move
-    if (body->mass == INFINITY) {
+    if (body->mass == INFINITY || body->type != BODY_DYNAMIC || body->asleep) {
         return;
     }
-    Vector* start_velocity = body->velocity;
+    Vector start_velocity = body_get_velocity(body);
+    Vector forces = body_get_force(body);
     // J = F*t = mv_2 - mv_1
-    Vector total_impulses = vec_add(*(body->impulses), \
-        vec_multiply(dt, *(body->forces)));
+    Vector total_impulses = vec_add(body_get_impulse(body), \
+        vec_multiply(dt, forces));
 
     Vector velocity_change = vec_multiply(1 / body->mass, total_impulses);
-    Vector end_velocity = vec_add(*start_velocity, velocity_change);
+    Vector end_velocity = vec_add(start_velocity, velocity_change);
 
     // Newton's second law. F = ma --> a = F/m
-    *(body->acceleration) = vec_multiply(1 / body->mass, *(body->forces));
+    body->acceleration = vec_multiply(1 / body->mass, forces);
 
     // d = v_(avg) * t
     Vector translate = vec_multiply(dt, vec_multiply(0.5, \
-        vec_add(*start_velocity, end_velocity)));
+        vec_add(start_velocity, end_velocity)));
     body_translate(body, translate);
 
     body_set_velocity(body, end_velocity);
@@ -268,29 +639,234 @@ void body_tick(Body *body, double dt) {
 
 void body_tick_no_forces(Body *body, double dt) {
     assert(body);
+    if (body->type == BODY_STATIC || body->asleep) {
+        return;
+    }
     // d = vt + at^2/2
-    Vector translate = vec_add(vec_multiply(dt, *(body->velocity)),
-        vec_multiply(dt * dt * 0.5, *(body->acceleration)));
+    Vector velocity = body_get_velocity(body);
+    Vector translate = vec_add(vec_multiply(dt, velocity),
+        vec_multiply(dt * dt * 0.5, body->acceleration));
     body_translate(body, translate);
 
     // v_f = v_i + at
-    body_set_velocity(body, (vec_add(*(body->velocity), \
-        vec_multiply(dt, *(body->acceleration)))));
+    body_set_velocity(body, (vec_add(velocity, \
+        vec_multiply(dt, body->acceleration))));
     body_rotate_with_velocity(body);
 
 }
 
 
+void body_integrate(Body *body, double dt) {
+    body_integrate_with_gravity(body, VEC_ZERO, dt);
+}
+
+void body_integrate_with_gravity(Body *body, Vector gravity, double dt) {
+    assert(body);
+    MotionFlags motion = body_effective_motion(body);
+    bool forced = (motion & MOTION_FORCES) && body->mass != INFINITY;
+    bool accelerated = motion & MOTION_ACCELERATION;
+    if (!forced && !accelerated) {
+        return;
+    }
+    Vector translate = VEC_ZERO;
+    if (forced) {
+        // Same update as body_tick(), with gravity's part added to the
+        // velocity change and acceleration
+        Vector start_velocity = body_get_velocity(body);
+        Vector forces = body_get_force(body);
+        Vector total_impulses = vec_add(body_get_impulse(body), \
+            vec_multiply(dt, forces));
+        double scale = body->gravity_scale;
+        Vector end_velocity = vec_add(vec_add(start_velocity, \
+            vec_multiply(1 / body->mass, total_impulses)), \
+            vec_multiply(scale * dt, gravity));
+        body->acceleration = vec_add(vec_multiply(1 / body->mass, forces), \
+            vec_multiply(scale, gravity));
+        translate = vec_multiply(dt, vec_multiply(0.5, \
+            vec_add(start_velocity, end_velocity)));
+        body_set_velocity(body, end_velocity);
+        body_set_force(body, VEC_ZERO);
+        body_set_impulse(body, VEC_ZERO);
+    }
+    if (accelerated) {
+        // Same update as body_tick_no_forces(), continuing from the above
+        Vector velocity = body_get_velocity(body);
+        translate = vec_add(translate, vec_add(vec_multiply(dt, velocity), \
+            vec_multiply(dt * dt * 0.5, body->acceleration)));
+        body_set_velocity(body, vec_add(velocity, \
+            vec_multiply(dt, body->acceleration)));
+    }
+    // The vertices are moved and rotated once, whichever updates applied
+    body_translate(body, translate);
+    body_rotate_with_velocity(body);
+}
+
+MotionFlags body_get_motion(Body *body) {
+    assert(body);
+    return body->motion;
+}
+
+void body_set_motion(Body *body, MotionFlags motion) {
+    assert(body);
+    // MOTION_SUBSTEP always follows the body's max displacement
+    motion &= ~MOTION_SUBSTEP;
+    if (body->cold->max_displacement != INFINITY) {
+        motion |= MOTION_SUBSTEP;
+    }
+    body->motion = motion;
+    if (body->arrays) {
+        body->arrays->inv_mass[body->array_index] = body_arrays_inv_mass(body);
+    }
+}
+
+double body_get_gravity_scale(Body *body) {
+    assert(body);
+    return body->gravity_scale;
+}
+
+void body_set_gravity_scale(Body *body, double scale) {
+    assert(body);
+    body->gravity_scale = scale;
+    if (body->arrays) {
+        body->arrays->gravity_scale[body->array_index] = body->gravity_scale;
+    }
+}
+
+BodyType body_get_type(Body *body) {
+    assert(body);
+    return body->type;
+}
+
+void body_set_type(Body *body, BodyType type) {
+    assert(body);
+    if (body->asleep) {
+        body_wake(body);
+    }
+    body->type = type;
+    if (type == BODY_STATIC) {
+        body_set_velocity(body, VEC_ZERO);
+    }
+    if (body->arrays) {
+        body->arrays->inv_mass[body->array_index] = body_arrays_inv_mass(body);
+    }
+}
+
+bool body_is_sleeping(Body *body) {
+    assert(body);
+    return body->asleep;
+}
+
+void body_sleep(Body *body) {
+    assert(body);
+    if (body->type != BODY_DYNAMIC || body->asleep) {
+        return;
+    }
+    body_set_velocity(body, VEC_ZERO);
+    body_set_force(body, VEC_ZERO);
+    body_set_impulse(body, VEC_ZERO);
+    body->asleep = true;
+    body->rest_ticks = 0;
+    if (body->arrays) {
+        body->arrays->inv_mass[body->array_index] = body_arrays_inv_mass(body);
+    }
+}
+
+void body_wake(Body *body) {
+    assert(body);
+    body->rest_ticks = 0;
+    if (!body->asleep) {
+        return;
+    }
+    body->asleep = false;
+    if (body->arrays) {
+        body->arrays->inv_mass[body->array_index] = body_arrays_inv_mass(body);
+    }
+}
+
+bool body_update_sleep(Body *body, double max_speed, size_t ticks) {
+    assert(body);
+    assert(ticks > 0 && ticks <= BODY_MAX_REST_TICKS);
+    if (body->type != BODY_DYNAMIC || body->asleep) {
+        return body->asleep;
+    }
+    // Compare squared speeds to save a square root per body
+    Vector velocity = body_get_velocity(body);
+    if (vec_dot(velocity, velocity) > max_speed * max_speed) {
+        body->rest_ticks = 0;
+        return false;
+    }
+    if (++body->rest_ticks >= ticks) {
+        body_sleep(body);
+    }
+    return body->asleep;
+}
+
+void body_set_max_displacement(Body *body, double max_displacement) {
+    assert(body);
+    assert(max_displacement > 0);
+    body->cold->max_displacement = max_displacement;
+    body_set_motion(body, body->motion);
+}
+
+double body_get_max_displacement(Body *body) {
+    assert(body);
+    return body->cold->max_displacement;
+}
+
+void body_redirect_forces(ForceBuffer *buffer) {
+    force_redirect = buffer;
+}
+
+/** Gets the entry in the calling thread's force buffer for a body's slot */
+size_t body_buffer_index(Body *body, ForceBuffer *buffer) {
+    assert(body->handle != BODY_HANDLE_NULL);
+    size_t i = body->handle & ((1u << BODY_HANDLE_INDEX_BITS) - 1);
+    assert(i < buffer->size);
+    return i;
+}
+
 void body_add_force(Body *body, Vector force) {
     assert(body);
-    body->forces->x += force.x;
-    body->forces->y += force.y;
+    if (body->asleep) {
+        return;
+    }
+    ForceBuffer *buffer = force_redirect;
+    if (buffer) {
+        size_t i = body_buffer_index(body, buffer);
+        buffer->forces[i].x += force.x;
+        buffer->forces[i].y += force.y;
+        return;
+    }
+    BodyArrays *arrays = body->arrays;
+    if (arrays) {
+        arrays->force_x[body->array_index] += force.x;
+        arrays->force_y[body->array_index] += force.y;
+        return;
+    }
+    body->forces.x += force.x;
+    body->forces.y += force.y;
 }
 
 void body_add_impulse(Body *body, Vector impulse) {
     assert(body);
-    body->impulses->x += impulse.x;
-    body->impulses->y += impulse.y;
+    ForceBuffer *buffer = force_redirect;
+    if (buffer) {
+        size_t i = body_buffer_index(body, buffer);
+        buffer->impulses[i].x += impulse.x;
+        buffer->impulses[i].y += impulse.y;
+        return;
+    }
+    if (body->asleep) {
+        body_wake(body);
+    }
+    BodyArrays *arrays = body->arrays;
+    if (arrays) {
+        arrays->impulse_x[body->array_index] += impulse.x;
+        arrays->impulse_y[body->array_index] += impulse.y;
+        return;
+    }
+    body->impulses.x += impulse.x;
+    body->impulses.y += impulse.y;
 }
 
 double body_area(Body* body) {
@@ -355,15 +931,10 @@ void body_translate(Body *body, Vector translation) {
 
 void body_remove(Body *body) {
     assert(body);
-    BodyInfo *info = body->info;
-    info->existence = REMOVED;
+    body->existence = REMOVED;
 }
 
 bool body_is_removed(Body *body) {
     assert(body);
-    BodyInfo *info = body->info;
-    if (info) {
-        return info->existence == REMOVED;
-    }
-    return false;
+    return body->existence == REMOVED;
 }
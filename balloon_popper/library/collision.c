@@ -95,3 +95,40 @@ void projection_min_max(List *shape, Vector projection_line, Vector *min_max) {
   }
 
 }
+
+Vector find_point_collision(List *shape, Vector point) {
+  size_t length = list_size(shape);
+  Vector exit = VEC_ZERO;
+  double min_depth = INFINITY;
+  /*
+   * The point is inside if it is on the same side of every edge. Its depth
+   * past an edge is cross(edge, point - start) / |edge|, and moving it by
+   * that much along the edge's normal puts it back on the edge, whichever
+   * way the polygon winds.
+   */
+  int side = 0;
+  Vector start = *(Vector *) list_get(shape, length - 1);
+  for (size_t i = 0; i < length; i++) {
+    Vector end = *(Vector *) list_get(shape, i);
+    Vector edge = vec_subtract(end, start);
+    double cross = vec_cross(edge, vec_subtract(point, start));
+    double edge_squared = vec_dot(edge, edge);
+    start = end;
+    if (edge_squared == 0) {
+      continue;
+    }
+    if (cross != 0) {
+      int edge_side = cross > 0 ? 1 : -1;
+      if (side != 0 && edge_side != side) {
+        return VEC_ZERO;
+      }
+      side = edge_side;
+    }
+    double depth = fabs(cross) / sqrt(edge_squared);
+    if (depth < min_depth) {
+      min_depth = depth;
+      exit = vec_multiply(cross / edge_squared, (Vector) {edge.y, -edge.x});
+    }
+  }
+  return exit;
+}
@@ -0,0 +1,294 @@
+#include "constraints.h"
+#include "vec.h"
+#include <assert.h>
+#include <math.h>
+
+#define NO_CONSTRAINT_INDEX UINT32_MAX
+
+typedef enum {
+    CONSTRAINT_DISTANCE,
+    CONSTRAINT_PIN,
+    CONSTRAINT_ROPE
+} ConstraintType;
+
+/**
+ * One constraint, on the bodies at indices first and second of its set.
+ * A pin has no second body and holds first at point instead.
+ */
+typedef struct {
+    ConstraintType type;
+    uint32_t first;
+    uint32_t second;
+    double length;
+    Vector point;
+} Constraint;
+
+DEFINE_VEC(Constraint)
+DEFINE_VEC_NAMED(ConstraintBodyVec, Body *)
+DEFINE_VEC_NAMED(ConstraintIndexVec, uint32_t)
+DEFINE_VEC_NAMED(ConstraintDoubleVec, double)
+
+/**
+ * Every constraint in a scene, solved together.
+ * Like a force batch, it indexes its bodies by their handles' slots, and
+ * gathers their positions into arrays for the solve.
+ */
+typedef struct {
+    Scene *scene;
+    size_t iterations;
+    ConstraintBodyVec bodies;
+    ConstraintIndexVec index_of_slot;
+    ConstraintIndexVec renumbered;
+    ConstraintVec constraints;
+    ConstraintDoubleVec x;
+    ConstraintDoubleVec y;
+    ConstraintDoubleVec inv_mass;
+} ConstraintSet;
+
+/** Gets the slot of a body's handle, which the set indexes bodies by */
+size_t constraint_slot(Body *body) {
+    return body_get_handle(body) & ((1u << BODY_HANDLE_INDEX_BITS) - 1);
+}
+
+/** Whether the solver may move a body, rather than holding it in place */
+bool constraint_moves(Body *body) {
+    return (body_get_motion(body) & MOTION_FORCES)
+        && body_get_type(body) == BODY_DYNAMIC
+        && !body_is_sleeping(body)
+        && body_get_mass(body) != INFINITY;
+}
+
+/** Moves a pair of gathered bodies so they are length apart */
+void constraint_solve_distance(
+    ConstraintSet *set, uint32_t first, uint32_t second, double length,
+    bool rope
+) {
+    double *x = set->x.data, *y = set->y.data;
+    double w1 = VEC_AT(&set->inv_mass, first);
+    double w2 = VEC_AT(&set->inv_mass, second);
+    double dx = x[second] - x[first], dy = y[second] - y[first];
+    double distance = sqrt(dx * dx + dy * dy);
+    // Coincident bodies have no direction to be pushed apart in
+    if (w1 + w2 == 0 || distance == 0) {
+        return;
+    }
+    double error = distance - length;
+    if (rope && error <= 0) {
+        return;
+    }
+    double scale = error / ((w1 + w2) * distance);
+    x[first] += w1 * scale * dx;
+    y[first] += w1 * scale * dy;
+    x[second] -= w2 * scale * dx;
+    y[second] -= w2 * scale * dy;
+}
+
+/** Solves a scene's constraints (see scene_add_constraint_batch()) */
+void solveConstraints(void *aux) {
+    ConstraintSet *set = aux;
+    double dt = scene_get_dt(set->scene);
+    size_t n = set->bodies.size;
+    if (dt == 0 || set->constraints.size == 0) {
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        Body *body = VEC_AT(&set->bodies, i);
+        Vector centroid = body_get_centroid(body);
+        VEC_AT(&set->x, i) = centroid.x;
+        VEC_AT(&set->y, i) = centroid.y;
+        VEC_AT(&set->inv_mass, i) = constraint_moves(body) ? \
+            1 / body_get_mass(body) : 0;
+    }
+
+    for (size_t iteration = 0; iteration < set->iterations; iteration++) {
+        VEC_FOREACH(Constraint, constraint, &set->constraints) {
+            switch (constraint->type) {
+                case CONSTRAINT_DISTANCE:
+                case CONSTRAINT_ROPE:
+                    constraint_solve_distance(set, constraint->first, \
+                        constraint->second, constraint->length, \
+                        constraint->type == CONSTRAINT_ROPE);
+                    break;
+                case CONSTRAINT_PIN:
+                    if (VEC_AT(&set->inv_mass, constraint->first) > 0) {
+                        VEC_AT(&set->x, constraint->first) = \
+                            constraint->point.x;
+                        VEC_AT(&set->y, constraint->first) = \
+                            constraint->point.y;
+                    }
+                    break;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        Body *body = VEC_AT(&set->bodies, i);
+        Vector solved = {VEC_AT(&set->x, i), VEC_AT(&set->y, i)};
+        Vector moved = vec_subtract(solved, body_get_centroid(body));
+        if (VEC_AT(&set->inv_mass, i) == 0 \
+                || (moved.x == 0 && moved.y == 0)) {
+            continue;
+        }
+        body_set_centroid(body, solved);
+        body_set_velocity(body, \
+            vec_add(body_get_velocity(body), vec_multiply(1 / dt, moved)));
+    }
+}
+
+/**
+ * A ForcePruner for a scene's constraints: drops the bodies marked for
+ * removal and the constraints on them, keeping the rest in order.
+ */
+void constraint_set_prune(void *aux) {
+    ConstraintSet *set = aux;
+    size_t body_count = set->bodies.size;
+    size_t removed = 0;
+    while (removed < body_count \
+            && !body_is_removed(VEC_AT(&set->bodies, removed))) {
+        removed++;
+    }
+    if (removed == body_count) {
+        return;
+    }
+
+    ConstraintIndexVec_clear(&set->renumbered);
+    size_t kept = 0;
+    for (size_t i = 0; i < body_count; i++) {
+        Body *body = VEC_AT(&set->bodies, i);
+        uint32_t index = body_is_removed(body) ? NO_CONSTRAINT_INDEX : kept++;
+        VEC_AT(&set->index_of_slot, constraint_slot(body)) = index;
+        ConstraintIndexVec_push(&set->renumbered, index);
+        if (index != NO_CONSTRAINT_INDEX) {
+            VEC_AT(&set->bodies, index) = body;
+        }
+    }
+    set->bodies.size = kept;
+    set->x.size = kept;
+    set->y.size = kept;
+    set->inv_mass.size = kept;
+
+    size_t kept_constraints = 0;
+    VEC_FOREACH(Constraint, constraint, &set->constraints) {
+        bool pin = constraint->type == CONSTRAINT_PIN;
+        uint32_t first = VEC_AT(&set->renumbered, constraint->first);
+        uint32_t second = pin ? NO_CONSTRAINT_INDEX : \
+            VEC_AT(&set->renumbered, constraint->second);
+        if (first == NO_CONSTRAINT_INDEX \
+                || (!pin && second == NO_CONSTRAINT_INDEX)) {
+            continue;
+        }
+        Constraint *kept_constraint = \
+            &VEC_AT(&set->constraints, kept_constraints++);
+        *kept_constraint = *constraint;
+        kept_constraint->first = first;
+        kept_constraint->second = second;
+    }
+    set->constraints.size = kept_constraints;
+}
+
+void constraint_set_free(void *aux) {
+    ConstraintSet *set = aux;
+    ConstraintBodyVec_free(&set->bodies);
+    ConstraintIndexVec_free(&set->index_of_slot);
+    ConstraintIndexVec_free(&set->renumbered);
+    ConstraintVec_free(&set->constraints);
+    ConstraintDoubleVec_free(&set->x);
+    ConstraintDoubleVec_free(&set->y);
+    ConstraintDoubleVec_free(&set->inv_mass);
+    arena_release(set);
+}
+
+/** Gets a scene's constraints, adding them to the scene if it has none */
+ConstraintSet *constraint_set(Scene *scene) {
+    assert(scene);
+    ConstraintSet *set = scene_get_force_batch(scene, solveConstraints);
+    if (set) {
+        return set;
+    }
+    const Allocator *allocator = arena_allocator(scene_get_arena(scene));
+    set = allocator_alloc(allocator, sizeof(ConstraintSet));
+    set->scene = scene;
+    set->iterations = CONSTRAINT_DEFAULT_ITERATIONS;
+    ConstraintBodyVec_init(&set->bodies, allocator);
+    ConstraintIndexVec_init(&set->index_of_slot, allocator);
+    ConstraintIndexVec_init(&set->renumbered, allocator);
+    ConstraintVec_init(&set->constraints, allocator);
+    ConstraintDoubleVec_init(&set->x, allocator);
+    ConstraintDoubleVec_init(&set->y, allocator);
+    ConstraintDoubleVec_init(&set->inv_mass, allocator);
+    scene_add_constraint_batch(scene, solveConstraints, set, \
+        constraint_set_prune, constraint_set_free);
+    return set;
+}
+
+/** Gets a body's index in a scene's constraints, adding it if it is new */
+uint32_t constraint_body(ConstraintSet *set, Body *body) {
+    assert(body_get_handle(body) != BODY_HANDLE_NULL);
+    size_t slot = constraint_slot(body);
+    while (set->index_of_slot.size <= slot) {
+        ConstraintIndexVec_push(&set->index_of_slot, NO_CONSTRAINT_INDEX);
+    }
+    uint32_t index = VEC_AT(&set->index_of_slot, slot);
+    if (index != NO_CONSTRAINT_INDEX && VEC_AT(&set->bodies, index) == body) {
+        return index;
+    }
+    index = set->bodies.size;
+    ConstraintBodyVec_push(&set->bodies, body);
+    VEC_AT(&set->index_of_slot, slot) = index;
+    ConstraintDoubleVec_push(&set->x, 0);
+    ConstraintDoubleVec_push(&set->y, 0);
+    ConstraintDoubleVec_push(&set->inv_mass, 0);
+    return index;
+}
+
+/** Adds a constraint between two bodies to their scene's constraints */
+void constraint_add_pair(
+    Scene *scene, ConstraintType type, Body *body1, Body *body2, double length
+) {
+    assert(length >= 0);
+    assert(body1 != body2);
+    ConstraintSet *set = constraint_set(scene);
+    Constraint constraint = {
+        .type = type,
+        .first = constraint_body(set, body1),
+        .second = constraint_body(set, body2),
+        .length = length,
+        .point = VEC_ZERO
+    };
+    ConstraintVec_push(&set->constraints, constraint);
+}
+
+void create_distance_constraint(
+    Scene *scene, Body *body1, Body *body2, double distance
+) {
+    constraint_add_pair(scene, CONSTRAINT_DISTANCE, body1, body2, distance);
+}
+
+void create_pin_constraint(Scene *scene, Body *body, Vector point) {
+    ConstraintSet *set = constraint_set(scene);
+    Constraint constraint = {
+        .type = CONSTRAINT_PIN,
+        .first = constraint_body(set, body),
+        .second = NO_CONSTRAINT_INDEX,
+        .length = 0,
+        .point = point
+    };
+    ConstraintVec_push(&set->constraints, constraint);
+}
+
+void create_rope_constraint(
+    Scene *scene, Body *body1, Body *body2, double length
+) {
+    constraint_add_pair(scene, CONSTRAINT_ROPE, body1, body2, length);
+}
+
+void constraints_set_iterations(Scene *scene, size_t iterations) {
+    assert(iterations > 0);
+    constraint_set(scene)->iterations = iterations;
+}
+
+size_t constraints_get_iterations(Scene *scene) {
+    assert(scene);
+    ConstraintSet *set = scene_get_force_batch(scene, solveConstraints);
+    return set ? set->iterations : CONSTRAINT_DEFAULT_ITERATIONS;
+}
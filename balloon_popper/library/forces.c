@@ -2,9 +2,47 @@
 #include "utils.h"
 #include "list.h"
 #include "collision.h"
+#include "vec.h"
 #include <assert.h>
+#include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// The most terms one batch holds, so a scene with many forces of one kind
+// still has several batches to spread over its threads
+#define BATCH_MAX_TERMS 4096
+#define NO_BATCH_INDEX UINT32_MAX
+// How many bodies the n-body kernel computes the forces on at once,
+// and how many bodies' pulls it takes in each pass, so they stay in cache
+#define NBODY_LANES 4
+#define NBODY_TILE 512
+// The most bodies a Barnes-Hut leaf holds, and the most levels its quadtree
+// has, one per pair of bits in the bodies' 32-bit Morton codes
+#define BH_LEAF_BODIES 8
+#define BH_LEVELS 16
+// The top of the quadtree is built serially down to this depth, and the
+// subtrees below it in parallel. It has at most 1 + 4 + 16 + 64 nodes.
+#define BH_TOP_DEPTH 3
+#define BH_TOP_NODES 85
+// How many bodies a thread takes at a time when walking the tree
+#define BH_CHUNK_BODIES 256
+// Enough for a walk of the deepest tree, which keeps at most 3 siblings
+// waiting per level
+#define BH_STACK_SIZE (4 * (BH_LEVELS + 1))
+// How many bodies' rows of a spring network's system a thread multiplies at
+// a time, and how small the solve's residual must get relative to its
+// right-hand side
+#define SPRING_CHUNK_BODIES 256
+#define SPRING_TOLERANCE 1e-10
+
+DEFINE_VEC_NAMED(BodyPtrVec, Body *)
+DEFINE_VEC_NAMED(IndexVec, uint32_t)
+DEFINE_VEC_NAMED(DoubleVec, double)
+
 struct forceAux {
     List* bodies;
     double constant;    // G or K or gamma
@@ -14,12 +52,173 @@ struct collisionAux {
     List* bodies;
     CollisionHandler handler;
     void* info;
+    FreeFunc info_freer;
+    // Collisions whose info must be freed individually keep their aux
+    // outside the scene's arena too, so scene_reset() knows to free it
+    const Allocator *allocator;
 };
 
 struct elas {
     double elasticity;
 };
 
+/**
+ * Many forces of one kind, such as springs, applied by a single force creator.
+ * Each term acts on one or two of the batch's bodies, given by their indices
+ * in bodies, with its own constant (G, k or gamma).
+ * Every tick, the bodies' states are gathered into arrays once, each term's
+ * force is computed from them in one loop without any calls,
+ * and each body's total force is added to it once.
+ */
+typedef struct forceBatch {
+    BodyPtrVec bodies;
+    // Maps the slot in each body's handle to its index in bodies
+    IndexVec index_of_slot;
+    // Scratch space for force_batch_prune(): each body's new index
+    IndexVec renumbered;
+    IndexVec first;
+    IndexVec second;
+    DoubleVec constant;
+    // Gathered from the bodies at the start of each tick
+    DoubleVec x;
+    DoubleVec y;
+    DoubleVec vx;
+    DoubleVec vy;
+    DoubleVec mass;
+    // Each term's force on its first body, then each body's total force
+    DoubleVec term_x;
+    DoubleVec term_y;
+    DoubleVec force_x;
+    DoubleVec force_y;
+} ForceBatch;
+
+/**
+ * The bodies of a create_nbody_gravity() force, with their positions and
+ * masses gathered into arrays every tick. The arrays are padded to a multiple
+ * of NBODY_LANES with massless bodies, so the kernel never needs a remainder
+ * loop: a massless body pulls on nothing, and the forces on it are dropped.
+ */
+typedef struct nBody {
+    BodyPtrVec bodies;
+    double G;
+    double softening;
+    DoubleVec x;
+    DoubleVec y;
+    DoubleVec mass;
+    // The sum over the other bodies of m * r / (|r|^2 + softening^2)^(3/2)
+    DoubleVec pull_x;
+    DoubleVec pull_y;
+} NBody;
+
+/**
+ * A square cell of a Barnes-Hut quadtree.
+ * A node's bodies are contiguous in Morton order, and so are its children.
+ * Levels at which all of a node's bodies are in one quadrant are skipped,
+ * so every node but a leaf has at least 2 children.
+ */
+typedef struct quadNode {
+    // The total mass of the node's bodies, and its center
+    double mass;
+    double x;
+    double y;
+    // The side of the node's cell
+    double size;
+    // The node's bodies are [start, end) in Morton order
+    uint32_t start;
+    uint32_t end;
+    // The node's children are [first_child, first_child + children)
+    uint32_t first_child;
+    uint32_t children;
+} QuadNode;
+
+DEFINE_VEC(QuadNode)
+
+/** A node below the top of the tree, whose subtree is built in parallel */
+typedef struct subtree {
+    uint32_t node;
+    uint32_t level;
+} Subtree;
+
+DEFINE_VEC(Subtree)
+
+/**
+ * The bodies of a create_barnes_hut_gravity() force, and the quadtree built
+ * from them every tick.
+ * The nodes array holds the top of the tree, then room for each subtree
+ * below it: a subtree of k bodies has fewer than 2k nodes, since every node
+ * but a leaf has 2 or more children, so the subtree of bodies [start, end)
+ * in Morton order is given the nodes from BH_TOP_NODES + 2 * start onwards.
+ * That lets the subtrees be built at once without sharing anything.
+ */
+typedef struct barnesHut {
+    Scene *scene;
+    BodyPtrVec bodies;
+    double G;
+    double softening;
+    double theta;
+    // Gathered from the bodies, in the order of bodies
+    DoubleVec x;
+    DoubleVec y;
+    DoubleVec mass;
+    // The bodies' Morton codes, and their indices in bodies,
+    // sorted by code, with space for the sort to work in
+    IndexVec codes;
+    IndexVec order;
+    IndexVec codes_scratch;
+    IndexVec order_scratch;
+    // The bodies' positions and masses in Morton order
+    DoubleVec sorted_x;
+    DoubleVec sorted_y;
+    DoubleVec sorted_mass;
+    QuadNodeVec nodes;
+    SubtreeVec subtrees;
+    // The square the tree covers: its lower left corner and side
+    double min_x;
+    double min_y;
+    double size;
+} BarnesHut;
+
+/**
+ * The springs and drag of a create_spring_network() force, and the linear
+ * system for their bodies' velocities at the end of each tick:
+ * (M + dt C + dt^2 K) v1 = M v0 + dt f0, where M holds the masses,
+ * C the drag coefficients, K the springs' stiffness and f0 the springs'
+ * forces at the start of the tick. The matrix is the same for both axes,
+ * so their velocities are solved for together, interleaved as x, y pairs.
+ */
+typedef struct springNetwork {
+    Scene *scene;
+    // The springs, as paired terms whose constants are their k
+    ForceBatch *springs;
+    // Each body's total drag coefficient
+    DoubleVec gamma;
+    // K without its diagonal, in compressed sparse rows: body i's entries are
+    // [row_start[i], row_start[i + 1]), each holding the body at the other
+    // end of a spring on it, and that spring. Rebuilt when springs change.
+    IndexVec row_start;
+    IndexVec column;
+    IndexVec entry_spring;
+    IndexVec next_entry;
+    bool assembled;
+    // Set each tick. Bodies whose velocities are known, like static ones,
+    // get a row of the identity, and their springs' pulls go into rhs.
+    DoubleVec moving;
+    DoubleVec diagonal;
+    DoubleVec coupling;
+    // Interleaved: the right-hand side, the solution, and conjugate
+    // gradient's residual, preconditioned residual, search direction and
+    // the matrix times the search direction
+    DoubleVec rhs;
+    DoubleVec velocity;
+    DoubleVec residual;
+    DoubleVec preconditioned;
+    DoubleVec direction;
+    DoubleVec product;
+    // Each chunk's share of a dot product, summed in order so the result
+    // does not depend on the thread count
+    DoubleVec partial;
+} SpringNetwork;
+
 void handleDestructiveCollision(Body *body1, Body *body2, Vector axis, void *aux) {
     if (body_get_role(body2) == PLAYER) {
       if (body_get_role(body1) == REMOVE_ON_COLLISION) {
@@ -41,18 +240,29 @@ void handleDestructiveCollision(Body *body1, Body *body2, Vector axis, void *aux
     }
 }
 
+/** Gets a body's mass, or INFINITY for bodies that impulses do not move */
+double collision_mass(Body *body) {
+    if (body_get_type(body) != BODY_DYNAMIC) {
+        return INFINITY;
+    }
+    return body_get_mass(body);
+}
+
 void handlePhysicsCollision(Body *body1, Body *body2, Vector axis, void *aux) {
     // Axix points from body1 -> body2
     Elas* a = aux;
-    double mass_1 = body_get_mass(body1);
-    double mass_2 = body_get_mass(body2);
+    double mass_1 = collision_mass(body1);
+    double mass_2 = collision_mass(body2);
     Vector vel_1 = body_get_velocity(body1);
     Vector vel_2 = body_get_velocity(body2);
     double elas = a->elasticity;
     Vector component_1 = vec_projection(vel_1, axis);
     Vector component_2 = vec_projection(vel_2, axis);
     double reduced_mass;
-    if (mass_1 == INFINITY) {
+    if (mass_1 == INFINITY && mass_2 == INFINITY) {
+        // Neither body can be pushed
+        reduced_mass = 0;
+    } else if (mass_1 == INFINITY) {
         reduced_mass = mass_2;
     } else if (mass_2 == INFINITY) {
         reduced_mass = mass_1;
@@ -129,13 +339,29 @@ void addDragForce(void *aux) {
     body_add_force(body, drag_force);
 }
 
+/** Whether a body stays where it is until something else moves it */
+bool is_resting(Body *body) {
+    return body_get_type(body) == BODY_STATIC || body_is_sleeping(body);
+}
+
 void addCollision(void *aux) {
     // Should check for collision
     CollisionAux* a = aux;
     Body* b1 = list_get(a->bodies, 0);
     Body* b2 = list_get(a->bodies, 1);
+    // Two bodies that are each static or sleeping can never come into contact
+    if (is_resting(b1) && is_resting(b2)) {
+        return;
+    }
     Vector collision = find_collision(body_get_shape(b1), body_get_shape(b2));
     if (collision.x != 0 || collision.y != 0) {
+        // An awake body touching a sleeping one wakes it
+        if (body_is_sleeping(b1)) {
+            body_wake(b1);
+        }
+        if (body_is_sleeping(b2)) {
+            body_wake(b2);
+        }
         // If bodies are both collided previously, then do not apply again
         // if (body_get_colliding_body(b1) == b2 && body_get_colliding_body(b2) == b1) {
         //     return;
@@ -153,39 +379,1377 @@ void addCollision(void *aux) {
     }
 }
 
+/**
+ * Allocates the aux of a force creator acting on one or two bodies
+ * from the scene's arena. body2 may be NULL.
+ * The list of bodies is stored right after the aux in the same block.
+ */
+ForceAux *force_aux_init(Scene *scene, double constant, Body *body1, Body *body2) {
+    const Allocator *allocator = arena_allocator(scene_get_arena(scene));
+    size_t count = body2 ? 2 : 1;
+    ForceAux* aux = allocator_alloc(allocator, \
+        sizeof(ForceAux) + list_inline_size(count));
+    aux->constant = constant;
+    aux->bodies = list_init_in(aux + 1, allocator, count, NULL);
+    list_add(aux->bodies, body1);
+    if (body2) {
+        list_add(aux->bodies, body2);
+    }
+    return aux;
+}
+
+ForceBatch *force_batch_init(Scene *scene) {
+    const Allocator *allocator = arena_allocator(scene_get_arena(scene));
+    ForceBatch *batch = allocator_alloc(allocator, sizeof(ForceBatch));
+    BodyPtrVec_init(&batch->bodies, allocator);
+    IndexVec_init(&batch->index_of_slot, allocator);
+    IndexVec_init(&batch->renumbered, allocator);
+    IndexVec_init(&batch->first, allocator);
+    IndexVec_init(&batch->second, allocator);
+    DoubleVec_init(&batch->constant, allocator);
+    DoubleVec_init(&batch->x, allocator);
+    DoubleVec_init(&batch->y, allocator);
+    DoubleVec_init(&batch->vx, allocator);
+    DoubleVec_init(&batch->vy, allocator);
+    DoubleVec_init(&batch->mass, allocator);
+    DoubleVec_init(&batch->term_x, allocator);
+    DoubleVec_init(&batch->term_y, allocator);
+    DoubleVec_init(&batch->force_x, allocator);
+    DoubleVec_init(&batch->force_y, allocator);
+    return batch;
+}
+
+void force_batch_free(void *b) {
+    ForceBatch *batch = b;
+    BodyPtrVec_free(&batch->bodies);
+    IndexVec_free(&batch->index_of_slot);
+    IndexVec_free(&batch->renumbered);
+    IndexVec_free(&batch->first);
+    IndexVec_free(&batch->second);
+    DoubleVec_free(&batch->constant);
+    DoubleVec_free(&batch->x);
+    DoubleVec_free(&batch->y);
+    DoubleVec_free(&batch->vx);
+    DoubleVec_free(&batch->vy);
+    DoubleVec_free(&batch->mass);
+    DoubleVec_free(&batch->term_x);
+    DoubleVec_free(&batch->term_y);
+    DoubleVec_free(&batch->force_x);
+    DoubleVec_free(&batch->force_y);
+    arena_release(batch);
+}
+
+/** Gets the slot of a body's handle, which batches index bodies by */
+size_t handle_slot(Body *body) {
+    return body_get_handle(body) & ((1u << BODY_HANDLE_INDEX_BITS) - 1);
+}
+
+/** Gets a body's index in a batch, adding it to the batch if it is new */
+uint32_t force_batch_body(ForceBatch *batch, Body *body) {
+    size_t slot = handle_slot(body);
+    while (batch->index_of_slot.size <= slot) {
+        IndexVec_push(&batch->index_of_slot, NO_BATCH_INDEX);
+    }
+    uint32_t index = VEC_AT(&batch->index_of_slot, slot);
+    if (index != NO_BATCH_INDEX && VEC_AT(&batch->bodies, index) == body) {
+        return index;
+    }
+    index = batch->bodies.size;
+    BodyPtrVec_push(&batch->bodies, body);
+    VEC_AT(&batch->index_of_slot, slot) = index;
+    // Grow the arrays the kernels fill here, since they may run on several
+    // threads at once and so must not allocate from the scene's arena
+    DoubleVec *arrays[] = {&batch->x, &batch->y, &batch->vx, &batch->vy, \
+        &batch->mass, &batch->force_x, &batch->force_y};
+    for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++) {
+        DoubleVec_push(arrays[i], 0);
+    }
+    return index;
+}
+
+/**
+ * A ForcePruner for batches: drops the bodies marked for removal
+ * and the terms on them, keeping the rest in order.
+ */
+void force_batch_prune(void *aux) {
+    ForceBatch *batch = aux;
+    size_t body_count = batch->bodies.size;
+    size_t removed = 0;
+    while (removed < body_count \
+            && !body_is_removed(VEC_AT(&batch->bodies, removed))) {
+        removed++;
+    }
+    if (removed == body_count) {
+        return;
+    }
+
+    // Renumber the surviving bodies, and mark the others NO_BATCH_INDEX
+    IndexVec_clear(&batch->renumbered);
+    size_t kept = 0;
+    for (size_t i = 0; i < body_count; i++) {
+        Body *body = VEC_AT(&batch->bodies, i);
+        uint32_t index = body_is_removed(body) ? NO_BATCH_INDEX : kept++;
+        VEC_AT(&batch->index_of_slot, handle_slot(body)) = index;
+        IndexVec_push(&batch->renumbered, index);
+        if (index != NO_BATCH_INDEX) {
+            VEC_AT(&batch->bodies, index) = body;
+        }
+    }
+    batch->bodies.size = kept;
+
+    bool paired = batch->second.size > 0;
+    size_t kept_terms = 0;
+    for (size_t t = 0; t < batch->first.size; t++) {
+        uint32_t first = VEC_AT(&batch->renumbered, VEC_AT(&batch->first, t));
+        uint32_t second = paired ? \
+            VEC_AT(&batch->renumbered, VEC_AT(&batch->second, t)) : first;
+        if (first == NO_BATCH_INDEX || second == NO_BATCH_INDEX) {
+            continue;
+        }
+        VEC_AT(&batch->first, kept_terms) = first;
+        if (paired) {
+            VEC_AT(&batch->second, kept_terms) = second;
+        }
+        VEC_AT(&batch->constant, kept_terms) = VEC_AT(&batch->constant, t);
+        kept_terms++;
+    }
+    batch->first.size = kept_terms;
+    batch->second.size = paired ? kept_terms : 0;
+    batch->constant.size = kept_terms;
+    batch->term_x.size = kept_terms;
+    batch->term_y.size = kept_terms;
+    DoubleVec *arrays[] = {&batch->x, &batch->y, &batch->vx, &batch->vy, \
+        &batch->mass, &batch->force_x, &batch->force_y};
+    for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++) {
+        arrays[i]->size = kept;
+    }
+}
+
+/**
+ * Copies the positions, velocities and masses of a batch's bodies into its
+ * arrays, and zeroes their total forces.
+ */
+void force_batch_gather(ForceBatch *batch) {
+    size_t n = batch->bodies.size;
+    double *x = batch->x.data;
+    double *y = batch->y.data;
+    double *vx = batch->vx.data;
+    double *vy = batch->vy.data;
+    double *mass = batch->mass.data;
+    double *force_x = batch->force_x.data;
+    double *force_y = batch->force_y.data;
+    for (size_t i = 0; i < n; i++) {
+        Body *body = VEC_AT(&batch->bodies, i);
+        Vector position = body_get_centroid(body);
+        Vector velocity = body_get_velocity(body);
+        x[i] = position.x;
+        y[i] = position.y;
+        vx[i] = velocity.x;
+        vy[i] = velocity.y;
+        mass[i] = body_get_mass(body);
+        force_x[i] = 0;
+        force_y[i] = 0;
+    }
+}
+
+/**
+ * Adds each term's force to its first body, and its opposite to its second
+ * body if it has one, then adds each body's total force to the body.
+ */
+void force_batch_scatter(ForceBatch *batch) {
+    size_t terms = batch->first.size;
+    const uint32_t *first = batch->first.data;
+    const uint32_t *second = batch->second.data;
+    const double *term_x = batch->term_x.data;
+    const double *term_y = batch->term_y.data;
+    double *force_x = batch->force_x.data;
+    double *force_y = batch->force_y.data;
+    for (size_t t = 0; t < terms; t++) {
+        force_x[first[t]] += term_x[t];
+        force_y[first[t]] += term_y[t];
+        if (second) {
+            force_x[second[t]] -= term_x[t];
+            force_y[second[t]] -= term_y[t];
+        }
+    }
+    for (size_t i = 0; i < batch->bodies.size; i++) {
+        body_add_force(VEC_AT(&batch->bodies, i), \
+            vec_init(force_x[i], force_y[i]));
+    }
+}
+
+/** The ForceCreator of a batch of create_newtonian_gravity() terms */
+void addGravityBatch(void *aux) {
+    ForceBatch *batch = aux;
+    force_batch_gather(batch);
+    size_t terms = batch->first.size;
+    const uint32_t *restrict first = batch->first.data;
+    const uint32_t *restrict second = batch->second.data;
+    const double *restrict G = batch->constant.data;
+    const double *restrict x = batch->x.data;
+    const double *restrict y = batch->y.data;
+    const double *restrict mass = batch->mass.data;
+    double *restrict term_x = batch->term_x.data;
+    double *restrict term_y = batch->term_y.data;
+    for (size_t t = 0; t < terms; t++) {
+        double dx = x[second[t]] - x[first[t]];
+        double dy = y[second[t]] - y[first[t]];
+        double r2 = dx * dx + dy * dy;
+        double r = sqrt(r2);
+        // F = G * m1 * m2 / r^2 along the unit vector (dx, dy) / r,
+        // except when the bodies are too close, like addGravityForce()
+        double scale = r < CLOSENESS ? 0 : \
+            G[t] * mass[first[t]] * mass[second[t]] / (r2 * r);
+        term_x[t] = scale * dx;
+        term_y[t] = scale * dy;
+    }
+    force_batch_scatter(batch);
+}
+
+/** The ForceCreator of a batch of create_spring() terms */
+void addSpringBatch(void *aux) {
+    ForceBatch *batch = aux;
+    force_batch_gather(batch);
+    size_t terms = batch->first.size;
+    const uint32_t *restrict first = batch->first.data;
+    const uint32_t *restrict second = batch->second.data;
+    const double *restrict k = batch->constant.data;
+    const double *restrict x = batch->x.data;
+    const double *restrict y = batch->y.data;
+    double *restrict term_x = batch->term_x.data;
+    double *restrict term_y = batch->term_y.data;
+    for (size_t t = 0; t < terms; t++) {
+        // F = kx, pulling the first body towards the second
+        term_x[t] = k[t] * (x[second[t]] - x[first[t]]);
+        term_y[t] = k[t] * (y[second[t]] - y[first[t]]);
+    }
+    force_batch_scatter(batch);
+}
+
+/** The ForceCreator of a batch of create_drag() terms */
+void addDragBatch(void *aux) {
+    ForceBatch *batch = aux;
+    force_batch_gather(batch);
+    size_t terms = batch->first.size;
+    const uint32_t *restrict first = batch->first.data;
+    const double *restrict gamma = batch->constant.data;
+    const double *restrict vx = batch->vx.data;
+    const double *restrict vy = batch->vy.data;
+    double *restrict term_x = batch->term_x.data;
+    double *restrict term_y = batch->term_y.data;
+    for (size_t t = 0; t < terms; t++) {
+        term_x[t] = -gamma[t] * vx[first[t]];
+        term_y[t] = -gamma[t] * vy[first[t]];
+    }
+    force_batch_scatter(batch);
+}
+
+/**
+ * Adds a term to the scene's newest batch with the given force creator,
+ * starting a new batch if there is none or it is full.
+ * body2 is NULL for terms on one body.
+ */
+void force_batch_add(
+    Scene *scene, ForceCreator forcer, double constant, Body *body1,
+    Body *body2
+) {
+    ForceBatch *batch = scene_get_force_batch(scene, forcer);
+    if (!batch || batch->first.size == BATCH_MAX_TERMS) {
+        batch = force_batch_init(scene);
+        scene_add_force_batch(scene, forcer, batch, force_batch_prune, \
+            force_batch_free);
+    }
+    IndexVec_push(&batch->first, force_batch_body(batch, body1));
+    if (body2) {
+        IndexVec_push(&batch->second, force_batch_body(batch, body2));
+    }
+    DoubleVec_push(&batch->constant, constant);
+    DoubleVec_push(&batch->term_x, 0);
+    DoubleVec_push(&batch->term_y, 0);
+}
+
+/**
+ * Whether forces on these bodies can go in a batch,
+ * which needs the bodies to be in a scene already. body2 may be NULL.
+ */
+bool can_batch(Body *body1, Body *body2) {
+    return body_get_handle(body1) != BODY_HANDLE_NULL
+        && (!body2 || body_get_handle(body2) != BODY_HANDLE_NULL);
+}
+
 void create_newtonian_gravity(Scene *scene, double G, Body *body1, Body *body2)
 {
-    ForceAux* aux = malloc(sizeof(ForceAux));
-    assert(aux);
-    aux->constant = G;
-    aux->bodies = list_init(2, body_free);
-    list_add(aux->bodies, body1);
-    list_add(aux->bodies, body2);
-    scene_add_bodies_force_creator(scene, addGravityForce, aux, \
+    if (can_batch(body1, body2)) {
+        force_batch_add(scene, addGravityBatch, G, body1, body2);
+        return;
+    }
+    ForceAux* aux = force_aux_init(scene, G, body1, body2);
+    scene_add_pure_force_creator(scene, addGravityForce, aux, \
         aux->bodies, aux_freer);
 }
 
 void create_spring(Scene *scene, double k, Body *body1, Body *body2) {
-    ForceAux* aux = malloc(sizeof(ForceAux));
-    assert(aux);
-    aux->constant = k;
-    aux->bodies = list_init(2, body_free);
-    list_add(aux->bodies, body1);
-    list_add(aux->bodies, body2);
-    scene_add_bodies_force_creator(scene, addSpringForce, aux, \
+    if (can_batch(body1, body2)) {
+        force_batch_add(scene, addSpringBatch, k, body1, body2);
+        return;
+    }
+    ForceAux* aux = force_aux_init(scene, k, body1, body2);
+    scene_add_pure_force_creator(scene, addSpringForce, aux, \
         aux->bodies, aux_freer);
 }
 
 void create_drag(Scene *scene, double gamma, Body *body) {
-    ForceAux* aux = malloc(sizeof(ForceAux));
-    assert(aux);
-    aux->constant = gamma;
-    aux->bodies = list_init(1, body_free);
-    list_add(aux->bodies, body);
-    scene_add_bodies_force_creator(scene, addDragForce, aux, \
+    if (can_batch(body, NULL)) {
+        force_batch_add(scene, addDragBatch, gamma, body, NULL);
+        return;
+    }
+    ForceAux* aux = force_aux_init(scene, gamma, body, NULL);
+    scene_add_pure_force_creator(scene, addDragForce, aux, \
         aux->bodies, aux_freer);
 }
 
+/**
+ * Sizes an n-body force's arrays for its bodies, plus padding,
+ * and zeroes the padding.
+ */
+void nbody_resize(NBody *nbody) {
+    size_t n = nbody->bodies.size;
+    size_t padded = (n + NBODY_LANES - 1) / NBODY_LANES * NBODY_LANES;
+    DoubleVec *arrays[] = {&nbody->x, &nbody->y, &nbody->mass, \
+        &nbody->pull_x, &nbody->pull_y};
+    for (size_t a = 0; a < sizeof(arrays) / sizeof(arrays[0]); a++) {
+        DoubleVec_reserve(arrays[a], padded);
+        arrays[a]->size = padded;
+        for (size_t i = n; i < padded; i++) {
+            VEC_AT(arrays[a], i) = 0;
+        }
+    }
+}
+
+void nbody_free(void *aux) {
+    NBody *nbody = aux;
+    BodyPtrVec_free(&nbody->bodies);
+    DoubleVec_free(&nbody->x);
+    DoubleVec_free(&nbody->y);
+    DoubleVec_free(&nbody->mass);
+    DoubleVec_free(&nbody->pull_x);
+    DoubleVec_free(&nbody->pull_y);
+    arena_release(nbody);
+}
+
+/** A ForcePruner for n-body forces: drops the bodies marked for removal */
+void nbody_prune(void *aux) {
+    NBody *nbody = aux;
+    size_t kept = 0;
+    for (size_t i = 0; i < nbody->bodies.size; i++) {
+        Body *body = VEC_AT(&nbody->bodies, i);
+        if (!body_is_removed(body)) {
+            VEC_AT(&nbody->bodies, kept++) = body;
+        }
+    }
+    if (kept < nbody->bodies.size) {
+        nbody->bodies.size = kept;
+        nbody_resize(nbody);
+    }
+}
+
+#ifdef __SSE2__
+/**
+ * Adds body j's pull to two bodies at once, one in each lane of the vectors.
+ * A body's pull on itself is 0, since r is 0. Without softening that would
+ * be 0 / 0, so the scale is masked to 0 when the bodies coincide.
+ */
+void nbody_pull_pair(
+    __m128d xi, __m128d yi, __m128d xj, __m128d yj, __m128d mj,
+    __m128d softening2, __m128d *pull_x, __m128d *pull_y
+) {
+    __m128d dx = _mm_sub_pd(xj, xi);
+    __m128d dy = _mm_sub_pd(yj, yi);
+    __m128d r2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), \
+        _mm_mul_pd(dy, dy)), softening2);
+    // m / (|r|^2 + softening^2)^(3/2), with a single square root and division
+    __m128d scale = _mm_div_pd(mj, _mm_mul_pd(r2, _mm_sqrt_pd(r2)));
+    scale = _mm_and_pd(scale, _mm_cmpgt_pd(r2, _mm_setzero_pd()));
+    *pull_x = _mm_add_pd(*pull_x, _mm_mul_pd(scale, dx));
+    *pull_y = _mm_add_pd(*pull_y, _mm_mul_pd(scale, dy));
+}
+
+/**
+ * Adds the pulls of bodies [j_start, j_end) to the NBODY_LANES bodies
+ * starting at i, two per SSE2 vector.
+ */
+void nbody_pull_lanes(
+    NBody *nbody, size_t i, size_t j_start, size_t j_end, double softening2
+) {
+    const double *x = nbody->x.data;
+    const double *y = nbody->y.data;
+    const double *mass = nbody->mass.data;
+    __m128d soft = _mm_set1_pd(softening2);
+    __m128d x0 = _mm_loadu_pd(x + i), x1 = _mm_loadu_pd(x + i + 2);
+    __m128d y0 = _mm_loadu_pd(y + i), y1 = _mm_loadu_pd(y + i + 2);
+    double *pull_x = nbody->pull_x.data + i;
+    double *pull_y = nbody->pull_y.data + i;
+    __m128d px0 = _mm_loadu_pd(pull_x), px1 = _mm_loadu_pd(pull_x + 2);
+    __m128d py0 = _mm_loadu_pd(pull_y), py1 = _mm_loadu_pd(pull_y + 2);
+    for (size_t j = j_start; j < j_end; j++) {
+        __m128d xj = _mm_set1_pd(x[j]);
+        __m128d yj = _mm_set1_pd(y[j]);
+        __m128d mj = _mm_set1_pd(mass[j]);
+        nbody_pull_pair(x0, y0, xj, yj, mj, soft, &px0, &py0);
+        nbody_pull_pair(x1, y1, xj, yj, mj, soft, &px1, &py1);
+    }
+    _mm_storeu_pd(pull_x, px0);
+    _mm_storeu_pd(pull_x + 2, px1);
+    _mm_storeu_pd(pull_y, py0);
+    _mm_storeu_pd(pull_y + 2, py1);
+}
+#else
+/**
+ * Adds the pulls of bodies [j_start, j_end) to the NBODY_LANES bodies
+ * starting at i. The lanes are independent, so the compiler may vectorize
+ * them where SSE2 is not available.
+ */
+void nbody_pull_lanes(
+    NBody *nbody, size_t i, size_t j_start, size_t j_end, double softening2
+) {
+    const double *x = nbody->x.data;
+    const double *y = nbody->y.data;
+    const double *mass = nbody->mass.data;
+    double pull_x[NBODY_LANES], pull_y[NBODY_LANES];
+    for (size_t l = 0; l < NBODY_LANES; l++) {
+        pull_x[l] = VEC_AT(&nbody->pull_x, i + l);
+        pull_y[l] = VEC_AT(&nbody->pull_y, i + l);
+    }
+    for (size_t j = j_start; j < j_end; j++) {
+        for (size_t l = 0; l < NBODY_LANES; l++) {
+            double dx = x[j] - x[i + l];
+            double dy = y[j] - y[i + l];
+            double r2 = dx * dx + dy * dy + softening2;
+            // A body's pull on itself is 0, even without softening
+            double scale = r2 > 0 ? mass[j] / (r2 * sqrt(r2)) : 0;
+            pull_x[l] += scale * dx;
+            pull_y[l] += scale * dy;
+        }
+    }
+    for (size_t l = 0; l < NBODY_LANES; l++) {
+        VEC_AT(&nbody->pull_x, i + l) = pull_x[l];
+        VEC_AT(&nbody->pull_y, i + l) = pull_y[l];
+    }
+}
+#endif
+
+/**
+ * The ForceCreator of create_nbody_gravity().
+ * Rather than visiting each pair once and applying equal and opposite forces,
+ * it sums every body's pull on every other body. That does twice the
+ * arithmetic, but leaves each lane of the kernel with only its own body's
+ * sums to write, so there is nothing to scatter.
+ * The bodies are taken NBODY_TILE at a time, and each tile's pull is added
+ * to every body before moving on to the next, so the tile stays in cache.
+ */
+void addNBodyGravity(void *aux) {
+    NBody *nbody = aux;
+    size_t n = nbody->bodies.size;
+    for (size_t i = 0; i < n; i++) {
+        Body *body = VEC_AT(&nbody->bodies, i);
+        Vector position = body_get_centroid(body);
+        VEC_AT(&nbody->x, i) = position.x;
+        VEC_AT(&nbody->y, i) = position.y;
+        VEC_AT(&nbody->mass, i) = body_get_mass(body);
+    }
+    size_t padded = nbody->x.size;
+    for (size_t i = 0; i < padded; i++) {
+        VEC_AT(&nbody->pull_x, i) = 0;
+        VEC_AT(&nbody->pull_y, i) = 0;
+    }
+    double softening2 = nbody->softening * nbody->softening;
+    for (size_t j = 0; j < padded; j += NBODY_TILE) {
+        size_t j_end = padded - j < NBODY_TILE ? padded : j + NBODY_TILE;
+        for (size_t i = 0; i < padded; i += NBODY_LANES) {
+            nbody_pull_lanes(nbody, i, j, j_end, softening2);
+        }
+    }
+    // F = G * m * pull
+    for (size_t i = 0; i < n; i++) {
+        double scale = nbody->G * VEC_AT(&nbody->mass, i);
+        body_add_force(VEC_AT(&nbody->bodies, i), vec_init( \
+            scale * VEC_AT(&nbody->pull_x, i), \
+            scale * VEC_AT(&nbody->pull_y, i)));
+    }
+}
+
+void create_nbody_gravity(
+    Scene *scene, double G, List *bodies, double softening
+) {
+    assert(softening >= 0);
+    const Allocator *allocator = arena_allocator(scene_get_arena(scene));
+    NBody *nbody = allocator_alloc(allocator, sizeof(NBody));
+    nbody->G = G;
+    nbody->softening = softening;
+    BodyPtrVec_init(&nbody->bodies, allocator);
+    DoubleVec_init(&nbody->x, allocator);
+    DoubleVec_init(&nbody->y, allocator);
+    DoubleVec_init(&nbody->mass, allocator);
+    DoubleVec_init(&nbody->pull_x, allocator);
+    DoubleVec_init(&nbody->pull_y, allocator);
+    BodyPtrVec_reserve(&nbody->bodies, list_size(bodies));
+    for (size_t i = 0; i < list_size(bodies); i++) {
+        BodyPtrVec_push(&nbody->bodies, list_get(bodies, i));
+    }
+    nbody_resize(nbody);
+    scene_add_force_batch(scene, addNBodyGravity, nbody, nbody_prune, \
+        nbody_free);
+}
+
+/** Sizes a Barnes-Hut force's arrays for its bodies */
+void bh_resize(BarnesHut *tree) {
+    size_t n = tree->bodies.size;
+    DoubleVec *doubles[] = {&tree->x, &tree->y, &tree->mass, \
+        &tree->sorted_x, &tree->sorted_y, &tree->sorted_mass};
+    for (size_t a = 0; a < sizeof(doubles) / sizeof(doubles[0]); a++) {
+        DoubleVec_reserve(doubles[a], n);
+        doubles[a]->size = n;
+    }
+    IndexVec *indices[] = {&tree->codes, &tree->order, \
+        &tree->codes_scratch, &tree->order_scratch};
+    for (size_t a = 0; a < sizeof(indices) / sizeof(indices[0]); a++) {
+        IndexVec_reserve(indices[a], n);
+        indices[a]->size = n;
+    }
+    QuadNodeVec_reserve(&tree->nodes, BH_TOP_NODES + 2 * n);
+    tree->nodes.size = BH_TOP_NODES + 2 * n;
+}
+
+void bh_free(void *aux) {
+    BarnesHut *tree = aux;
+    BodyPtrVec_free(&tree->bodies);
+    DoubleVec_free(&tree->x);
+    DoubleVec_free(&tree->y);
+    DoubleVec_free(&tree->mass);
+    IndexVec_free(&tree->codes);
+    IndexVec_free(&tree->order);
+    IndexVec_free(&tree->codes_scratch);
+    IndexVec_free(&tree->order_scratch);
+    DoubleVec_free(&tree->sorted_x);
+    DoubleVec_free(&tree->sorted_y);
+    DoubleVec_free(&tree->sorted_mass);
+    QuadNodeVec_free(&tree->nodes);
+    SubtreeVec_free(&tree->subtrees);
+    arena_release(tree);
+}
+
+/** A ForcePruner for Barnes-Hut forces: drops the bodies marked for removal */
+void bh_prune(void *aux) {
+    BarnesHut *tree = aux;
+    size_t kept = 0;
+    for (size_t i = 0; i < tree->bodies.size; i++) {
+        Body *body = VEC_AT(&tree->bodies, i);
+        if (!body_is_removed(body)) {
+            VEC_AT(&tree->bodies, kept++) = body;
+        }
+    }
+    if (kept < tree->bodies.size) {
+        tree->bodies.size = kept;
+        bh_resize(tree);
+    }
+}
+
+/** Copies the positions and masses of bodies [start, end) into the arrays */
+void bh_gather(void *aux, size_t start, size_t end, size_t thread) {
+    BarnesHut *tree = aux;
+    for (size_t i = start; i < end; i++) {
+        Body *body = VEC_AT(&tree->bodies, i);
+        Vector position = body_get_centroid(body);
+        VEC_AT(&tree->x, i) = position.x;
+        VEC_AT(&tree->y, i) = position.y;
+        VEC_AT(&tree->mass, i) = body_get_mass(body);
+    }
+}
+
+/** Finds the square the tree covers: the smallest one around every body */
+void bh_bound(BarnesHut *tree) {
+    double min_x = INFINITY, min_y = INFINITY;
+    double max_x = -INFINITY, max_y = -INFINITY;
+    for (size_t i = 0; i < tree->bodies.size; i++) {
+        min_x = fmin(min_x, VEC_AT(&tree->x, i));
+        min_y = fmin(min_y, VEC_AT(&tree->y, i));
+        max_x = fmax(max_x, VEC_AT(&tree->x, i));
+        max_y = fmax(max_y, VEC_AT(&tree->y, i));
+    }
+    double size = fmax(max_x - min_x, max_y - min_y);
+    tree->min_x = min_x;
+    tree->min_y = min_y;
+    // A tree of bodies all at one point still needs cells of some size
+    tree->size = size > 0 ? size : 1;
+}
+
+/** Spreads the low 16 bits of a number out over its even bits */
+uint32_t spread_bits(uint32_t bits) {
+    bits &= 0xffff;
+    bits = (bits | (bits << 8)) & 0x00ff00ff;
+    bits = (bits | (bits << 4)) & 0x0f0f0f0f;
+    bits = (bits | (bits << 2)) & 0x33333333;
+    bits = (bits | (bits << 1)) & 0x55555555;
+    return bits;
+}
+
+/**
+ * Computes the Morton codes of bodies [start, end): their cells on a
+ * 2^16 by 2^16 grid over the tree's square, with the bits of the cell's
+ * column and row interleaved, so that each pair of bits picks a quadrant.
+ */
+void bh_encode(void *aux, size_t start, size_t end, size_t thread) {
+    BarnesHut *tree = aux;
+    const uint32_t cells = 1u << BH_LEVELS;
+    double scale = cells / tree->size;
+    for (size_t i = start; i < end; i++) {
+        uint32_t column = (VEC_AT(&tree->x, i) - tree->min_x) * scale;
+        uint32_t row = (VEC_AT(&tree->y, i) - tree->min_y) * scale;
+        // The bodies on the far edges belong in the last cell
+        column = column < cells ? column : cells - 1;
+        row = row < cells ? row : cells - 1;
+        VEC_AT(&tree->codes, i) = spread_bits(column) \
+            | (spread_bits(row) << 1);
+        VEC_AT(&tree->order, i) = i;
+    }
+}
+
+/** Sorts the bodies' Morton codes, and their indices with them */
+void bh_sort(BarnesHut *tree) {
+    size_t n = tree->bodies.size;
+    uint32_t *codes = tree->codes.data, *order = tree->order.data;
+    uint32_t *codes_out = tree->codes_scratch.data;
+    uint32_t *order_out = tree->order_scratch.data;
+    // A radix sort of one byte at a time, so it ends in the original arrays
+    for (size_t shift = 0; shift < 32; shift += 8) {
+        size_t counts[256] = {0};
+        for (size_t i = 0; i < n; i++) {
+            counts[(codes[i] >> shift) & 0xff]++;
+        }
+        size_t position = 0;
+        for (size_t digit = 0; digit < 256; digit++) {
+            size_t count = counts[digit];
+            counts[digit] = position;
+            position += count;
+        }
+        for (size_t i = 0; i < n; i++) {
+            size_t to = counts[(codes[i] >> shift) & 0xff]++;
+            codes_out[to] = codes[i];
+            order_out[to] = order[i];
+        }
+        uint32_t *swap = codes;
+        codes = codes_out;
+        codes_out = swap;
+        swap = order;
+        order = order_out;
+        order_out = swap;
+    }
+}
+
+/** Copies the positions and masses of bodies [start, end) in Morton order */
+void bh_permute(void *aux, size_t start, size_t end, size_t thread) {
+    BarnesHut *tree = aux;
+    for (size_t p = start; p < end; p++) {
+        uint32_t i = VEC_AT(&tree->order, p);
+        VEC_AT(&tree->sorted_x, p) = VEC_AT(&tree->x, i);
+        VEC_AT(&tree->sorted_y, p) = VEC_AT(&tree->y, i);
+        VEC_AT(&tree->sorted_mass, p) = VEC_AT(&tree->mass, i);
+    }
+}
+
+/** Gets the two bits of a Morton code that pick its quadrant at a level */
+uint32_t morton_quadrant(uint32_t code, size_t level) {
+    return (code >> (2 * (BH_LEVELS - 1 - level))) & 3;
+}
+
+/** Sets a leaf's mass and center of mass from its bodies */
+void bh_leaf_moments(BarnesHut *tree, QuadNode *node) {
+    double mass = 0, x = 0, y = 0;
+    for (size_t p = node->start; p < node->end; p++) {
+        double m = VEC_AT(&tree->sorted_mass, p);
+        mass += m;
+        x += m * VEC_AT(&tree->sorted_x, p);
+        y += m * VEC_AT(&tree->sorted_y, p);
+    }
+    node->mass = mass;
+    node->x = mass > 0 ? x / mass : VEC_AT(&tree->sorted_x, node->start);
+    node->y = mass > 0 ? y / mass : VEC_AT(&tree->sorted_y, node->start);
+}
+
+/** Sets a node's mass and center of mass from its children's */
+void bh_node_moments(BarnesHut *tree, QuadNode *node) {
+    double mass = 0, x = 0, y = 0;
+    for (size_t c = 0; c < node->children; c++) {
+        QuadNode *child = &VEC_AT(&tree->nodes, node->first_child + c);
+        mass += child->mass;
+        x += child->mass * child->x;
+        y += child->mass * child->y;
+    }
+    node->mass = mass;
+    node->x = mass > 0 ? x / mass : VEC_AT(&tree->sorted_x, node->start);
+    node->y = mass > 0 ? y / mass : VEC_AT(&tree->sorted_y, node->start);
+}
+
+/**
+ * Gets the end of the bodies in [start, end) that are in the same quadrant
+ * at a level as the body at start, which all the others are at or after.
+ */
+uint32_t bh_quadrant_end(
+    const uint32_t *codes, uint32_t start, uint32_t end, size_t level
+) {
+    uint32_t quadrant = morton_quadrant(codes[start], level);
+    uint32_t low = start + 1, high = end;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        if (morton_quadrant(codes[middle], level) == quadrant) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/**
+ * Builds the tree under a node whose bodies have been set, taking its
+ * descendants from the nodes at *next onwards.
+ * When building the top of the tree, it stops at BH_TOP_DEPTH, recording
+ * the nodes there in subtrees, and leaves the moments of the nodes above
+ * them for bh_top_moments().
+ */
+void bh_build_node(
+    BarnesHut *tree, uint32_t index, size_t level, size_t depth,
+    uint32_t *next, bool top
+) {
+    QuadNode *node = &VEC_AT(&tree->nodes, index);
+    const uint32_t *codes = tree->codes.data;
+    uint32_t start = node->start, end = node->end;
+    bool leaf = end - start <= BH_LEAF_BODIES;
+    while (!leaf && level < BH_LEVELS && morton_quadrant(codes[start], level) \
+            == morton_quadrant(codes[end - 1], level)) {
+        level++;
+    }
+    node->size = ldexp(tree->size, -(int) level);
+    node->children = 0;
+    if (leaf || level == BH_LEVELS) {
+        bh_leaf_moments(tree, node);
+        return;
+    }
+    // The bodies are in Morton order, so each quadrant's are contiguous
+    node->first_child = *next;
+    for (uint32_t child_start = start; child_start < end; ) {
+        uint32_t child_end = bh_quadrant_end(codes, child_start, end, level);
+        QuadNode *child = &VEC_AT(&tree->nodes, *next + node->children);
+        child->start = child_start;
+        child->end = child_end;
+        node->children++;
+        child_start = child_end;
+    }
+    *next += node->children;
+    for (uint32_t c = 0; c < node->children; c++) {
+        uint32_t child = node->first_child + c;
+        if (top && depth + 1 == BH_TOP_DEPTH) {
+            SubtreeVec_push(&tree->subtrees, \
+                (Subtree) {.node = child, .level = level + 1});
+        } else {
+            bh_build_node(tree, child, level + 1, depth + 1, next, top);
+        }
+    }
+    if (!top) {
+        bh_node_moments(tree, node);
+    }
+}
+
+/** Builds the subtrees [start, end) below the top of the tree */
+void bh_build_subtrees(void *aux, size_t start, size_t end, size_t thread) {
+    BarnesHut *tree = aux;
+    for (size_t k = start; k < end; k++) {
+        Subtree subtree = VEC_AT(&tree->subtrees, k);
+        uint32_t next = BH_TOP_NODES + 2 * VEC_AT(&tree->nodes, \
+            subtree.node).start;
+        bh_build_node(tree, subtree.node, subtree.level, BH_TOP_DEPTH, \
+            &next, false);
+    }
+}
+
+/** Sets the moments of the nodes above BH_TOP_DEPTH, once their subtrees' are */
+void bh_top_moments(BarnesHut *tree, uint32_t index, size_t depth) {
+    QuadNode *node = &VEC_AT(&tree->nodes, index);
+    if (node->children == 0 || depth == BH_TOP_DEPTH) {
+        return;
+    }
+    for (uint32_t c = 0; c < node->children; c++) {
+        bh_top_moments(tree, node->first_child + c, depth + 1);
+    }
+    bh_node_moments(tree, node);
+}
+
+/**
+ * Applies gravity to the bodies at [start, end) in Morton order, walking the
+ * tree from the root for each. A node whose size is less than theta times
+ * its distance pulls as one mass at its center of mass; closer nodes are
+ * opened, down to leaves, whose bodies pull one by one.
+ * Consecutive bodies in Morton order are near each other, so they open
+ * mostly the same nodes, which are then still in cache.
+ */
+void bh_walk(void *aux, size_t start, size_t end, size_t thread) {
+    BarnesHut *tree = aux;
+    const QuadNode *nodes = tree->nodes.data;
+    const double *x = tree->sorted_x.data;
+    const double *y = tree->sorted_y.data;
+    const double *mass = tree->sorted_mass.data;
+    double softening2 = tree->softening * tree->softening;
+    double theta2 = tree->theta * tree->theta;
+    uint32_t stack[BH_STACK_SIZE];
+    for (size_t p = start; p < end; p++) {
+        double pull_x = 0, pull_y = 0;
+        size_t waiting = 0;
+        stack[waiting++] = 0;
+        while (waiting > 0) {
+            const QuadNode *node = &nodes[stack[--waiting]];
+            double dx = node->x - x[p], dy = node->y - y[p];
+            double distance2 = dx * dx + dy * dy;
+            if (node->size * node->size < theta2 * distance2) {
+                double r2 = distance2 + softening2;
+                double scale = node->mass / (r2 * sqrt(r2));
+                pull_x += scale * dx;
+                pull_y += scale * dy;
+            } else if (node->children == 0) {
+                for (size_t q = node->start; q < node->end; q++) {
+                    double qx = x[q] - x[p], qy = y[q] - y[p];
+                    double r2 = qx * qx + qy * qy + softening2;
+                    // A body's pull on itself is 0, even without softening
+                    double scale = r2 > 0 ? mass[q] / (r2 * sqrt(r2)) : 0;
+                    pull_x += scale * qx;
+                    pull_y += scale * qy;
+                }
+            } else {
+                for (uint32_t c = 0; c < node->children; c++) {
+                    stack[waiting++] = node->first_child + c;
+                }
+            }
+        }
+        // F = G * m * pull, and this is the only thread touching this body
+        double scale = tree->G * mass[p];
+        Body *body = VEC_AT(&tree->bodies, VEC_AT(&tree->order, p));
+        body_add_force(body, vec_init(scale * pull_x, scale * pull_y));
+    }
+}
+
+/**
+ * The ForceCreator of create_barnes_hut_gravity(). It rebuilds the tree
+ * from the bodies' current positions, then walks it for each body, with
+ * every step but the bounding square and the sort on the scene's threads.
+ */
+void addBarnesHutGravity(void *aux) {
+    BarnesHut *tree = aux;
+    size_t n = tree->bodies.size;
+    if (n == 0) {
+        return;
+    }
+    ThreadPool *pool = scene_get_thread_pool(tree->scene);
+    thread_pool_for(pool, n, BH_CHUNK_BODIES, bh_gather, tree);
+    bh_bound(tree);
+    thread_pool_for(pool, n, BH_CHUNK_BODIES, bh_encode, tree);
+    bh_sort(tree);
+    thread_pool_for(pool, n, BH_CHUNK_BODIES, bh_permute, tree);
+
+    QuadNode *root = &VEC_AT(&tree->nodes, 0);
+    root->start = 0;
+    root->end = n;
+    uint32_t next = 1;
+    SubtreeVec_clear(&tree->subtrees);
+    bh_build_node(tree, 0, 0, 0, &next, true);
+    thread_pool_for(pool, tree->subtrees.size, 1, bh_build_subtrees, tree);
+    bh_top_moments(tree, 0, 0);
+
+    thread_pool_for(pool, n, BH_CHUNK_BODIES, bh_walk, tree);
+}
+
+void create_barnes_hut_gravity(
+    Scene *scene, double G, List *bodies, double softening, double theta
+) {
+    assert(softening >= 0);
+    assert(theta >= 0);
+    const Allocator *allocator = arena_allocator(scene_get_arena(scene));
+    BarnesHut *tree = allocator_alloc(allocator, sizeof(BarnesHut));
+    tree->scene = scene;
+    tree->G = G;
+    tree->softening = softening;
+    tree->theta = theta;
+    BodyPtrVec_init(&tree->bodies, allocator);
+    DoubleVec_init(&tree->x, allocator);
+    DoubleVec_init(&tree->y, allocator);
+    DoubleVec_init(&tree->mass, allocator);
+    IndexVec_init(&tree->codes, allocator);
+    IndexVec_init(&tree->order, allocator);
+    IndexVec_init(&tree->codes_scratch, allocator);
+    IndexVec_init(&tree->order_scratch, allocator);
+    DoubleVec_init(&tree->sorted_x, allocator);
+    DoubleVec_init(&tree->sorted_y, allocator);
+    DoubleVec_init(&tree->sorted_mass, allocator);
+    QuadNodeVec_init(&tree->nodes, allocator);
+    SubtreeVec_init(&tree->subtrees, allocator);
+    // Room for every node at BH_TOP_DEPTH, so building never allocates
+    SubtreeVec_reserve(&tree->subtrees, 1 << (2 * BH_TOP_DEPTH));
+    BodyPtrVec_reserve(&tree->bodies, list_size(bodies));
+    for (size_t i = 0; i < list_size(bodies); i++) {
+        BodyPtrVec_push(&tree->bodies, list_get(bodies, i));
+    }
+    bh_resize(tree);
+    scene_add_parallel_force_batch(scene, addBarnesHutGravity, tree, \
+        bh_prune, bh_free);
+}
+
+/** Sets a DoubleVec's size, leaving any new elements unset */
+void double_vec_resize(DoubleVec *vec, size_t size) {
+    DoubleVec_reserve(vec, size);
+    vec->size = size;
+}
+
+/** Like double_vec_resize(), for an IndexVec */
+void index_vec_resize(IndexVec *vec, size_t size) {
+    IndexVec_reserve(vec, size);
+    vec->size = size;
+}
+
+void spring_network_free(void *aux) {
+    SpringNetwork *network = aux;
+    force_batch_free(network->springs);
+    DoubleVec_free(&network->gamma);
+    IndexVec_free(&network->row_start);
+    IndexVec_free(&network->column);
+    IndexVec_free(&network->entry_spring);
+    IndexVec_free(&network->next_entry);
+    DoubleVec_free(&network->moving);
+    DoubleVec_free(&network->diagonal);
+    DoubleVec_free(&network->coupling);
+    DoubleVec_free(&network->rhs);
+    DoubleVec_free(&network->velocity);
+    DoubleVec_free(&network->residual);
+    DoubleVec_free(&network->preconditioned);
+    DoubleVec_free(&network->direction);
+    DoubleVec_free(&network->product);
+    DoubleVec_free(&network->partial);
+    arena_release(network);
+}
+
+/**
+ * A ForcePruner for spring networks: drops the bodies marked for removal
+ * and the springs on them.
+ */
+void spring_network_prune(void *aux) {
+    SpringNetwork *network = aux;
+    ForceBatch *springs = network->springs;
+    size_t body_count = springs->bodies.size;
+    force_batch_prune(springs);
+    if (springs->bodies.size == body_count) {
+        return;
+    }
+    // Move each surviving body's drag to its new index
+    for (size_t i = 0; i < body_count; i++) {
+        uint32_t index = VEC_AT(&springs->renumbered, i);
+        if (index != NO_BATCH_INDEX) {
+            VEC_AT(&network->gamma, index) = VEC_AT(&network->gamma, i);
+        }
+    }
+    network->gamma.size = springs->bodies.size;
+    network->assembled = false;
+}
+
+/**
+ * Builds the sparse rows of a spring network's stiffness matrix from its
+ * springs, and sizes the arrays the solve uses.
+ */
+void spring_network_assemble(SpringNetwork *network) {
+    ForceBatch *springs = network->springs;
+    size_t n = springs->bodies.size;
+    size_t terms = springs->first.size;
+    index_vec_resize(&network->row_start, n + 1);
+    index_vec_resize(&network->next_entry, n);
+    uint32_t *row_start = network->row_start.data;
+    for (size_t i = 0; i <= n; i++) {
+        row_start[i] = 0;
+    }
+    const uint32_t *first = springs->first.data;
+    const uint32_t *second = springs->second.data;
+    for (size_t t = 0; t < terms; t++) {
+        // A spring from a body to itself exerts no force
+        if (first[t] != second[t]) {
+            row_start[first[t] + 1]++;
+            row_start[second[t] + 1]++;
+        }
+    }
+    for (size_t i = 0; i < n; i++) {
+        row_start[i + 1] += row_start[i];
+        VEC_AT(&network->next_entry, i) = row_start[i];
+    }
+    size_t entries = row_start[n];
+    index_vec_resize(&network->column, entries);
+    index_vec_resize(&network->entry_spring, entries);
+    uint32_t *next_entry = network->next_entry.data;
+    for (size_t t = 0; t < terms; t++) {
+        if (first[t] != second[t]) {
+            uint32_t entry = next_entry[first[t]]++;
+            VEC_AT(&network->column, entry) = second[t];
+            VEC_AT(&network->entry_spring, entry) = t;
+            entry = next_entry[second[t]]++;
+            VEC_AT(&network->column, entry) = first[t];
+            VEC_AT(&network->entry_spring, entry) = t;
+        }
+    }
+    double_vec_resize(&network->coupling, entries);
+    double_vec_resize(&network->moving, n);
+    double_vec_resize(&network->diagonal, n);
+    DoubleVec *interleaved[] = {&network->rhs, &network->velocity, \
+        &network->residual, &network->preconditioned, &network->direction, \
+        &network->product};
+    for (size_t a = 0; a < sizeof(interleaved) / sizeof(interleaved[0]); a++) {
+        double_vec_resize(interleaved[a], 2 * n);
+    }
+    double_vec_resize(&network->partial, \
+        (n + SPRING_CHUNK_BODIES - 1) / SPRING_CHUNK_BODIES);
+    network->assembled = true;
+}
+
+/** Whether a spring network solves for a body's velocity */
+bool spring_network_moves(Body *body) {
+    return (body_get_motion(body) & MOTION_FORCES)
+        && body_get_type(body) == BODY_DYNAMIC
+        && !body_is_sleeping(body)
+        && body_get_mass(body) != INFINITY;
+}
+
+/**
+ * Fills in a spring network's system for this tick from its gathered bodies,
+ * and starts the solution at their current velocities.
+ */
+void spring_network_setup(SpringNetwork *network, double dt) {
+    ForceBatch *springs = network->springs;
+    size_t n = springs->bodies.size;
+    const double *vx = springs->vx.data;
+    const double *vy = springs->vy.data;
+    const double *mass = springs->mass.data;
+    const double *gamma = network->gamma.data;
+    double *moving = network->moving.data;
+    double *diagonal = network->diagonal.data;
+    double *rhs = network->rhs.data;
+    double *velocity = network->velocity.data;
+    Vector gravity = scene_get_gravity(network->scene);
+    for (size_t i = 0; i < n; i++) {
+        Body *body = VEC_AT(&springs->bodies, i);
+        moving[i] = spring_network_moves(body);
+        velocity[2 * i] = vx[i];
+        velocity[2 * i + 1] = vy[i];
+        if (moving[i]) {
+            // The scene's gravity is part of the solve, so the springs
+            // hold a hanging body still
+            double fall = dt * body_get_gravity_scale(body);
+            diagonal[i] = mass[i] + dt * gamma[i];
+            rhs[2 * i] = mass[i] * (vx[i] + fall * gravity.x);
+            rhs[2 * i + 1] = mass[i] * (vy[i] + fall * gravity.y);
+        } else {
+            diagonal[i] = 1;
+            rhs[2 * i] = vx[i];
+            rhs[2 * i + 1] = vy[i];
+        }
+    }
+
+    const uint32_t *first = springs->first.data;
+    const uint32_t *second = springs->second.data;
+    const double *k = springs->constant.data;
+    const double *x = springs->x.data;
+    const double *y = springs->y.data;
+    for (size_t t = 0; t < springs->first.size; t++) {
+        uint32_t i = first[t], j = second[t];
+        if (i == j) {
+            continue;
+        }
+        // The spring's pull on body i at the end of the tick is
+        // k (x_j - x_i + dt (v_j - v_i)); the parts known now go into rhs
+        double pull_x = dt * k[t] * (x[j] - x[i]);
+        double pull_y = dt * k[t] * (y[j] - y[i]);
+        double stiffness = dt * dt * k[t];
+        if (moving[i]) {
+            diagonal[i] += stiffness;
+            rhs[2 * i] += pull_x + (1 - moving[j]) * stiffness * vx[j];
+            rhs[2 * i + 1] += pull_y + (1 - moving[j]) * stiffness * vy[j];
+        }
+        if (moving[j]) {
+            diagonal[j] += stiffness;
+            rhs[2 * j] += -pull_x + (1 - moving[i]) * stiffness * vx[i];
+            rhs[2 * j + 1] += -pull_y + (1 - moving[i]) * stiffness * vy[i];
+        }
+    }
+
+    const uint32_t *column = network->column.data;
+    const uint32_t *entry_spring = network->entry_spring.data;
+    double *coupling = network->coupling.data;
+    const uint32_t *row_start = network->row_start.data;
+    for (size_t i = 0; i < n; i++) {
+        for (uint32_t e = row_start[i]; e < row_start[i + 1]; e++) {
+            coupling[e] = moving[i] * moving[column[e]] * \
+                dt * dt * k[entry_spring[e]];
+        }
+    }
+}
+
+/**
+ * Multiplies the rows [start, end) of a spring network's matrix by its
+ * search direction into product, and records their share of
+ * direction . product in the chunk's partial sum.
+ */
+void spring_network_multiply(
+    void *aux, size_t start, size_t end, size_t thread
+) {
+    SpringNetwork *network = aux;
+    const uint32_t *restrict row_start = network->row_start.data;
+    const uint32_t *restrict column = network->column.data;
+    const double *restrict coupling = network->coupling.data;
+    const double *restrict diagonal = network->diagonal.data;
+    const double *restrict direction = network->direction.data;
+    double *restrict product = network->product.data;
+    double dot = 0;
+    for (size_t i = start; i < end; i++) {
+        double sum_x = diagonal[i] * direction[2 * i];
+        double sum_y = diagonal[i] * direction[2 * i + 1];
+        for (uint32_t e = row_start[i]; e < row_start[i + 1]; e++) {
+            sum_x -= coupling[e] * direction[2 * column[e]];
+            sum_y -= coupling[e] * direction[2 * column[e] + 1];
+        }
+        product[2 * i] = sum_x;
+        product[2 * i + 1] = sum_y;
+        dot += direction[2 * i] * sum_x + direction[2 * i + 1] * sum_y;
+    }
+    VEC_AT(&network->partial, start / SPRING_CHUNK_BODIES) = dot;
+}
+
+/**
+ * Sets product to the network's matrix times its search direction,
+ * on the scene's threads, and returns direction . product.
+ */
+double spring_network_apply_matrix(SpringNetwork *network) {
+    thread_pool_for(scene_get_thread_pool(network->scene), \
+        network->springs->bodies.size, SPRING_CHUNK_BODIES, \
+        spring_network_multiply, network);
+    double dot = 0;
+    VEC_FOREACH(double, partial, &network->partial) {
+        dot += *partial;
+    }
+    return dot;
+}
+
+/**
+ * Sets the preconditioned residual to the residual divided by the matrix's
+ * diagonal (a Jacobi preconditioner), and returns residual . preconditioned.
+ * The squared length of the residual is stored in residual_squared.
+ */
+double spring_network_precondition(
+    SpringNetwork *network, double *residual_squared
+) {
+    size_t n = network->springs->bodies.size;
+    const double *diagonal = network->diagonal.data;
+    const double *residual = network->residual.data;
+    double *preconditioned = network->preconditioned.data;
+    double dot = 0;
+    double squared = 0;
+    for (size_t i = 0; i < 2 * n; i++) {
+        preconditioned[i] = residual[i] / diagonal[i / 2];
+        dot += residual[i] * preconditioned[i];
+        squared += residual[i] * residual[i];
+    }
+    *residual_squared = squared;
+    return dot;
+}
+
+/**
+ * Solves a spring network's system for velocity with the preconditioned
+ * conjugate gradient method (see
+ * https://en.wikipedia.org/wiki/Conjugate_gradient_method), which only needs
+ * the sparse matrix's products with vectors. The matrix is symmetric and
+ * positive definite, so each iteration brings the solution closer.
+ */
+void spring_network_solve(SpringNetwork *network) {
+    size_t length = 2 * network->springs->bodies.size;
+    double *rhs = network->rhs.data;
+    double *velocity = network->velocity.data;
+    double *residual = network->residual.data;
+    double *preconditioned = network->preconditioned.data;
+    double *direction = network->direction.data;
+    double *product = network->product.data;
+
+    memcpy(direction, velocity, length * sizeof(double));
+    spring_network_apply_matrix(network);
+    double rhs_squared = 0;
+    for (size_t i = 0; i < length; i++) {
+        residual[i] = rhs[i] - product[i];
+        rhs_squared += rhs[i] * rhs[i];
+    }
+    double residual_squared;
+    double rz = spring_network_precondition(network, &residual_squared);
+    memcpy(direction, preconditioned, length * sizeof(double));
+    double threshold = SPRING_TOLERANCE * SPRING_TOLERANCE * rhs_squared;
+    // Exact arithmetic would converge within length iterations
+    for (size_t iteration = 0; iteration < length \
+            && residual_squared > threshold; iteration++) {
+        double curvature = spring_network_apply_matrix(network);
+        if (!(curvature > 0)) {
+            break;
+        }
+        double alpha = rz / curvature;
+        for (size_t i = 0; i < length; i++) {
+            velocity[i] += alpha * direction[i];
+            residual[i] -= alpha * product[i];
+        }
+        double next_rz = spring_network_precondition(network, \
+            &residual_squared);
+        double beta = next_rz / rz;
+        rz = next_rz;
+        for (size_t i = 0; i < length; i++) {
+            direction[i] = preconditioned[i] + beta * direction[i];
+        }
+    }
+}
+
+/**
+ * The ForceCreator of a spring network: solves for the bodies' velocities at
+ * the end of the tick and moves the bodies with them.
+ */
+void addSpringNetwork(void *aux) {
+    SpringNetwork *network = aux;
+    ForceBatch *springs = network->springs;
+    size_t n = springs->bodies.size;
+    if (n == 0) {
+        return;
+    }
+    if (!network->assembled) {
+        spring_network_assemble(network);
+    }
+    double dt = scene_get_dt(network->scene);
+    force_batch_gather(springs);
+    spring_network_setup(network, dt);
+    spring_network_solve(network);
+
+    const double *velocity = network->velocity.data;
+    const double *moving = network->moving.data;
+    if (scene_get_integrator(network->scene) == INTEGRATOR_AVERAGE_VELOCITY) {
+        // That integrator moves a body with the average of its velocities
+        // before and after the tick, so the bodies take their new velocities
+        // now and move with them for the whole tick, as in backward Euler.
+        // The solve already included the scene's gravity, so it is held off.
+        Vector gravity = scene_get_gravity(network->scene);
+        for (size_t i = 0; i < n; i++) {
+            if (!moving[i]) {
+                continue;
+            }
+            Body *body = VEC_AT(&springs->bodies, i);
+            body_set_velocity(body, \
+                vec_init(velocity[2 * i], velocity[2 * i + 1]));
+            body_add_force(body, vec_multiply(-springs->mass.data[i] * \
+                body_get_gravity_scale(body), gravity));
+        }
+        return;
+    }
+
+    // Otherwise, add the springs' and drag's forces at the end of the tick,
+    // which take each moving body to its new velocity
+    const double *gamma = network->gamma.data;
+    const uint32_t *first = springs->first.data;
+    const uint32_t *second = springs->second.data;
+    const double *k = springs->constant.data;
+    const double *x = springs->x.data;
+    const double *y = springs->y.data;
+    double *force_x = springs->force_x.data;
+    double *force_y = springs->force_y.data;
+    for (size_t i = 0; i < n; i++) {
+        force_x[i] = -gamma[i] * velocity[2 * i];
+        force_y[i] = -gamma[i] * velocity[2 * i + 1];
+    }
+    for (size_t t = 0; t < springs->first.size; t++) {
+        uint32_t i = first[t], j = second[t];
+        double pull_x = k[t] * (x[j] - x[i] + \
+            dt * (velocity[2 * j] - velocity[2 * i]));
+        double pull_y = k[t] * (y[j] - y[i] + \
+            dt * (velocity[2 * j + 1] - velocity[2 * i + 1]));
+        force_x[i] += pull_x;
+        force_y[i] += pull_y;
+        force_x[j] -= pull_x;
+        force_y[j] -= pull_y;
+    }
+    for (size_t i = 0; i < n; i++) {
+        body_add_force(VEC_AT(&springs->bodies, i), \
+            vec_init(force_x[i], force_y[i]));
+    }
+}
+
+SpringNetwork *create_spring_network(Scene *scene) {
+    const Allocator *allocator = arena_allocator(scene_get_arena(scene));
+    SpringNetwork *network = allocator_alloc(allocator, sizeof(SpringNetwork));
+    network->scene = scene;
+    network->springs = force_batch_init(scene);
+    DoubleVec_init(&network->gamma, allocator);
+    IndexVec_init(&network->row_start, allocator);
+    IndexVec_init(&network->column, allocator);
+    IndexVec_init(&network->entry_spring, allocator);
+    IndexVec_init(&network->next_entry, allocator);
+    network->assembled = false;
+    DoubleVec_init(&network->moving, allocator);
+    DoubleVec_init(&network->diagonal, allocator);
+    DoubleVec_init(&network->coupling, allocator);
+    DoubleVec_init(&network->rhs, allocator);
+    DoubleVec_init(&network->velocity, allocator);
+    DoubleVec_init(&network->residual, allocator);
+    DoubleVec_init(&network->preconditioned, allocator);
+    DoubleVec_init(&network->direction, allocator);
+    DoubleVec_init(&network->product, allocator);
+    DoubleVec_init(&network->partial, allocator);
+    scene_add_parallel_force_batch(scene, addSpringNetwork, network, \
+        spring_network_prune, spring_network_free);
+    return network;
+}
+
+/** Gets a body's index in a spring network, adding it if it is new */
+uint32_t spring_network_body(SpringNetwork *network, Body *body) {
+    uint32_t index = force_batch_body(network->springs, body);
+    if (index == network->gamma.size) {
+        DoubleVec_push(&network->gamma, 0);
+    }
+    return index;
+}
+
+void spring_network_add_spring(
+    SpringNetwork *network, double k, Body *body1, Body *body2
+) {
+    assert(network);
+    assert(k >= 0);
+    assert(can_batch(body1, body2));
+    ForceBatch *springs = network->springs;
+    IndexVec_push(&springs->first, spring_network_body(network, body1));
+    IndexVec_push(&springs->second, spring_network_body(network, body2));
+    DoubleVec_push(&springs->constant, k);
+    DoubleVec_push(&springs->term_x, 0);
+    DoubleVec_push(&springs->term_y, 0);
+    network->assembled = false;
+}
+
+void spring_network_add_drag(SpringNetwork *network, double gamma, Body *body) {
+    assert(network);
+    assert(gamma >= 0);
+    assert(can_batch(body, NULL));
+    uint32_t index = spring_network_body(network, body);
+    VEC_AT(&network->gamma, index) += gamma;
+    network->assembled = false;
+}
+
+void collision_aux_freer(void *a) {
+    CollisionAux *aux = a;
+    if (aux->info_freer) {
+        aux->info_freer(aux->info);
+    }
+    list_free(aux->bodies);
+    allocator_free(aux->allocator, aux);
+}
+
 void create_collision(
     Scene *scene,
     Body *body1,
@@ -194,38 +1758,42 @@ void create_collision(
     void *aux,
     FreeFunc freer
 ) {
-    CollisionAux* c_aux = malloc(sizeof(CollisionAux));
-    assert(c_aux);
+    Arena *arena = scene_get_arena(scene);
+    const Allocator *allocator = arena_allocator(arena);
+    if (freer && !arena_contains(arena, aux)) {
+        allocator = allocator_global();
+    }
+    // The list of bodies is stored right after the aux in the same block
+    CollisionAux* c_aux = allocator_alloc(allocator, \
+        sizeof(CollisionAux) + list_inline_size(2));
     c_aux->handler = handler;
     c_aux->info = aux;
-    c_aux->bodies = list_init(2, body_free);
+    c_aux->info_freer = freer;
+    c_aux->allocator = allocator;
+    c_aux->bodies = list_init_in(c_aux + 1, allocator, 2, NULL);
     list_add(c_aux->bodies, body1);
     list_add(c_aux->bodies, body2);
     scene_add_bodies_force_creator(scene, addCollision, c_aux, \
-        c_aux->bodies, freer);
+        c_aux->bodies, collision_aux_freer);
 }
 
 void create_physics_collision(
     Scene *scene, double elasticity, Body *body1, Body *body2
 ) {
-    Elas *e = malloc(sizeof(Elas));
-    assert(e);
+    Elas *e = allocator_alloc(arena_allocator(scene_get_arena(scene)), \
+        sizeof(Elas));
     e->elasticity = elasticity;
-    create_collision(scene, body1, body2, handlePhysicsCollision, e, aux_freer);
+    create_collision(scene, body1, body2, handlePhysicsCollision, e, \
+        arena_release);
 }
 
 void create_destructive_collision(Scene *scene, Body *body1, Body *body2) {
-    CollisionAux* aux = malloc(sizeof(CollisionAux));
-    assert(aux);
-    aux->handler = handleDestructiveCollision;
-    aux->bodies = list_init(2, body_free);
-    list_add(aux->bodies, body1);
-    list_add(aux->bodies, body2);
-    create_collision(scene, body1, body2, handleDestructiveCollision, aux, aux_freer);
+    create_collision(scene, body1, body2, handleDestructiveCollision, \
+        NULL, NULL);
 }
 
 void aux_freer(void *a) {
     ForceAux *aux = a;
-    free(aux->bodies);
-    free(aux);
+    list_free(aux->bodies);
+    arena_release(aux);
 }
@@ -0,0 +1,131 @@
+#include "game_loop.h"
+#include "vec.h"
+#include <assert.h>
+#include <math.h>
+
+DEFINE_VEC(Vector)
+DEFINE_VEC(BodyHandle)
+
+struct gameLoop {
+    double step;
+    size_t max_substeps;
+    double accumulator;
+    double dropped;
+    // Where each body was before the last step, in scene order then
+    BodyHandleVec previous_handles;
+    VectorVec previous_centroids;
+    VectorVec offsets;
+};
+
+GameLoop *game_loop_init(double step, size_t max_substeps) {
+    assert(step > 0);
+    assert(max_substeps > 0);
+    const Allocator *allocator = allocator_global();
+    GameLoop *loop = allocator_alloc(allocator, sizeof(GameLoop));
+    loop->step = step;
+    loop->max_substeps = max_substeps;
+    loop->accumulator = 0;
+    loop->dropped = 0;
+    BodyHandleVec_init(&loop->previous_handles, allocator);
+    VectorVec_init(&loop->previous_centroids, allocator);
+    VectorVec_init(&loop->offsets, allocator);
+    return loop;
+}
+
+void game_loop_free(GameLoop *loop) {
+    assert(loop);
+    BodyHandleVec_free(&loop->previous_handles);
+    VectorVec_free(&loop->previous_centroids);
+    VectorVec_free(&loop->offsets);
+    allocator_free(allocator_global(), loop);
+}
+
+double game_loop_get_step(GameLoop *loop) {
+    assert(loop);
+    return loop->step;
+}
+
+size_t game_loop_advance(GameLoop *loop, double frame_time) {
+    assert(loop);
+    assert(frame_time >= 0);
+    loop->accumulator += frame_time;
+    size_t steps = 0;
+    while (loop->accumulator >= loop->step && steps < loop->max_substeps) {
+        loop->accumulator -= loop->step;
+        steps++;
+    }
+    if (loop->accumulator >= loop->step) {
+        // Drop the whole steps we can't afford but keep the fraction,
+        // so alpha stays continuous
+        double excess = loop->accumulator - fmod(loop->accumulator, loop->step);
+        loop->accumulator -= excess;
+        loop->dropped += excess;
+    }
+    return steps;
+}
+
+/** Records where each body in a scene is, for game_loop_render_offsets() */
+void game_loop_snapshot(GameLoop *loop, Scene *scene) {
+    size_t body_count = scene_bodies(scene);
+    BodyHandleVec_clear(&loop->previous_handles);
+    VectorVec_clear(&loop->previous_centroids);
+    BodyHandleVec_reserve(&loop->previous_handles, body_count);
+    VectorVec_reserve(&loop->previous_centroids, body_count);
+    for (size_t i = 0; i < body_count; i++) {
+        Body *body = scene_get_body(scene, i);
+        BodyHandleVec_push(&loop->previous_handles, body_get_handle(body));
+        VectorVec_push(&loop->previous_centroids, body_get_centroid(body));
+    }
+}
+
+size_t game_loop_tick_scene(GameLoop *loop, Scene *scene, double frame_time) {
+    assert(scene);
+    size_t steps = game_loop_advance(loop, frame_time);
+    for (size_t i = 0; i < steps; i++) {
+        if (i == steps - 1) {
+            game_loop_snapshot(loop, scene);
+        }
+        scene_tick(scene, loop->step);
+    }
+    return steps;
+}
+
+double game_loop_alpha(GameLoop *loop) {
+    assert(loop);
+    double alpha = loop->accumulator / loop->step;
+    return alpha < 1 ? alpha : nextafter(1, 0);
+}
+
+double game_loop_dropped_time(GameLoop *loop) {
+    assert(loop);
+    return loop->dropped;
+}
+
+const Vector *game_loop_render_offsets(GameLoop *loop, Scene *scene) {
+    assert(loop);
+    assert(scene);
+    size_t body_count = scene_bodies(scene);
+    double behind = 1 - game_loop_alpha(loop);
+    VectorVec_clear(&loop->offsets);
+    VectorVec_reserve(&loop->offsets, body_count);
+    // The scene keeps its bodies in order as it removes some and appends
+    // others, so one pass over both lists matches each body to its record
+    size_t j = 0;
+    for (size_t i = 0; i < body_count; i++) {
+        Body *body = scene_get_body(scene, i);
+        BodyHandle handle = body_get_handle(body);
+        while (j < loop->previous_handles.size
+                && VEC_AT(&loop->previous_handles, j) != handle) {
+            j++;
+        }
+        Vector offset = VEC_ZERO;
+        if (j < loop->previous_handles.size) {
+            Vector moved = vec_subtract(VEC_AT(&loop->previous_centroids, j),
+                body_get_centroid(body));
+            offset = vec_multiply(behind, moved);
+            j++;
+        }
+        VectorVec_push(&loop->offsets, offset);
+    }
+    return loop->offsets.data;
+}
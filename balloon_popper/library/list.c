@@ -1,43 +1,93 @@
 #include "list.h"
+#include <stdbool.h>
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
 #include <stdio.h>
 
+/*
+ * The first size_capacity items are stored inline, right after the header in
+ * the same block, so a list that never outgrows its initial size costs one
+ * allocation. Once it grows, list_items moves to a separate array.
+ */
 struct list {
     void **list_items;
     size_t size_capacity;
     size_t current_size;
     FreeFunc free;
+    // Where the list (and its items, if free is allocator_owned) come from
+    const Allocator *allocator;
+    // False if the header lives in memory passed to list_init_in()
+    bool owns_header;
+    void *inline_items[];
 };
 
 List *list_init(size_t initial_size, FreeFunc freer) {
-    List *list = malloc(sizeof(List));
-    assert(list);
-    if (initial_size > 0) {
-        list->list_items = malloc(initial_size * sizeof(void *));
-        assert(list->list_items);
-    }
+    return list_init_with_allocator(allocator_global(), initial_size, freer);
+}
+
+List *list_init_with_allocator(
+    const Allocator *allocator, size_t initial_size, FreeFunc freer
+) {
+    assert(allocator);
+    List *list = list_init_in(allocator_alloc(allocator, \
+        list_inline_size(initial_size)), allocator, initial_size, freer);
+    list->owns_header = true;
+    return list;
+}
 
-    list->size_capacity = initial_size;
+size_t list_inline_size(size_t inline_capacity) {
+    return sizeof(List) + inline_capacity * sizeof(void *);
+}
+
+List *list_init_in(
+    void *memory,
+    const Allocator *allocator,
+    size_t inline_capacity,
+    FreeFunc freer
+) {
+    assert(memory);
+    assert(allocator);
+    List *list = memory;
+    list->list_items = list->inline_items;
+    list->size_capacity = inline_capacity;
     list->current_size = 0;
     list->free = freer;
-
+    list->allocator = allocator;
+    list->owns_header = false;
     return list;
 }
 
-void list_free(List *list) {
-    assert(list);
+size_t list_arena_footprint(size_t initial_size) {
+    return arena_footprint(list_inline_size(initial_size));
+}
 
-    if (list->current_size > 0) {
-        for (size_t i = 0; i < list->current_size; i++) {
-            (list->free)(list->list_items[i]);
-        }
+const Allocator *list_get_allocator(List *list) {
+    assert(list);
+    return list->allocator;
+}
 
-        free(list->list_items);
+/** Releases an item that is no longer in the list */
+void list_free_item(List *list, void *item) {
+    if (list->free == allocator_owned) {
+        allocator_free(list->allocator, item);
+    } else if (list->free) {
+        (list->free)(item);
     }
+}
+
+void list_free(List *list) {
+    assert(list);
 
-    free(list);
+    for (size_t i = 0; i < list->current_size; i++) {
+        list_free_item(list, list->list_items[i]);
+    }
+    if (list->list_items != list->inline_items) {
+        allocator_free(list->allocator, list->list_items);
+    }
+    if (list->owns_header) {
+        allocator_free(list->allocator, list);
+    }
 }
 
 size_t list_size(List *list) {
@@ -62,14 +112,14 @@ void list_remove(List *list, size_t index) {
     }
 
     list->current_size--;
-    (list->free)(to_remove);
+    list_free_item(list, to_remove);
 }
 
 void list_set(List *list, size_t index, void *value) {
     assert(list);
     assert(index >=0 && index < list->current_size);
     // Free previously set item
-    list->free(list->list_items[index]);
+    list_free_item(list, list->list_items[index]);
     list->list_items[index] = value;
 }
 
@@ -78,19 +128,21 @@ void list_add(List* list, void* value) {
     size_t current_capacity = list->size_capacity;
     size_t current_size = list->current_size;
 
-    // If adding the first item, then simply malloc enough space for 1
-    if (current_capacity == 0) {
-            list->list_items = malloc(sizeof(void*));
-            assert(list->list_items);
-            list->size_capacity++;
-    }
     // If capacity is size, then we need to reallocate memory
-    else if (current_capacity == current_size) {
+    if (current_capacity == current_size) {
         // Double capacity each time we need more space
-            void **new = realloc(list->list_items, sizeof(void*) *
-                    2 * current_capacity);
-            list->list_items = new;
-            list->size_capacity *= 2;
+        size_t capacity = current_capacity ? 2 * current_capacity : 1;
+        if (list->list_items == list->inline_items) {
+            // Spill the inline items into their own array
+            list->list_items = allocator_alloc(list->allocator, \
+                capacity * sizeof(void *));
+            memcpy(list->list_items, list->inline_items, \
+                current_size * sizeof(void *));
+        } else {
+            list->list_items = allocator_realloc(list->allocator, \
+                list->list_items, capacity * sizeof(void *));
+        }
+        list->size_capacity = capacity;
     }
     list->list_items[current_size] = value;
     list->current_size++;
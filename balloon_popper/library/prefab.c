@@ -0,0 +1,79 @@
+#include "prefab.h"
+#include "polygon.h"
+#include <assert.h>
+#include <math.h>
+
+struct shapePrefab {
+    Vector *vertices;
+    Vector centroid;
+    size_t size;
+    size_t references;
+    const Allocator *allocator;
+};
+
+ShapePrefab *prefab_init(List *shape) {
+    assert(shape);
+    size_t size = list_size(shape);
+    assert(size > 0);
+    const Allocator *allocator = allocator_global();
+    ShapePrefab *prefab = allocator_alloc(allocator, sizeof(ShapePrefab));
+    prefab->vertices = allocator_alloc(allocator, size * sizeof(Vector));
+    prefab->allocator = allocator;
+    Vector centroid = polygon_centroid(shape);
+    for (size_t i = 0; i < size; i++) {
+        Vector *vertex = list_get(shape, i);
+        prefab->vertices[i] = vec_subtract(*vertex, centroid);
+    }
+    prefab->centroid = centroid;
+    prefab->size = size;
+    prefab->references = 1;
+    list_free(shape);
+    return prefab;
+}
+
+void prefab_retain(ShapePrefab *prefab) {
+    assert(prefab);
+    prefab->references++;
+}
+
+void prefab_release(ShapePrefab *prefab) {
+    assert(prefab);
+    assert(prefab->references > 0);
+    if (--prefab->references == 0) {
+        allocator_free(prefab->allocator, prefab->vertices);
+        allocator_free(prefab->allocator, prefab);
+    }
+}
+
+size_t prefab_size(ShapePrefab *prefab) {
+    assert(prefab);
+    return prefab->size;
+}
+
+Vector prefab_get_centroid(ShapePrefab *prefab) {
+    assert(prefab);
+    return prefab->centroid;
+}
+
+List *prefab_instantiate(
+    ShapePrefab *prefab, Transform transform, const Allocator *allocator
+) {
+    assert(prefab);
+    List *shape = allocator ? \
+        list_init_with_allocator(allocator, prefab->size, allocator_owned) : \
+        list_init(prefab->size, vector_free);
+    double cos_angle = cos(transform.angle);
+    double sin_angle = sin(transform.angle);
+    for (size_t i = 0; i < prefab->size; i++) {
+        Vector local = prefab->vertices[i];
+        Vector *vertex = allocator ? \
+            allocator_alloc(allocator, sizeof(Vector)) : \
+            create_vector_p(VEC_ZERO);
+        vertex->x = transform.position.x + \
+            local.x * cos_angle - local.y * sin_angle;
+        vertex->y = transform.position.y + \
+            local.x * sin_angle + local.y * cos_angle;
+        list_add(shape, vertex);
+    }
+    return shape;
+}
@@ -2,17 +2,168 @@
 #include "body.h"
 #include "list.h"
 #include "forces.h"
+#include "arena.h"
+#include "prefab.h"
+#include "thread_pool.h"
 #include "utils.h"
+#include "vec.h"
 #include <assert.h>
+#include <float.h>
+#include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #define NUMBER_STARTING_BODIES 5
+// The scene's arenas request memory from the heap this many bytes at a time
+#define SCENE_ARENA_CHUNK_SIZE (64 * 1024)
 
-// A scene is simply a list of bodies and force creators.
+#define HANDLE_INDEX_MASK ((1u << BODY_HANDLE_INDEX_BITS) - 1)
+#define HANDLE_GENERATION_MASK ((1u << (32 - BODY_HANDLE_INDEX_BITS)) - 1)
+#define NO_FREE_SLOT ((size_t) -1)
+
+// How many bodies each thread integrates at a time. Scenes with no more
+// bodies than this are integrated on the calling thread alone.
+#define PARALLEL_CHUNK_BODIES 1024
+
+#define DEFAULT_TOLERANCE 1e-6
+#define DOPRI_STAGES 7
+// How much INTEGRATOR_ADAPTIVE may shrink or grow its step after a substep
+#define MIN_STEP_FACTOR 0.2
+#define MAX_STEP_FACTOR 5.0
+#define STEP_SAFETY 0.9
+
+/*
+ * The Dormand-Prince 5(4) tableau. Stage j is evaluated at the start of the
+ * step plus h times the sum of DOPRI_A[j][l] times stage l's derivative.
+ * The last stage is evaluated at the fifth-order solution, so it is also the
+ * first stage of the next step. DOPRI_ERROR gives the difference between the
+ * fifth- and fourth-order solutions.
+ */
+const double DOPRI_A[DOPRI_STAGES][DOPRI_STAGES - 1] = {
+    {0},
+    {1.0 / 5},
+    {3.0 / 40, 9.0 / 40},
+    {44.0 / 45, -56.0 / 15, 32.0 / 9},
+    {19372.0 / 6561, -25360.0 / 2187, 64448.0 / 6561, -212.0 / 729},
+    {9017.0 / 3168, -355.0 / 33, 46732.0 / 5247, 49.0 / 176,
+        -5103.0 / 18656},
+    {35.0 / 384, 0, 500.0 / 1113, 125.0 / 192, -2187.0 / 6784, 11.0 / 84}
+};
+const double DOPRI_ERROR[DOPRI_STAGES] = {
+    71.0 / 57600, 0, -71.0 / 16695, 71.0 / 1920, -17253.0 / 339200,
+    22.0 / 525, -1.0 / 40
+};
+
+/**
+ * An entry in the scene's handle table.
+ * A slot is either occupied by a body or threaded into the free slot list.
+ */
+typedef struct bodySlot {
+    Body *body;
+    uint32_t generation;
+    // Whether the body itself lives in the scene's arenas rather than the heap
+    bool in_arena;
+    // Whether the body owns memory outside the arena (see scene_owns_heap())
+    bool owns_heap;
+    size_t next_free;
+} BodySlot;
+
+/**
+ * What scene_tick() keeps for each body it moves with an integrator other than
+ * INTEGRATOR_AVERAGE_VELOCITY (see scene_tick_integrator()).
+ */
+typedef struct integratorState {
+    Body *body;
+    double inv_mass;
+    // Position and velocity at the start of the tick, after impulses
+    Vector position;
+    Vector velocity;
+    // The force from force creators that only run once per tick
+    Vector fixed_force;
+    // The scene's gravity times the body's gravity scale
+    Vector gravity;
+    // The acceleration at the start of the tick, which the body records
+    Vector acceleration;
+    // The state the pure force creators are evaluated at next,
+    // and the acceleration they give there
+    Vector trial_position;
+    Vector trial_velocity;
+    Vector trial_acceleration;
+    // Weighted sums of the velocities and accelerations of RK4's stages
+    Vector position_change;
+    Vector velocity_change;
+    // The velocities and accelerations of INTEGRATOR_ADAPTIVE's stages
+    Vector stage_velocity[DOPRI_STAGES];
+    Vector stage_acceleration[DOPRI_STAGES];
+} IntegratorState;
+
+DEFINE_VEC(BodySlot)
+DEFINE_VEC(IntegratorState)
+DEFINE_VEC(Vector)
+DEFINE_VEC(ForceBuffer)
+DEFINE_VEC_NAMED(BodyPtrVec, Body *)
+DEFINE_VEC_NAMED(ForceInfoPtrVec, ForceInfo *)
+DEFINE_VEC_NAMED(PrefabPtrVec, ShapePrefab *)
+
+/**
+ * A scene is a list of bodies and force creators.
+ * Everything it allocates comes from its arenas: body_arena holds only the hot
+ * records of bodies, so they are packed together, and arena holds the rest.
+ * It also owns a table of slots that maps handles to bodies.
+ * heap_owners counts bodies and forces that own memory outside the arenas,
+ * which scene_reset() has to free one by one.
+ * If use_arrays is set, its bodies' dynamic state lives in arrays.
+ * The scene itself, its slot table, arrays and arena chunks come from
+ * allocator.
+ */
 struct scene {
-    List* bodies;
-    List* forceInfos;
+    BodyPtrVec bodies;
+    ForceInfoPtrVec forces;
+    // Prefabs bodies were spawned from, each retained once by the scene
+    PrefabPtrVec prefabs;
+    Arena *arena;
+    Arena *body_arena;
+    size_t heap_owners;
+    BodySlotVec slots;
+    size_t first_free_slot;
+    // Every generation handed out so far is at most this
+    uint32_t max_generation;
+    BodyArrays arrays;
+    bool use_arrays;
+    // Motion flags given to bodies as they are added
+    MotionFlags default_motion;
+    Integrator integrator;
+    // The acceleration every body moved by forces falls with
+    Vector gravity;
+    // The dt of the tick in progress, or of the last one
+    double dt;
+    double tolerance;
+    // The substep INTEGRATOR_ADAPTIVE will try next, or 0 to try a whole tick
+    double adaptive_step;
+    size_t steps_taken;
+    size_t steps_rejected;
+    // Scratch space for the integrator, kept between ticks to reuse its memory
+    IntegratorStateVec integration;
+    // Bodies with MOTION_SUBSTEP left out of this tick's integration pass,
+    // and the force creators re-run between one body's substeps
+    BodyPtrVec substepped;
+    ForceInfoPtrVec substep_forces;
+    // Bodies slower than sleep_speed for sleep_ticks ticks in a row are put
+    // to sleep, unless sleep_ticks is 0
+    double sleep_speed;
+    size_t sleep_ticks;
+    // The workers that integrate bodies, or NULL to integrate them serially
+    ThreadPool *pool;
+    // One buffer per thread for running pure force creators in parallel,
+    // each pointing into buffer_storage
+    ForceBufferVec force_buffers;
+    VectorVec buffer_storage;
+    // The newest batch of each kind (see scene_get_force_batch())
+    ForceInfoPtrVec batches;
+    // Batches of constraints, solved in order once the bodies have moved
+    ForceInfoPtrVec constraints;
+    const Allocator *allocator;
 };
 
 struct forceInfo {
@@ -20,13 +171,56 @@ struct forceInfo {
     void *aux;
     FreeFunc aux_freer;
     List* bodies;
+    bool owns_heap;
+    // Whether it may be re-run at trial states (see Integrator)
+    bool pure;
+    // For batches, what to call instead of freeing it when a body is removed
+    ForcePruner pruner;
+    // Whether it runs its own work on the scene's threads
+    // (see scene_add_parallel_force_batch())
+    bool parallel;
 };
 
 Scene *scene_init(void) {
-    Scene* scene = malloc(sizeof(Scene));
-    assert(scene);
-    scene->bodies = list_init(NUMBER_STARTING_BODIES, body_free);
-    scene->forceInfos = list_init(0, forceInfo_free);
+    return scene_init_with_allocator(allocator_global());
+}
+
+Scene *scene_init_with_allocator(const Allocator *allocator) {
+    assert(allocator);
+    Scene* scene = allocator_alloc(allocator, sizeof(Scene));
+    scene->allocator = allocator;
+    scene->arena = arena_init_with_allocator(allocator, SCENE_ARENA_CHUNK_SIZE);
+    scene->body_arena = arena_init_with_allocator(allocator, \
+        SCENE_ARENA_CHUNK_SIZE);
+    scene->heap_owners = 0;
+    BodyPtrVec_init(&scene->bodies, allocator);
+    BodyPtrVec_reserve(&scene->bodies, NUMBER_STARTING_BODIES);
+    ForceInfoPtrVec_init(&scene->forces, allocator);
+    PrefabPtrVec_init(&scene->prefabs, allocator);
+    BodySlotVec_init(&scene->slots, allocator);
+    BodySlotVec_reserve(&scene->slots, NUMBER_STARTING_BODIES);
+    scene->first_free_slot = NO_FREE_SLOT;
+    scene->max_generation = 0;
+    body_arrays_init(&scene->arrays, allocator);
+    scene->use_arrays = false;
+    scene->default_motion = MOTION_FORCES;
+    scene->integrator = INTEGRATOR_AVERAGE_VELOCITY;
+    scene->gravity = VEC_ZERO;
+    scene->dt = 0;
+    scene->tolerance = DEFAULT_TOLERANCE;
+    scene->adaptive_step = 0;
+    scene->steps_taken = 0;
+    scene->steps_rejected = 0;
+    IntegratorStateVec_init(&scene->integration, allocator);
+    BodyPtrVec_init(&scene->substepped, allocator);
+    ForceInfoPtrVec_init(&scene->substep_forces, allocator);
+    scene->sleep_speed = 0;
+    scene->sleep_ticks = 0;
+    scene->pool = NULL;
+    ForceBufferVec_init(&scene->force_buffers, allocator);
+    VectorVec_init(&scene->buffer_storage, allocator);
+    ForceInfoPtrVec_init(&scene->batches, allocator);
+    ForceInfoPtrVec_init(&scene->constraints, allocator);
     return scene;
 }
 
@@ -36,102 +230,1038 @@ void forceInfo_free(void *force) {
     if (f->aux_freer) {
         f->aux_freer(f->aux);
     }
-    free(f);
+    arena_release(f);
+}
+
+Arena *scene_get_arena(Scene *scene) {
+    assert(scene);
+    return scene->arena;
+}
+
+/**
+ * Takes a slot for a body, reusing a freed slot if there is one.
+ * Returns the handle that now refers to the body.
+ */
+BodyHandle scene_claim_slot(
+    Scene *scene, Body *body, bool in_arena, bool owns_heap
+) {
+    size_t index = scene->first_free_slot;
+    if (index != NO_FREE_SLOT) {
+        scene->first_free_slot = VEC_AT(&scene->slots, index).next_free;
+    } else {
+        index = scene->slots.size;
+        assert(index <= HANDLE_INDEX_MASK);
+        // Continue past generations used before a reset, so old handles stay stale
+        BodySlotVec_push(&scene->slots, \
+            (BodySlot) {.generation = scene->max_generation});
+    }
+    BodySlot *slot = &VEC_AT(&scene->slots, index);
+    // Generation 0 is skipped so no live handle equals BODY_HANDLE_NULL
+    slot->generation = (slot->generation + 1) & HANDLE_GENERATION_MASK;
+    if (slot->generation == 0) {
+        slot->generation = 1;
+    }
+    if (slot->generation > scene->max_generation) {
+        scene->max_generation = slot->generation;
+    }
+    slot->body = body;
+    slot->in_arena = in_arena;
+    slot->owns_heap = owns_heap;
+    if (owns_heap) {
+        scene->heap_owners++;
+    }
+    BodyHandle handle = (slot->generation << BODY_HANDLE_INDEX_BITS) | index;
+    body_set_handle(body, handle);
+    return handle;
+}
+
+/**
+ * Frees a body owned by the scene and puts its slot on the free list,
+ * which invalidates every outstanding handle to it.
+ */
+void scene_release_body(Scene *scene, Body *body) {
+    size_t index = body_get_handle(body) & HANDLE_INDEX_MASK;
+    BodySlot *slot = &VEC_AT(&scene->slots, index);
+    assert(slot->body == body);
+    if (slot->owns_heap) {
+        scene->heap_owners--;
+    }
+    if (slot->in_arena) {
+        void *cold = body_get_cold_memory(body);
+        body_destroy(body);
+        arena_release(cold);
+        arena_release(body);
+    } else {
+        body_free(body);
+    }
+    slot->body = NULL;
+    slot->next_free = scene->first_free_slot;
+    scene->first_free_slot = index;
+}
+
+void scene_reset(Scene *scene) {
+    assert(scene);
+    // Only bodies and forces holding heap memory need to be visited
+    if (scene->heap_owners > 0) {
+        for (size_t i = 0; i < scene_bodies(scene); i++) {
+            Body *body = scene_get_body(scene, i);
+            BodySlot *slot = &VEC_AT(&scene->slots, \
+                body_get_handle(body) & HANDLE_INDEX_MASK);
+            if (!slot->owns_heap) {
+                continue;
+            }
+            if (slot->in_arena) {
+                body_destroy(body);
+            } else {
+                body_free(body);
+            }
+        }
+        for (size_t i = 0; i < scene_forces(scene); i++) {
+            ForceInfo *force = scene_get_forces(scene, i);
+            if (force->owns_heap) {
+                force->aux_freer(force->aux);
+            }
+        }
+        VEC_FOREACH(ForceInfo *, constraints, &scene->constraints) {
+            if ((*constraints)->owns_heap) {
+                (*constraints)->aux_freer((*constraints)->aux);
+            }
+        }
+        scene->heap_owners = 0;
+    }
+    VEC_FOREACH(ShapePrefab *, prefab, &scene->prefabs) {
+        prefab_release(*prefab);
+    }
+    PrefabPtrVec_clear(&scene->prefabs);
+    BodyPtrVec_clear(&scene->bodies);
+    ForceInfoPtrVec_clear(&scene->forces);
+    ForceInfoPtrVec_clear(&scene->batches);
+    ForceInfoPtrVec_clear(&scene->constraints);
+    BodySlotVec_clear(&scene->slots);
+    scene->arrays.size = 0;
+    scene->first_free_slot = NO_FREE_SLOT;
+    arena_reset(scene->arena);
+    arena_reset(scene->body_arena);
 }
 
 void scene_free(Scene *scene) {
     assert(scene);
-    list_free(scene->bodies);
-    list_free(scene->forceInfos);
-    free(scene);
+    scene_reset(scene);
+    arena_free(scene->arena);
+    arena_free(scene->body_arena);
+    body_arrays_free(&scene->arrays);
+    BodyPtrVec_free(&scene->bodies);
+    ForceInfoPtrVec_free(&scene->forces);
+    ForceInfoPtrVec_free(&scene->constraints);
+    PrefabPtrVec_free(&scene->prefabs);
+    BodySlotVec_free(&scene->slots);
+    IntegratorStateVec_free(&scene->integration);
+    BodyPtrVec_free(&scene->substepped);
+    ForceInfoPtrVec_free(&scene->substep_forces);
+    if (scene->pool) {
+        thread_pool_free(scene->pool);
+    }
+    ForceBufferVec_free(&scene->force_buffers);
+    VectorVec_free(&scene->buffer_storage);
+    ForceInfoPtrVec_free(&scene->batches);
+    allocator_free(scene->allocator, scene);
 }
 
 size_t scene_bodies(Scene *scene) {
     assert(scene);
-    return list_size(scene->bodies);
+    return scene->bodies.size;
 }
 
 size_t scene_forces(Scene *scene) {
     assert(scene);
-    return list_size(scene->forceInfos);
+    return scene->forces.size;
 }
 
 Body *scene_get_body(Scene *scene, size_t index) {
     assert(scene);
-    assert(0 <= index && index < scene_bodies(scene));
-    return list_get(scene->bodies, index);
+    return BodyPtrVec_get(&scene->bodies, index);
 }
 
 ForceInfo* scene_get_forces(Scene* scene, size_t index) {
     assert(scene);
-    assert(0 <= index && index < scene_forces(scene));
-    return list_get(scene->forceInfos, index);
+    return ForceInfoPtrVec_get(&scene->forces, index);
+}
+
+Body *scene_get_body_by_handle(Scene *scene, BodyHandle handle) {
+    assert(scene);
+    size_t index = handle & HANDLE_INDEX_MASK;
+    uint32_t generation = handle >> BODY_HANDLE_INDEX_BITS;
+    if (index >= scene->slots.size) {
+        return NULL;
+    }
+    BodySlot *slot = &VEC_AT(&scene->slots, index);
+    if (slot->generation != generation || !slot->body) {
+        return NULL;
+    }
+    return slot->body;
 }
 
-void scene_add_body(Scene *scene, Body *body) {
+BodyHandle scene_add_body(Scene *scene, Body *body) {
     assert(scene);
     assert(body);
-    list_add(scene->bodies, body);
+    assert(body_get_handle(body) == BODY_HANDLE_NULL);
+    BodyPtrVec_push(&scene->bodies, body);
+    body_set_motion(body, scene->default_motion);
+    if (scene->use_arrays) {
+        body_attach_arrays(body, &scene->arrays);
+    }
+    return scene_claim_slot(scene, body, false, true);
+}
+
+BodyHandle scene_spawn_body(
+    Scene *scene,
+    List *shape,
+    double mass,
+    RGBColor color,
+    void *info,
+    FreeFunc info_freer
+) {
+    assert(scene);
+    Body *body = body_init_at(arena_alloc(scene->body_arena, body_size()), \
+        arena_alloc(scene->arena, body_cold_size()), shape, mass, color, \
+        info, info_freer);
+    BodyPtrVec_push(&scene->bodies, body);
+    body_set_motion(body, scene->default_motion);
+    if (scene->use_arrays) {
+        body_attach_arrays(body, &scene->arrays);
+    }
+    // A shape in the arena is assumed to have its vertices there too
+    bool owns_heap = list_get_allocator(shape) != \
+        arena_allocator(scene->arena) || \
+        (info_freer && !arena_contains(scene->arena, info));
+    return scene_claim_slot(scene, body, true, owns_heap);
+}
+
+/** Keeps a prefab alive for as long as the scene may have bodies from it */
+void scene_track_prefab(Scene *scene, ShapePrefab *prefab) {
+    VEC_FOREACH(ShapePrefab *, tracked, &scene->prefabs) {
+        if (*tracked == prefab) {
+            return;
+        }
+    }
+    prefab_retain(prefab);
+    PrefabPtrVec_push(&scene->prefabs, prefab);
+}
+
+void scene_spawn_many(
+    Scene *scene,
+    ShapePrefab *prefab,
+    const Transform *transforms,
+    size_t count,
+    double mass,
+    RGBColor color,
+    BodyHandle *handles
+) {
+    assert(scene);
+    assert(prefab);
+    assert(transforms || count == 0);
+    scene_track_prefab(scene, prefab);
+
+    // Reserve the whole batch up front, so it needs at most one chunk each
+    size_t vertices = prefab_size(prefab);
+    size_t per_body = arena_footprint(body_cold_size()) + \
+        list_arena_footprint(vertices) + \
+        vertices * arena_footprint(sizeof(Vector));
+    arena_reserve(scene->arena, count * per_body);
+    arena_reserve(scene->body_arena, count * arena_footprint(body_size()));
+    BodyPtrVec_reserve(&scene->bodies, scene_bodies(scene) + count);
+    BodySlotVec_reserve(&scene->slots, scene->slots.size + count);
+
+    for (size_t i = 0; i < count; i++) {
+        List *shape = prefab_instantiate(prefab, transforms[i], \
+            arena_allocator(scene->arena));
+        BodyHandle handle = scene_spawn_body(scene, shape, mass, color, \
+            NULL, NULL);
+        body_set_angle(scene_get_body_by_handle(scene, handle), \
+            transforms[i].angle);
+        if (handles) {
+            handles[i] = handle;
+        }
+    }
 }
 
 void scene_remove_body(Scene *scene, size_t index) {
     assert(scene);
-    list_remove(scene->bodies, index);
+    Body *body = BodyPtrVec_remove(&scene->bodies, index);
+    scene_release_body(scene, body);
 }
 
-void scene_tick(Scene *scene, double dt) {
+void scene_set_default_motion(Scene *scene, MotionFlags motion) {
     assert(scene);
+    scene->default_motion = motion;
+}
 
-    // Step 1: Iterate through all forces and apply
-    size_t i;
-    size_t k;
-    for (i = 0; i < scene_forces(scene); i++) {
-        ForceInfo* force = scene_get_forces(scene, i);
-        force->forcer(force->aux);
+void scene_set_integrator(Scene *scene, Integrator integrator) {
+    assert(scene);
+    scene->integrator = integrator;
+}
+
+Integrator scene_get_integrator(Scene *scene) {
+    assert(scene);
+    return scene->integrator;
+}
+
+void scene_set_tolerance(Scene *scene, double tolerance) {
+    assert(scene);
+    assert(tolerance > 0);
+    scene->tolerance = tolerance;
+}
+
+size_t scene_steps_taken(Scene *scene) {
+    assert(scene);
+    return scene->steps_taken;
+}
+
+size_t scene_steps_rejected(Scene *scene) {
+    assert(scene);
+    return scene->steps_rejected;
+}
+
+void scene_set_sleeping(Scene *scene, double max_speed, size_t ticks) {
+    assert(scene);
+    assert(max_speed >= 0);
+    assert(ticks <= BODY_MAX_REST_TICKS);
+    scene->sleep_speed = max_speed;
+    scene->sleep_ticks = ticks;
+    // Bodies only restart their count of ticks at rest as they wake
+    VEC_FOREACH(Body *, body, &scene->bodies) {
+        body_wake(*body);
     }
-    i = 0;
-    k = scene_forces(scene);
+}
 
-    bool to_remove;
-    // Step 2: Remove forces that have had one of its bodies removed
-    while (i < k) {
-        to_remove = false;
-        ForceInfo* force = scene_get_forces(scene, i);
-        List *bodies = force->bodies;
-        for (size_t j = 0; j < list_size(bodies); j++) {
-            Body* b = list_get(bodies, j);
-            if (body_is_removed(b)) {
-                list_remove(scene->forceInfos, i);
-                k = scene_forces(scene);
-                to_remove = true;
-                break;
+void scene_set_gravity(Scene *scene, Vector gravity) {
+    assert(scene);
+    if (gravity.x == scene->gravity.x && gravity.y == scene->gravity.y) {
+        return;
+    }
+    scene->gravity = gravity;
+    // A body resting on the ground may be left unsupported by the change
+    VEC_FOREACH(Body *, body, &scene->bodies) {
+        body_wake(*body);
+    }
+}
+
+Vector scene_get_gravity(Scene *scene) {
+    assert(scene);
+    return scene->gravity;
+}
+
+double scene_get_dt(Scene *scene) {
+    assert(scene);
+    return scene->dt;
+}
+
+size_t scene_sleeping_bodies(Scene *scene) {
+    assert(scene);
+    size_t sleeping = 0;
+    VEC_FOREACH(Body *, body, &scene->bodies) {
+        sleeping += body_is_sleeping(*body);
+    }
+    return sleeping;
+}
+
+size_t scene_awake_bodies(Scene *scene) {
+    assert(scene);
+    size_t awake = 0;
+    VEC_FOREACH(Body *, body, &scene->bodies) {
+        awake += !body_is_sleeping(*body) \
+            && body_get_type(*body) != BODY_STATIC;
+    }
+    return awake;
+}
+
+void scene_set_threads(Scene *scene, size_t threads) {
+    assert(scene);
+    assert(threads > 0);
+    if (threads == scene_get_threads(scene)) {
+        return;
+    }
+    if (scene->pool) {
+        thread_pool_free(scene->pool);
+    }
+    scene->pool = threads > 1 ? thread_pool_init(threads) : NULL;
+}
+
+size_t scene_get_threads(Scene *scene) {
+    assert(scene);
+    return scene->pool ? thread_pool_threads(scene->pool) : 1;
+}
+
+ThreadPool *scene_get_thread_pool(Scene *scene) {
+    assert(scene);
+    return scene->pool;
+}
+
+void scene_set_body_arrays(Scene *scene, bool enabled) {
+    assert(scene);
+    if (scene->use_arrays == enabled) {
+        return;
+    }
+    scene->use_arrays = enabled;
+    for (size_t i = 0; i < scene_bodies(scene); i++) {
+        Body *body = scene_get_body(scene, i);
+        if (enabled) {
+            body_attach_arrays(body, &scene->arrays);
+        } else {
+            body_detach_arrays(body);
+        }
+    }
+}
+
+/** Whether any of the bodies a force creator acts on has been removed */
+bool force_is_stale(ForceInfo *force) {
+    List *bodies = force->bodies;
+    for (size_t j = 0; j < list_size(bodies); j++) {
+        if (body_is_removed(list_get(bodies, j))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Whether a force creator acts on a body */
+bool force_acts_on(ForceInfo *force, Body *body) {
+    List *bodies = force->bodies;
+    if (!bodies) {
+        return false;
+    }
+    for (size_t j = 0; j < list_size(bodies); j++) {
+        if (list_get(bodies, j) == body) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Estimates how far a body will move in a tick, from the larger of its
+ * speeds before and after the forces, impulses and acceleration on it.
+ */
+double tick_distance(Body *body, Vector gravity, double dt) {
+    BodyType type = body_get_type(body);
+    if (type == BODY_STATIC) {
+        return 0;
+    }
+    Vector start = body_get_velocity(body);
+    Vector end = start;
+    MotionFlags motion = type == BODY_KINEMATIC ? MOTION_ACCELERATION \
+        : body_get_motion(body);
+    double mass = body_get_mass(body);
+    if ((motion & MOTION_FORCES) && mass != INFINITY) {
+        Vector impulse = vec_add(body_get_impulse(body), \
+            vec_multiply(dt, body_get_force(body)));
+        end = vec_add(end, vec_multiply(1 / mass, impulse));
+        end = vec_add(end, \
+            vec_multiply(dt * body_get_gravity_scale(body), gravity));
+    }
+    if (motion & MOTION_ACCELERATION) {
+        end = vec_add(end, vec_multiply(dt, body_get_acceleration(body)));
+    }
+    return dt * fmax(vec_magnitude(start), vec_magnitude(end));
+}
+
+/**
+ * Ticks one body with MOTION_SUBSTEP in as many equal substeps as keep each
+ * within its max displacement. The forces on it are held fixed over the tick,
+ * and the force creators on it that are not pure, such as collision checks,
+ * run again between substeps.
+ */
+void scene_substep_body(Scene *scene, Body *body, double dt) {
+    double distance = tick_distance(body, scene->gravity, dt);
+    size_t substeps = (size_t) ceil(distance / body_get_max_displacement(body));
+    if (substeps <= 1) {
+        body_integrate_with_gravity(body, scene->gravity, dt);
+        return;
+    }
+
+    ForceInfoPtrVec_clear(&scene->substep_forces);
+    VEC_FOREACH(ForceInfo *, force, &scene->forces) {
+        if (!(*force)->pure && force_acts_on(*force, body)) {
+            ForceInfoPtrVec_push(&scene->substep_forces, *force);
+        }
+    }
+    double h = dt / substeps;
+    Vector force = body_get_force(body);
+    bool forced = (body_get_motion(body) & MOTION_FORCES)
+        && body_get_type(body) == BODY_DYNAMIC;
+    double inv_mass = forced ? 1 / body_get_mass(body) : 0;
+    body_integrate_with_gravity(body, scene->gravity, h);
+    for (size_t i = 1; i < substeps && !body_is_removed(body); i++) {
+        VEC_FOREACH(ForceInfo *, check, &scene->substep_forces) {
+            if (!force_is_stale(*check)) {
+                (*check)->forcer((*check)->aux);
             }
         }
-        if (!to_remove) {
-            i++;
+        // A collision's impulse takes effect before the next substep,
+        // so the body leaves the other body instead of bouncing in place
+        body_set_velocity(body, vec_add(body_get_velocity(body), \
+            vec_multiply(inv_mass, body_get_impulse(body))));
+        body_set_impulse(body, VEC_ZERO);
+        body_add_force(body, force);
+        body_integrate_with_gravity(body, scene->gravity, h);
+    }
+}
+
+/**
+ * Ticks the bodies scene_sweep_bodies() or scene_tick_arrays() set aside.
+ * The others have already moved, so fast bodies are checked against where
+ * slow ones end up.
+ */
+void scene_substep_bodies(Scene *scene, double dt) {
+    VEC_FOREACH(Body *, body, &scene->substepped) {
+        scene_substep_body(scene, *body, dt);
+    }
+    BodyPtrVec_clear(&scene->substepped);
+}
+
+/**
+ * Frees the bodies marked for removal, ticking the others if tick is set.
+ * The survivors are compacted in a single pass, keeping their order.
+ * Bodies with MOTION_SUBSTEP are set aside for scene_substep_bodies().
+ */
+void scene_sweep_bodies(Scene *scene, bool tick, double dt) {
+    size_t kept = 0;
+    for (size_t i = 0; i < scene_bodies(scene); i++) {
+        Body *body = VEC_AT(&scene->bodies, i);
+        if (body_is_removed(body)) {
+            scene_release_body(scene, body);
+            continue;
+        }
+        if (tick) {
+            if (body_get_motion(body) & MOTION_SUBSTEP) {
+                BodyPtrVec_push(&scene->substepped, body);
+            } else {
+                body_integrate_with_gravity(body, scene->gravity, dt);
+            }
         }
+        VEC_AT(&scene->bodies, kept++) = body;
     }
-    // Step 3: Removes all bodies that are marked to be removed
-    i = 0;
-    k = scene_bodies(scene);
-    while (i < k) {
-        Body *b = scene_get_body(scene, i);
-        if (body_is_removed(b)) {
-            // Vector center = body_get_centroid(scene_get_body(scene, i));
-            scene_remove_body(scene, i);
-            // List* explosion_points = get_star_points(8, 15, center);
-            // Role *type = malloc(sizeof(Role));
-            // assert(type);
-            // *type = PLAYER;
-            // Body* explosion = body_init_with_info(explosion_points, 1, (RGBColor) {1, 1, 1}, type, free);
-            // scene_add_body(scene, explosion);
-            // scene_remove_body(scene, i);
-        } else {
-            body_tick(b, dt);
-            i++;
+    scene->bodies.size = kept;
+}
+
+/** What the chunks of a parallel integration pass need */
+typedef struct integrateJob {
+    Scene *scene;
+    double dt;
+} IntegrateJob;
+
+/**
+ * Integrates the scene's bodies at indices [start, end) with
+ * body_integrate_with_gravity(),
+ * leaving those with MOTION_SUBSTEP for scene_substep_bodies().
+ * Each body's update only touches that body, so chunks can run in parallel
+ * and give the same bits as the serial loop in scene_sweep_bodies().
+ */
+void scene_integrate_chunk(void *aux, size_t start, size_t end, size_t thread) {
+    IntegrateJob *job = aux;
+    for (size_t i = start; i < end; i++) {
+        Body *body = VEC_AT(&job->scene->bodies, i);
+        if (!(body_get_motion(body) & MOTION_SUBSTEP)) {
+            body_integrate_with_gravity(body, job->scene->gravity, job->dt);
+        }
+    }
+}
+
+/** Like scene_integrate_chunk(), but for the bodies at [start, end) in arrays */
+void scene_tick_arrays_chunk(
+    void *aux, size_t start, size_t end, size_t thread
+) {
+    IntegrateJob *job = aux;
+    BodyArrays *arrays = &job->scene->arrays;
+    body_arrays_tick_range(arrays, start, end, job->scene->gravity, job->dt);
+    for (size_t i = start; i < end; i++) {
+        Body *body = arrays->bodies[i];
+        if (!(body_get_motion(body) & MOTION_SUBSTEP)) {
+            body_finish_tick(body, job->scene->gravity, job->dt);
+        }
+    }
+}
+
+/**
+ * Sets aside the bodies with MOTION_SUBSTEP for scene_substep_bodies(),
+ * after a parallel pass has integrated the others.
+ */
+void scene_collect_substepped(Scene *scene) {
+    VEC_FOREACH(Body *, body, &scene->bodies) {
+        if (body_get_motion(*body) & MOTION_SUBSTEP) {
+            BodyPtrVec_push(&scene->substepped, *body);
+        }
+    }
+}
+
+/**
+ * Step 3 of scene_tick() for scenes using body arrays.
+ * Removed bodies are dropped first so the integration loop only sees live ones.
+ */
+void scene_tick_arrays(Scene *scene, double dt) {
+    scene_sweep_bodies(scene, false, dt);
+    if (scene->pool) {
+        IntegrateJob job = {.scene = scene, .dt = dt};
+        thread_pool_for(scene->pool, scene->arrays.size, \
+            PARALLEL_CHUNK_BODIES, scene_tick_arrays_chunk, &job);
+        scene_collect_substepped(scene);
+    } else {
+        body_arrays_tick(&scene->arrays, scene->gravity, dt);
+        VEC_FOREACH(Body *, body, &scene->bodies) {
+            if (body_get_motion(*body) & MOTION_SUBSTEP) {
+                BodyPtrVec_push(&scene->substepped, *body);
+            } else {
+                body_finish_tick(*body, scene->gravity, dt);
+            }
+        }
+    }
+    scene_substep_bodies(scene, dt);
+}
+
+/**
+ * Runs the scene's force creators in order, either only the pure ones
+ * or only the others.
+ * (By index, since a collision handler may add forces.)
+ */
+void scene_run_forces(Scene *scene, bool pure) {
+    for (size_t i = 0; i < scene_forces(scene); i++) {
+        ForceInfo *force = VEC_AT(&scene->forces, i);
+        if (force->pure == pure) {
+            force->forcer(force->aux);
+        }
+    }
+}
+
+/**
+ * Runs the pure force creators in one of the equal parts the scene's force
+ * list is split into, one per thread, adding their forces to that part's
+ * buffer. Which creators go in which part depends only on the thread count,
+ * so the sums come out the same every time.
+ */
+void scene_force_partition(void *aux, size_t start, size_t end, size_t thread) {
+    Scene *scene = aux;
+    size_t parts = scene->force_buffers.size;
+    size_t count = scene_forces(scene);
+    for (size_t k = start; k < end; k++) {
+        ForceBuffer *buffer = &VEC_AT(&scene->force_buffers, k);
+        memset(buffer->forces, 0, buffer->size * sizeof(Vector));
+        memset(buffer->impulses, 0, buffer->size * sizeof(Vector));
+        body_redirect_forces(buffer);
+        for (size_t i = count * k / parts; i < count * (k + 1) / parts; i++) {
+            ForceInfo *force = VEC_AT(&scene->forces, i);
+            if (force->pure && !force->parallel) {
+                force->forcer(force->aux);
+            }
+        }
+        body_redirect_forces(NULL);
+    }
+}
+
+/**
+ * Adds the force buffers' entries for the scene's bodies at [start, end)
+ * to those bodies, summing the buffers in order.
+ */
+void scene_reduce_forces(void *aux, size_t start, size_t end, size_t thread) {
+    Scene *scene = aux;
+    for (size_t i = start; i < end; i++) {
+        Body *body = VEC_AT(&scene->bodies, i);
+        size_t slot = body_get_handle(body) & HANDLE_INDEX_MASK;
+        Vector force = VEC_ZERO;
+        Vector impulse = VEC_ZERO;
+        VEC_FOREACH(ForceBuffer, buffer, &scene->force_buffers) {
+            force = vec_add(force, buffer->forces[slot]);
+            impulse = vec_add(impulse, buffer->impulses[slot]);
+        }
+        body_add_force(body, force);
+        // Only a real impulse should wake a sleeping body
+        if (impulse.x != 0 || impulse.y != 0) {
+            body_add_impulse(body, impulse);
+        }
+    }
+}
+
+/**
+ * Step 1 of scene_tick() for the pure force creators of a scene with
+ * a thread pool: runs them on the pool's threads, each into its own buffer,
+ * then sums the buffers into the bodies.
+ */
+void scene_run_pure_forces_parallel(Scene *scene) {
+    size_t parts = thread_pool_threads(scene->pool);
+    size_t slots = scene->slots.size;
+    VectorVec_clear(&scene->buffer_storage);
+    VectorVec_reserve(&scene->buffer_storage, 2 * parts * slots);
+    scene->buffer_storage.size = 2 * parts * slots;
+    ForceBufferVec_clear(&scene->force_buffers);
+    for (size_t k = 0; k < parts; k++) {
+        Vector *storage = scene->buffer_storage.data + 2 * k * slots;
+        ForceBuffer buffer = {.forces = storage, .impulses = storage + slots, \
+            .size = slots};
+        ForceBufferVec_push(&scene->force_buffers, buffer);
+    }
+    // Creators that spread their own work over the threads run first,
+    // adding their forces to the bodies directly
+    VEC_FOREACH(ForceInfo *, force, &scene->forces) {
+        if ((*force)->parallel) {
+            (*force)->forcer((*force)->aux);
+        }
+    }
+    thread_pool_for(scene->pool, parts, 1, scene_force_partition, scene);
+    thread_pool_for(scene->pool, scene_bodies(scene), PARALLEL_CHUNK_BODIES, \
+        scene_reduce_forces, scene);
+}
+
+/**
+ * Frees the force creators that have had one of their bodies removed,
+ * and lets batches forget their removed bodies
+ */
+void scene_remove_stale_forces(Scene *scene) {
+    size_t kept = 0;
+    for (size_t i = 0; i < scene_forces(scene); i++) {
+        ForceInfo *force = VEC_AT(&scene->forces, i);
+        if (force->pruner) {
+            force->pruner(force->aux);
+        } else if (force_is_stale(force)) {
+            if (force->owns_heap) {
+                scene->heap_owners--;
+            }
+            forceInfo_free(force);
+            continue;
+        }
+        VEC_AT(&scene->forces, kept++) = force;
+    }
+    scene->forces.size = kept;
+    VEC_FOREACH(ForceInfo *, constraints, &scene->constraints) {
+        (*constraints)->pruner((*constraints)->aux);
+    }
+}
+
+/**
+ * Moves every integrated body to its trial state, re-runs the pure force
+ * creators there, and records the resulting accelerations.
+ */
+void scene_evaluate_stage(Scene *scene) {
+    VEC_FOREACH(IntegratorState, state, &scene->integration) {
+        body_set_centroid(state->body, state->trial_position);
+        body_set_velocity(state->body, state->trial_velocity);
+        body_set_force(state->body, VEC_ZERO);
+    }
+    scene_run_forces(scene, true);
+    VEC_FOREACH(IntegratorState, state, &scene->integration) {
+        Vector force = vec_add(state->fixed_force, body_get_force(state->body));
+        state->trial_acceleration = vec_add(state->gravity, \
+            vec_multiply(state->inv_mass, force));
+    }
+}
+
+/**
+ * Sets every integrated body's trial state to its state at the start of the
+ * tick advanced by h with the velocity and acceleration of the last stage.
+ */
+void scene_set_trial_states(Scene *scene, double h) {
+    VEC_FOREACH(IntegratorState, state, &scene->integration) {
+        state->trial_position = vec_add(state->position, \
+            vec_multiply(h, state->trial_velocity));
+        state->trial_velocity = vec_add(state->velocity, \
+            vec_multiply(h, state->trial_acceleration));
+    }
+}
+
+/** Adds the last RK4 stage's derivatives to the weighted sums */
+void scene_sum_stage(Scene *scene, double weight) {
+    VEC_FOREACH(IntegratorState, state, &scene->integration) {
+        state->position_change = vec_add(state->position_change, \
+            vec_multiply(weight, state->trial_velocity));
+        state->velocity_change = vec_add(state->velocity_change, \
+            vec_multiply(weight, state->trial_acceleration));
+    }
+}
+
+/**
+ * Evaluates stages 1 and on of a Dormand-Prince step of size h from each
+ * integrated body's position and velocity, whose first stage is known.
+ * Returns the largest error estimate relative to the scene's tolerance,
+ * leaving the fifth-order solution as each body's trial state.
+ */
+double scene_dopri_step(Scene *scene, double h) {
+    for (size_t j = 1; j < DOPRI_STAGES; j++) {
+        VEC_FOREACH(IntegratorState, state, &scene->integration) {
+            Vector position = state->position, velocity = state->velocity;
+            for (size_t l = 0; l < j; l++) {
+                double weight = h * DOPRI_A[j][l];
+                position = vec_add(position, \
+                    vec_multiply(weight, state->stage_velocity[l]));
+                velocity = vec_add(velocity, \
+                    vec_multiply(weight, state->stage_acceleration[l]));
+            }
+            state->trial_position = position;
+            state->trial_velocity = velocity;
+        }
+        scene_evaluate_stage(scene);
+        VEC_FOREACH(IntegratorState, state, &scene->integration) {
+            state->stage_velocity[j] = state->trial_velocity;
+            state->stage_acceleration[j] = state->trial_acceleration;
         }
-        k = scene_bodies(scene);
     }
+
+    double error = 0;
+    VEC_FOREACH(IntegratorState, state, &scene->integration) {
+        Vector position_error = VEC_ZERO, velocity_error = VEC_ZERO;
+        for (size_t l = 0; l < DOPRI_STAGES; l++) {
+            double weight = h * DOPRI_ERROR[l];
+            position_error = vec_add(position_error, \
+                vec_multiply(weight, state->stage_velocity[l]));
+            velocity_error = vec_add(velocity_error, \
+                vec_multiply(weight, state->stage_acceleration[l]));
+        }
+        double position_scale = scene->tolerance * (1 + fmax( \
+            vec_magnitude(state->position), \
+            vec_magnitude(state->trial_position)));
+        double velocity_scale = scene->tolerance * (1 + fmax( \
+            vec_magnitude(state->velocity), \
+            vec_magnitude(state->trial_velocity)));
+        error = fmax(error, vec_magnitude(position_error) / position_scale);
+        error = fmax(error, vec_magnitude(velocity_error) / velocity_scale);
+    }
+    return error;
+}
+
+/**
+ * Advances the integrated bodies by dt in substeps chosen to keep the error
+ * of each within the scene's tolerance, for INTEGRATOR_ADAPTIVE.
+ * The first stage must already have been evaluated.
+ */
+void scene_integrate_adaptive(Scene *scene, double dt) {
+    VEC_FOREACH(IntegratorState, state, &scene->integration) {
+        state->stage_velocity[0] = state->velocity;
+        state->stage_acceleration[0] = state->acceleration;
+    }
+    double step = scene->adaptive_step > 0 ? scene->adaptive_step : dt;
+    double remaining = dt;
+    while (remaining > 0) {
+        // The step is cut short to end exactly at the end of the tick
+        bool last = step >= remaining;
+        double h = last ? remaining : step;
+        double error = scene_dopri_step(scene, h);
+        assert(!isnan(error));
+
+        // Aim the next error at the tolerance, assuming it grows as h^5
+        double factor = error == 0 ? MAX_STEP_FACTOR \
+            : fmin(MAX_STEP_FACTOR, fmax(MIN_STEP_FACTOR, \
+                STEP_SAFETY * pow(error, -0.2)));
+        if (error > 1) {
+            scene->steps_rejected++;
+            step = h * fmin(factor, 1);
+            assert(step > dt * DBL_EPSILON);
+            continue;
+        }
+        scene->steps_taken++;
+        VEC_FOREACH(IntegratorState, state, &scene->integration) {
+            state->position = state->trial_position;
+            state->velocity = state->trial_velocity;
+            state->stage_velocity[0] = state->stage_velocity[DOPRI_STAGES - 1];
+            state->stage_acceleration[0] = \
+                state->stage_acceleration[DOPRI_STAGES - 1];
+        }
+        // A step shortened to end the tick says little about the next one
+        step = last ? fmax(step, h * factor) : h * factor;
+        remaining = last ? 0 : remaining - h;
+    }
+    scene->adaptive_step = step;
+}
+
+/** Whether scene_tick_integrator() moves a body with the scene's integrator */
+bool is_integrated(Body *body) {
+    return (body_get_motion(body) & MOTION_FORCES)
+        && body_get_type(body) == BODY_DYNAMIC
+        && !body_is_sleeping(body)
+        && body_get_mass(body) != INFINITY;
+}
+
+/**
+ * Step 3 of scene_tick() for integrators other than
+ * INTEGRATOR_AVERAGE_VELOCITY. The forces of the creators that only run once
+ * are already on the bodies; the pure ones are evaluated once per stage.
+ * Bodies not moved by forces are ticked by body_integrate() afterwards,
+ * so they stay where they were while the stages are evaluated.
+ */
+void scene_tick_integrator(Scene *scene, double dt) {
+    scene_sweep_bodies(scene, false, dt);
+    IntegratorStateVec_clear(&scene->integration);
+    VEC_FOREACH(Body *, body, &scene->bodies) {
+        if (!is_integrated(*body)) {
+            continue;
+        }
+        IntegratorState state = {.body = *body, \
+            .inv_mass = 1 / body_get_mass(*body)};
+        state.position = body_get_centroid(*body);
+        state.velocity = vec_add(body_get_velocity(*body), \
+            vec_multiply(state.inv_mass, body_get_impulse(*body)));
+        state.fixed_force = body_get_force(*body);
+        state.gravity = vec_multiply(body_get_gravity_scale(*body), \
+            scene->gravity);
+        state.trial_position = state.position;
+        state.trial_velocity = state.velocity;
+        IntegratorStateVec_push(&scene->integration, state);
+    }
+
+    scene_evaluate_stage(scene);
+    VEC_FOREACH(IntegratorState, state, &scene->integration) {
+        state->acceleration = state->trial_acceleration;
+    }
+    switch (scene->integrator) {
+        case INTEGRATOR_SYMPLECTIC_EULER:
+            VEC_FOREACH(IntegratorState, state, &scene->integration) {
+                state->velocity = vec_add(state->velocity, \
+                    vec_multiply(dt, state->acceleration));
+                state->position = vec_add(state->position, \
+                    vec_multiply(dt, state->velocity));
+            }
+            break;
+        case INTEGRATOR_VELOCITY_VERLET:
+            // x1 = x0 + v0 dt + a0 dt^2 / 2, and v1 = v0 + (a0 + a1) dt / 2,
+            // where a1 is evaluated with a predicted velocity for drag
+            VEC_FOREACH(IntegratorState, state, &scene->integration) {
+                state->trial_position = vec_add(state->position, \
+                    vec_add(vec_multiply(dt, state->velocity), \
+                    vec_multiply(dt * dt * 0.5, state->acceleration)));
+                state->trial_velocity = vec_add(state->velocity, \
+                    vec_multiply(dt, state->acceleration));
+            }
+            scene_evaluate_stage(scene);
+            VEC_FOREACH(IntegratorState, state, &scene->integration) {
+                state->position = state->trial_position;
+                state->velocity = vec_add(state->velocity, \
+                    vec_multiply(dt * 0.5, vec_add(state->acceleration, \
+                    state->trial_acceleration)));
+            }
+            break;
+        case INTEGRATOR_RK4:
+            VEC_FOREACH(IntegratorState, state, &scene->integration) {
+                state->position_change = VEC_ZERO;
+                state->velocity_change = VEC_ZERO;
+            }
+            scene_sum_stage(scene, 1);
+            scene_set_trial_states(scene, dt * 0.5);
+            scene_evaluate_stage(scene);
+            scene_sum_stage(scene, 2);
+            scene_set_trial_states(scene, dt * 0.5);
+            scene_evaluate_stage(scene);
+            scene_sum_stage(scene, 2);
+            scene_set_trial_states(scene, dt);
+            scene_evaluate_stage(scene);
+            scene_sum_stage(scene, 1);
+            VEC_FOREACH(IntegratorState, state, &scene->integration) {
+                state->position = vec_add(state->position, \
+                    vec_multiply(dt / 6, state->position_change));
+                state->velocity = vec_add(state->velocity, \
+                    vec_multiply(dt / 6, state->velocity_change));
+            }
+            break;
+        case INTEGRATOR_ADAPTIVE:
+            scene_integrate_adaptive(scene, dt);
+            break;
+        default:
+            assert(false);
+    }
+
+    VEC_FOREACH(IntegratorState, state, &scene->integration) {
+        Body *body = state->body;
+        body_set_acceleration(body, state->acceleration);
+        if (body_get_motion(body) & MOTION_ACCELERATION) {
+            // Same update as body_integrate(), continuing from the above
+            state->position = vec_add(state->position, \
+                vec_add(vec_multiply(dt, state->velocity), \
+                vec_multiply(dt * dt * 0.5, state->acceleration)));
+            state->velocity = vec_add(state->velocity, \
+                vec_multiply(dt, state->acceleration));
+        }
+        body_set_centroid(body, state->position);
+        body_set_velocity(body, state->velocity);
+        body_set_force(body, VEC_ZERO);
+        body_set_impulse(body, VEC_ZERO);
+        body_rotate_with_velocity(body);
+    }
+    VEC_FOREACH(Body *, body, &scene->bodies) {
+        if (!is_integrated(*body)) {
+            body_integrate_with_gravity(*body, scene->gravity, dt);
+        }
+    }
+}
+
+/** Runs the scene's constraint batches in the order they were added */
+void scene_solve_constraints(Scene *scene) {
+    VEC_FOREACH(ForceInfo *, constraints, &scene->constraints) {
+        (*constraints)->forcer((*constraints)->aux);
+    }
+}
+
+/** The last step of scene_tick(): puts bodies that have come to rest to sleep */
+void scene_update_sleep(Scene *scene) {
+    if (scene->sleep_ticks == 0) {
+        return;
+    }
+    VEC_FOREACH(Body *, body, &scene->bodies) {
+        body_update_sleep(*body, scene->sleep_speed, scene->sleep_ticks);
+    }
+}
+
+void scene_tick(Scene *scene, double dt) {
+    assert(scene);
+    scene->dt = dt;
+    if (scene->integrator != INTEGRATOR_ADAPTIVE) {
+        scene->steps_taken++;
+    }
+
+    if (scene->integrator != INTEGRATOR_AVERAGE_VELOCITY) {
+        // Step 1: Apply the forces that are not re-evaluated within the tick
+        scene_run_forces(scene, false);
+        // Step 2: Remove forces that have had one of its bodies removed
+        scene_remove_stale_forces(scene);
+        scene_tick_integrator(scene, dt);
+        scene_solve_constraints(scene);
+        scene_update_sleep(scene);
+        return;
+    }
+
+    // Step 1: Iterate through all forces and apply
+    // (by index, since a collision handler may add forces)
+    if (scene->pool && scene_bodies(scene) > PARALLEL_CHUNK_BODIES) {
+        // The pure ones only add forces, so they can run on the scene's
+        // threads; the others, like collision checks, may change the scene
+        scene_run_pure_forces_parallel(scene);
+        scene_run_forces(scene, false);
+    } else {
+        for (size_t i = 0; i < scene_forces(scene); i++) {
+            ForceInfo *force = VEC_AT(&scene->forces, i);
+            force->forcer(force->aux);
+        }
+    }
+
+    // Step 2: Remove forces that have had one of its bodies removed
+    scene_remove_stale_forces(scene);
+
+    if (scene->use_arrays) {
+        scene_tick_arrays(scene, dt);
+    } else if (scene->pool) {
+        // Step 3: Removes all bodies that are marked to be removed,
+        // then ticks the others on the scene's threads
+        scene_sweep_bodies(scene, false, dt);
+        IntegrateJob job = {.scene = scene, .dt = dt};
+        thread_pool_for(scene->pool, scene_bodies(scene), \
+            PARALLEL_CHUNK_BODIES, scene_integrate_chunk, &job);
+        scene_collect_substepped(scene);
+        scene_substep_bodies(scene, dt);
+    } else {
+        // Step 3: Removes all bodies that are marked to be removed
+        scene_sweep_bodies(scene, true, dt);
+        scene_substep_bodies(scene, dt);
+    }
+
+    // Step 4: Pull the bodies back to where their constraints allow
+    scene_solve_constraints(scene);
+
+    // Step 5: Put bodies that have come to rest to sleep
+    scene_update_sleep(scene);
 }
 
 void scene_tick_no_forces(Scene *scene, double dt) {
@@ -143,7 +1273,7 @@ void scene_tick_no_forces(Scene *scene, double dt) {
     }
 }
 
-void scene_add_special_body(
+BodyHandle scene_add_special_body(
     Scene* scene,
     RGBColor color,
     List *points,
@@ -158,11 +1288,12 @@ void scene_add_special_body(
         mass = DEFAULT_MASS;
     }
 
-    Body *special_body = body_init(points, mass, color);
+    BodyHandle handle = scene_spawn_body(scene, points, mass, color, NULL, NULL);
+    Body *special_body = scene_get_body_by_handle(scene, handle);
     body_set_velocity(special_body, start_vel);
     body_set_acceleration(special_body, start_acc);
     body_set_elasticity(special_body, elasticity);
-    scene_add_body(scene, special_body);
+    return handle;
 }
 
 void scene_add_force_creator(
@@ -174,15 +1305,100 @@ void scene_add_force_creator(
     scene_add_bodies_force_creator(scene, forcer, aux, NULL, freer);
 }
 
-void scene_add_bodies_force_creator(
-    Scene *scene, ForceCreator forcer, void *aux, List *bodies, FreeFunc freer
+/** Adds a force creator, which may be pure (see ForceInfo) */
+void scene_push_force(
+    Scene *scene, ForceCreator forcer, void *aux, List *bodies, FreeFunc freer,
+    bool pure
 ) {
     assert(scene);
-    ForceInfo* force_info = malloc(sizeof(ForceInfo));
-    assert(force_info);
+    ForceInfo* force_info = arena_alloc(scene->arena, sizeof(ForceInfo));
+    force_info->pure = pure;
     force_info->forcer = forcer;
     force_info->aux = aux;
     force_info->aux_freer = freer;
     force_info->bodies = bodies;
-    list_add(scene->forceInfos, force_info);
+    force_info->pruner = NULL;
+    force_info->parallel = false;
+    force_info->owns_heap = freer && !arena_contains(scene->arena, aux);
+    if (force_info->owns_heap) {
+        scene->heap_owners++;
+    }
+    ForceInfoPtrVec_push(&scene->forces, force_info);
+}
+
+void scene_add_bodies_force_creator(
+    Scene *scene, ForceCreator forcer, void *aux, List *bodies, FreeFunc freer
+) {
+    scene_push_force(scene, forcer, aux, bodies, freer, false);
+}
+
+void scene_add_pure_force_creator(
+    Scene *scene, ForceCreator forcer, void *aux, List *bodies, FreeFunc freer
+) {
+    scene_push_force(scene, forcer, aux, bodies, freer, true);
+}
+
+void scene_add_force_batch(
+    Scene *scene, ForceCreator forcer, void *aux, ForcePruner pruner,
+    FreeFunc freer
+) {
+    assert(pruner);
+    scene_push_force(scene, forcer, aux, NULL, freer, true);
+    ForceInfo *batch = VEC_AT(&scene->forces, scene_forces(scene) - 1);
+    batch->pruner = pruner;
+    // Replace the older batch of this kind, if any
+    VEC_FOREACH(ForceInfo *, newest, &scene->batches) {
+        if ((*newest)->forcer == forcer) {
+            *newest = batch;
+            return;
+        }
+    }
+    ForceInfoPtrVec_push(&scene->batches, batch);
+}
+
+void scene_add_parallel_force_batch(
+    Scene *scene, ForceCreator forcer, void *aux, ForcePruner pruner,
+    FreeFunc freer
+) {
+    scene_add_force_batch(scene, forcer, aux, pruner, freer);
+    VEC_AT(&scene->forces, scene_forces(scene) - 1)->parallel = true;
+}
+
+void scene_add_constraint_batch(
+    Scene *scene, ForceCreator solver, void *aux, ForcePruner pruner,
+    FreeFunc freer
+) {
+    assert(scene);
+    assert(pruner);
+    ForceInfo *constraints = arena_alloc(scene->arena, sizeof(ForceInfo));
+    constraints->pure = false;
+    constraints->forcer = solver;
+    constraints->aux = aux;
+    constraints->aux_freer = freer;
+    constraints->bodies = NULL;
+    constraints->pruner = pruner;
+    constraints->parallel = false;
+    constraints->owns_heap = freer && !arena_contains(scene->arena, aux);
+    if (constraints->owns_heap) {
+        scene->heap_owners++;
+    }
+    ForceInfoPtrVec_push(&scene->constraints, constraints);
+    // Replace the older batch of this kind, if any
+    VEC_FOREACH(ForceInfo *, newest, &scene->batches) {
+        if ((*newest)->forcer == solver) {
+            *newest = constraints;
+            return;
+        }
+    }
+    ForceInfoPtrVec_push(&scene->batches, constraints);
+}
+
+void *scene_get_force_batch(Scene *scene, ForceCreator forcer) {
+    assert(scene);
+    VEC_FOREACH(ForceInfo *, batch, &scene->batches) {
+        if ((*batch)->forcer == forcer) {
+            return (*batch)->aux;
+        }
+    }
+    return NULL;
 }
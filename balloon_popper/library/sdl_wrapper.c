@@ -188,7 +188,10 @@ void sdl_draw_text(Text* text) {
     SDL_RenderCopy(renderer, get_texture_text(text), NULL, &dstrect);
 }
 
-void sdl_draw_polygon(List *points, RGBColor color) {
+/**
+ * Draws a polygon moved by an offset, without moving its vertices.
+ */
+void draw_polygon_offset(List *points, Vector offset, RGBColor color) {
     // Check parameters
     size_t n = list_size(points);
     assert(n >= 3);
@@ -208,7 +211,7 @@ void sdl_draw_polygon(List *points, RGBColor color) {
     for (size_t i = 0; i < n; i++) {
         Vector *vertex = list_get(points, i);
         Vector pos_from_center =
-            vec_multiply(scale, vec_subtract(*vertex, center));
+            vec_multiply(scale, vec_subtract(vec_add(*vertex, offset), center));
         // Flip y axis since positive y is down on the screen
         x_points[i] = round(center_x + pos_from_center.x);
         y_points[i] = round(center_y - pos_from_center.y);
@@ -224,6 +227,10 @@ void sdl_draw_polygon(List *points, RGBColor color) {
     free(y_points);
 }
 
+void sdl_draw_polygon(List *points, RGBColor color) {
+    draw_polygon_offset(points, VEC_ZERO, color);
+}
+
 void sdl_show(void) {
     SDL_RenderPresent(renderer);
 }
@@ -239,6 +246,17 @@ void sdl_render_scene(Scene *scene) {
     sdl_show();
 }
 
+void sdl_render_scene_interpolated(Scene *scene, GameLoop *loop) {
+    sdl_clear();
+    const Vector *offsets = game_loop_render_offsets(loop, scene);
+    size_t body_count = scene_bodies(scene);
+    for (size_t i = 0; i < body_count; i++) {
+        Body *body = scene_get_body(scene, i);
+        List *shape = body_get_shape(body);
+        draw_polygon_offset(shape, offsets[i], body_get_color(body));
+    }
+    sdl_show();
+}
 
 void sdl_render_game(GameInfo* game) {
     assert(game);
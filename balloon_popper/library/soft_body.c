@@ -0,0 +1,612 @@
+#include "soft_body.h"
+#include "collision.h"
+#include "vec.h"
+#include <assert.h>
+#include <math.h>
+
+// How many particles or constraints a thread takes at a time
+#define SOFT_CHUNK 512
+// Constraints are colored so that no two of a color share a particle, with
+// one bit per color in each particle's mask. Those that fit in no color go
+// in one more group, which is solved serially.
+#define SOFT_COLORS 64
+#define SOFT_GROUPS (SOFT_COLORS + 1)
+
+DEFINE_VEC_NAMED(BodyPtrVec, Body *)
+DEFINE_VEC_NAMED(IndexVec, uint32_t)
+DEFINE_VEC_NAMED(DoubleVec, double)
+DEFINE_VEC_NAMED(MaskVec, uint64_t)
+
+/**
+ * Constraints of one kind, each on arity particles, stored in order of
+ * their colors once colored is set
+ */
+typedef struct {
+    size_t arity;
+    IndexVec particles;
+    DoubleVec rest;
+    DoubleVec compliance;
+    // The constraints of group g are color_start[g] to color_start[g + 1]
+    size_t color_start[SOFT_GROUPS + 1];
+    bool colored;
+} SoftConstraints;
+
+struct softBody {
+    Scene *scene;
+    size_t substeps;
+    DoubleVec x;
+    DoubleVec y;
+    // Where the particles were at the start of the substep
+    DoubleVec prev_x;
+    DoubleVec prev_y;
+    DoubleVec vx;
+    DoubleVec vy;
+    DoubleVec inv_mass;
+    SoftConstraints distances;
+    SoftConstraints bends;
+    IndexVec area_first;
+    IndexVec area_count;
+    DoubleVec area_rest;
+    DoubleVec area_compliance;
+    BodyPtrVec colliders;
+    // Each collider's min x, min y, max x and max y this tick
+    DoubleVec collider_bounds;
+    // Scratch space for coloring constraints
+    MaskVec masks;
+    IndexVec colors;
+    IndexVec scratch_particles;
+    DoubleVec scratch_rest;
+    DoubleVec scratch_compliance;
+    // The substep in progress, and the first constraint of the color
+    // being solved, for the loops run on the scene's threads
+    double h;
+    Vector gravity;
+    size_t color_offset;
+};
+
+void soft_constraints_init(
+    SoftConstraints *group, size_t arity, const Allocator *allocator
+) {
+    group->arity = arity;
+    IndexVec_init(&group->particles, allocator);
+    DoubleVec_init(&group->rest, allocator);
+    DoubleVec_init(&group->compliance, allocator);
+    group->colored = false;
+}
+
+void soft_constraints_free(SoftConstraints *group) {
+    IndexVec_free(&group->particles);
+    DoubleVec_free(&group->rest);
+    DoubleVec_free(&group->compliance);
+}
+
+/**
+ * Sorts a soft body's constraints of one kind by color, giving each the
+ * first color none of its particles has yet, in the order they were added
+ */
+void soft_body_color(SoftBody *soft, SoftConstraints *group) {
+    size_t arity = group->arity;
+    size_t count = group->rest.size;
+    MaskVec_clear(&soft->masks);
+    for (size_t i = 0; i < soft->x.size; i++) {
+        MaskVec_push(&soft->masks, 0);
+    }
+    IndexVec_clear(&soft->colors);
+    size_t sizes[SOFT_GROUPS] = {0};
+    for (size_t c = 0; c < count; c++) {
+        const uint32_t *particles = &VEC_AT(&group->particles, c * arity);
+        uint64_t used = 0;
+        for (size_t j = 0; j < arity; j++) {
+            used |= VEC_AT(&soft->masks, particles[j]);
+        }
+        uint32_t color = 0;
+        while (color < SOFT_COLORS && (used >> color & 1)) {
+            color++;
+        }
+        if (color < SOFT_COLORS) {
+            for (size_t j = 0; j < arity; j++) {
+                VEC_AT(&soft->masks, particles[j]) |= (uint64_t) 1 << color;
+            }
+        }
+        IndexVec_push(&soft->colors, color);
+        sizes[color]++;
+    }
+    group->color_start[0] = 0;
+    for (size_t g = 0; g < SOFT_GROUPS; g++) {
+        group->color_start[g + 1] = group->color_start[g] + sizes[g];
+    }
+
+    // Move each constraint to the next free place in its color
+    IndexVec_clear(&soft->scratch_particles);
+    DoubleVec_clear(&soft->scratch_rest);
+    DoubleVec_clear(&soft->scratch_compliance);
+    VEC_FOREACH(uint32_t, particle, &group->particles) {
+        IndexVec_push(&soft->scratch_particles, *particle);
+    }
+    for (size_t c = 0; c < count; c++) {
+        DoubleVec_push(&soft->scratch_rest, VEC_AT(&group->rest, c));
+        DoubleVec_push(&soft->scratch_compliance, \
+            VEC_AT(&group->compliance, c));
+    }
+    size_t next[SOFT_GROUPS];
+    for (size_t g = 0; g < SOFT_GROUPS; g++) {
+        next[g] = group->color_start[g];
+    }
+    for (size_t c = 0; c < count; c++) {
+        size_t place = next[VEC_AT(&soft->colors, c)]++;
+        for (size_t j = 0; j < arity; j++) {
+            VEC_AT(&group->particles, place * arity + j) = \
+                VEC_AT(&soft->scratch_particles, c * arity + j);
+        }
+        VEC_AT(&group->rest, place) = VEC_AT(&soft->scratch_rest, c);
+        VEC_AT(&group->compliance, place) = \
+            VEC_AT(&soft->scratch_compliance, c);
+    }
+    group->colored = true;
+}
+
+/** Applies gravity to a chunk of particles and moves them for the substep */
+void soft_body_predict(void *aux, size_t start, size_t end, size_t thread) {
+    SoftBody *soft = aux;
+    double *x = soft->x.data, *y = soft->y.data;
+    double *vx = soft->vx.data, *vy = soft->vy.data;
+    double h = soft->h;
+    for (size_t i = start; i < end; i++) {
+        soft->prev_x.data[i] = x[i];
+        soft->prev_y.data[i] = y[i];
+        if (soft->inv_mass.data[i] == 0) {
+            continue;
+        }
+        vx[i] += h * soft->gravity.x;
+        vy[i] += h * soft->gravity.y;
+        x[i] += h * vx[i];
+        y[i] += h * vy[i];
+    }
+}
+
+/** Solves a chunk of the distance constraints of the color being solved */
+void soft_body_solve_distances(
+    void *aux, size_t start, size_t end, size_t thread
+) {
+    SoftBody *soft = aux;
+    SoftConstraints *group = &soft->distances;
+    double *x = soft->x.data, *y = soft->y.data;
+    const double *w = soft->inv_mass.data;
+    double inv_h2 = 1 / (soft->h * soft->h);
+    for (size_t c = soft->color_offset + start; \
+            c < soft->color_offset + end; c++) {
+        uint32_t a = group->particles.data[2 * c];
+        uint32_t b = group->particles.data[2 * c + 1];
+        double dx = x[b] - x[a], dy = y[b] - y[a];
+        double distance = sqrt(dx * dx + dy * dy);
+        if (w[a] + w[b] == 0 || distance == 0) {
+            continue;
+        }
+        double error = distance - group->rest.data[c];
+        double alpha = group->compliance.data[c] * inv_h2;
+        double scale = -error / ((w[a] + w[b] + alpha) * distance);
+        x[a] -= w[a] * scale * dx;
+        y[a] -= w[a] * scale * dy;
+        x[b] += w[b] * scale * dx;
+        y[b] += w[b] * scale * dy;
+    }
+}
+
+/** Solves a chunk of the bending constraints of the color being solved */
+void soft_body_solve_bends(void *aux, size_t start, size_t end, size_t thread) {
+    SoftBody *soft = aux;
+    SoftConstraints *group = &soft->bends;
+    double *x = soft->x.data, *y = soft->y.data;
+    const double *w = soft->inv_mass.data;
+    double inv_h2 = 1 / (soft->h * soft->h);
+    for (size_t c = soft->color_offset + start; \
+            c < soft->color_offset + end; c++) {
+        uint32_t a = group->particles.data[3 * c];
+        uint32_t b = group->particles.data[3 * c + 1];
+        uint32_t d = group->particles.data[3 * c + 2];
+        // Written out rather than with vector.h, which the compiler
+        // cannot inline here, since this loop is most of a cloth's tick
+        double e1x = x[a] - x[b], e1y = y[a] - y[b];
+        double e2x = x[d] - x[b], e2y = y[d] - y[b];
+        double squared1 = e1x * e1x + e1y * e1y;
+        double squared2 = e2x * e2x + e2y * e2y;
+        if (w[a] + w[b] + w[d] == 0 || squared1 == 0 || squared2 == 0) {
+            continue;
+        }
+        double error = atan2(e1x * e2y - e1y * e2x, e1x * e2x + e1y * e2y) \
+            - group->rest.data[c];
+        if (error > M_PI) {
+            error -= 2 * M_PI;
+        } else if (error < -M_PI) {
+            error += 2 * M_PI;
+        }
+        // The angle's gradient with respect to each particle
+        Vector ga = {e1y / squared1, -e1x / squared1};
+        Vector gd = {-e2y / squared2, e2x / squared2};
+        Vector gb = {-ga.x - gd.x, -ga.y - gd.y};
+        double alpha = group->compliance.data[c] * inv_h2;
+        double lambda = -error / (w[a] * (ga.x * ga.x + ga.y * ga.y) \
+            + w[b] * (gb.x * gb.x + gb.y * gb.y) \
+            + w[d] * (gd.x * gd.x + gd.y * gd.y) + alpha);
+        x[a] += w[a] * lambda * ga.x;
+        y[a] += w[a] * lambda * ga.y;
+        x[b] += w[b] * lambda * gb.x;
+        y[b] += w[b] * lambda * gb.y;
+        x[d] += w[d] * lambda * gd.x;
+        y[d] += w[d] * lambda * gd.y;
+    }
+}
+
+/** The signed area enclosed by a loop of a soft body's particles */
+double soft_body_area(SoftBody *soft, size_t first, size_t count) {
+    const double *x = soft->x.data, *y = soft->y.data;
+    double area = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t p = first + i, q = first + (i + 1) % count;
+        area += x[p] * y[q] - x[q] * y[p];
+    }
+    return area / 2;
+}
+
+/** Solves a soft body's area constraints, which are few but large */
+void soft_body_solve_areas(SoftBody *soft) {
+    double *x = soft->x.data, *y = soft->y.data;
+    const double *w = soft->inv_mass.data;
+    double inv_h2 = 1 / (soft->h * soft->h);
+    for (size_t c = 0; c < soft->area_rest.size; c++) {
+        size_t first = VEC_AT(&soft->area_first, c);
+        size_t count = VEC_AT(&soft->area_count, c);
+        double error = soft_body_area(soft, first, count) \
+            - VEC_AT(&soft->area_rest, c);
+        // The area's gradient with respect to particle i is half the
+        // perpendicular of the chord between its neighbours
+        double weight = VEC_AT(&soft->area_compliance, c) * inv_h2;
+        for (size_t i = 0; i < count; i++) {
+            size_t previous = first + (i + count - 1) % count;
+            size_t next = first + (i + 1) % count;
+            double gx = (y[next] - y[previous]) / 2;
+            double gy = (x[previous] - x[next]) / 2;
+            weight += w[first + i] * (gx * gx + gy * gy);
+        }
+        if (weight == 0) {
+            continue;
+        }
+        double lambda = -error / weight;
+        // Every gradient is taken at the positions from before the solve
+        double first_x = x[first], first_y = y[first];
+        double previous_x = x[first + count - 1];
+        double previous_y = y[first + count - 1];
+        for (size_t i = 0; i < count; i++) {
+            size_t p = first + i;
+            double next_x = i + 1 < count ? x[p + 1] : first_x;
+            double next_y = i + 1 < count ? y[p + 1] : first_y;
+            double gx = (next_y - previous_y) / 2;
+            double gy = (previous_x - next_x) / 2;
+            previous_x = x[p];
+            previous_y = y[p];
+            x[p] += w[p] * lambda * gx;
+            y[p] += w[p] * lambda * gy;
+        }
+    }
+}
+
+/**
+ * Pushes a chunk of particles out of the soft body's colliders, and sets
+ * their velocities from how far they moved over the substep
+ */
+void soft_body_finish(void *aux, size_t start, size_t end, size_t thread) {
+    SoftBody *soft = aux;
+    double *x = soft->x.data, *y = soft->y.data;
+    const double *bounds = soft->collider_bounds.data;
+    size_t colliders = soft->colliders.size;
+    for (size_t i = start; i < end; i++) {
+        if (soft->inv_mass.data[i] > 0) {
+            for (size_t c = 0; c < colliders; c++) {
+                const double *bound = &bounds[4 * c];
+                if (x[i] < bound[0] || y[i] < bound[1] \
+                        || x[i] > bound[2] || y[i] > bound[3]) {
+                    continue;
+                }
+                Vector exit = find_point_collision( \
+                    body_get_shape(soft->colliders.data[c]), \
+                    (Vector) {x[i], y[i]});
+                x[i] += exit.x;
+                y[i] += exit.y;
+            }
+        }
+        soft->vx.data[i] = (x[i] - soft->prev_x.data[i]) / soft->h;
+        soft->vy.data[i] = (y[i] - soft->prev_y.data[i]) / soft->h;
+    }
+}
+
+/** Solves each color of a soft body's constraints of one kind in turn */
+void soft_body_solve_colors(
+    SoftBody *soft, SoftConstraints *group, ParallelFunc solve,
+    ThreadPool *pool
+) {
+    for (size_t g = 0; g < SOFT_GROUPS; g++) {
+        size_t count = group->color_start[g + 1] - group->color_start[g];
+        if (count == 0) {
+            continue;
+        }
+        soft->color_offset = group->color_start[g];
+        // The last group's constraints may share particles
+        thread_pool_for(g < SOFT_COLORS ? pool : NULL, count, SOFT_CHUNK, \
+            solve, soft);
+    }
+}
+
+/** Simulates a soft body for a tick (see scene_add_constraint_batch()) */
+void solveSoftBody(void *aux) {
+    SoftBody *soft = aux;
+    double dt = scene_get_dt(soft->scene);
+    size_t n = soft->x.size;
+    if (dt == 0 || n == 0) {
+        return;
+    }
+    if (!soft->distances.colored) {
+        soft_body_color(soft, &soft->distances);
+    }
+    if (!soft->bends.colored) {
+        soft_body_color(soft, &soft->bends);
+    }
+    // The colliders have already moved this tick
+    for (size_t c = 0; c < soft->colliders.size; c++) {
+        List *shape = body_get_shape(VEC_AT(&soft->colliders, c));
+        double *bound = &VEC_AT(&soft->collider_bounds, 4 * c);
+        bound[0] = bound[1] = INFINITY;
+        bound[2] = bound[3] = -INFINITY;
+        for (size_t i = 0; i < list_size(shape); i++) {
+            Vector *vertex = list_get(shape, i);
+            bound[0] = fmin(bound[0], vertex->x);
+            bound[1] = fmin(bound[1], vertex->y);
+            bound[2] = fmax(bound[2], vertex->x);
+            bound[3] = fmax(bound[3], vertex->y);
+        }
+    }
+
+    ThreadPool *pool = scene_get_thread_pool(soft->scene);
+    soft->h = dt / soft->substeps;
+    soft->gravity = scene_get_gravity(soft->scene);
+    for (size_t s = 0; s < soft->substeps; s++) {
+        thread_pool_for(pool, n, SOFT_CHUNK, soft_body_predict, soft);
+        soft_body_solve_colors(soft, &soft->distances, \
+            soft_body_solve_distances, pool);
+        soft_body_solve_colors(soft, &soft->bends, soft_body_solve_bends, \
+            pool);
+        soft_body_solve_areas(soft);
+        thread_pool_for(pool, n, SOFT_CHUNK, soft_body_finish, soft);
+    }
+}
+
+/** A ForcePruner for a soft body: stops checking removed colliders */
+void soft_body_prune(void *aux) {
+    SoftBody *soft = aux;
+    size_t kept = 0;
+    VEC_FOREACH(Body *, collider, &soft->colliders) {
+        if (!body_is_removed(*collider)) {
+            VEC_AT(&soft->colliders, kept++) = *collider;
+        }
+    }
+    soft->colliders.size = kept;
+    soft->collider_bounds.size = 4 * kept;
+}
+
+void soft_body_free(void *aux) {
+    SoftBody *soft = aux;
+    DoubleVec *arrays[] = {&soft->x, &soft->y, &soft->prev_x, &soft->prev_y, \
+        &soft->vx, &soft->vy, &soft->inv_mass, &soft->area_rest, \
+        &soft->area_compliance, &soft->collider_bounds, &soft->scratch_rest, \
+        &soft->scratch_compliance};
+    for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++) {
+        DoubleVec_free(arrays[i]);
+    }
+    soft_constraints_free(&soft->distances);
+    soft_constraints_free(&soft->bends);
+    IndexVec_free(&soft->area_first);
+    IndexVec_free(&soft->area_count);
+    BodyPtrVec_free(&soft->colliders);
+    MaskVec_free(&soft->masks);
+    IndexVec_free(&soft->colors);
+    IndexVec_free(&soft->scratch_particles);
+    arena_release(soft);
+}
+
+SoftBody *create_soft_body(Scene *scene) {
+    assert(scene);
+    const Allocator *allocator = arena_allocator(scene_get_arena(scene));
+    SoftBody *soft = allocator_alloc(allocator, sizeof(SoftBody));
+    soft->scene = scene;
+    soft->substeps = SOFT_BODY_DEFAULT_SUBSTEPS;
+    DoubleVec *arrays[] = {&soft->x, &soft->y, &soft->prev_x, &soft->prev_y, \
+        &soft->vx, &soft->vy, &soft->inv_mass, &soft->area_rest, \
+        &soft->area_compliance, &soft->collider_bounds, &soft->scratch_rest, \
+        &soft->scratch_compliance};
+    for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++) {
+        DoubleVec_init(arrays[i], allocator);
+    }
+    soft_constraints_init(&soft->distances, 2, allocator);
+    soft_constraints_init(&soft->bends, 3, allocator);
+    IndexVec_init(&soft->area_first, allocator);
+    IndexVec_init(&soft->area_count, allocator);
+    BodyPtrVec_init(&soft->colliders, allocator);
+    MaskVec_init(&soft->masks, allocator);
+    IndexVec_init(&soft->colors, allocator);
+    IndexVec_init(&soft->scratch_particles, allocator);
+    soft->h = 0;
+    soft->gravity = VEC_ZERO;
+    soft->color_offset = 0;
+    scene_add_constraint_batch(scene, solveSoftBody, soft, soft_body_prune, \
+        soft_body_free);
+    return soft;
+}
+
+size_t soft_body_add_particle(SoftBody *soft, Vector position, double mass) {
+    assert(soft);
+    assert(mass > 0);
+    DoubleVec_push(&soft->x, position.x);
+    DoubleVec_push(&soft->y, position.y);
+    DoubleVec_push(&soft->prev_x, position.x);
+    DoubleVec_push(&soft->prev_y, position.y);
+    DoubleVec_push(&soft->vx, 0);
+    DoubleVec_push(&soft->vy, 0);
+    DoubleVec_push(&soft->inv_mass, 1 / mass);
+    return soft->x.size - 1;
+}
+
+/** Adds a constraint on some particles to a soft body's constraints */
+void soft_body_add_constraint(
+    SoftBody *soft, SoftConstraints *group, const size_t *particles,
+    double rest, double compliance
+) {
+    assert(compliance >= 0);
+    for (size_t j = 0; j < group->arity; j++) {
+        assert(particles[j] < soft->x.size);
+        IndexVec_push(&group->particles, particles[j]);
+    }
+    DoubleVec_push(&group->rest, rest);
+    DoubleVec_push(&group->compliance, compliance);
+    group->colored = false;
+}
+
+void soft_body_add_distance(
+    SoftBody *soft, size_t particle1, size_t particle2, double compliance
+) {
+    assert(particle1 != particle2);
+    size_t particles[] = {particle1, particle2};
+    Vector position1 = soft_body_get_position(soft, particle1);
+    Vector position2 = soft_body_get_position(soft, particle2);
+    soft_body_add_constraint(soft, &soft->distances, particles, \
+        vec_distance(position1, position2), compliance);
+}
+
+void soft_body_add_bending(
+    SoftBody *soft, size_t particle1, size_t particle2, size_t particle3,
+    double compliance
+) {
+    size_t particles[] = {particle1, particle2, particle3};
+    Vector position1 = soft_body_get_position(soft, particle1);
+    Vector position2 = soft_body_get_position(soft, particle2);
+    Vector position3 = soft_body_get_position(soft, particle3);
+    // The angle from particle1 to particle3 around particle2
+    Vector e1 = vec_subtract(position1, position2);
+    Vector e2 = vec_subtract(position3, position2);
+    double angle = atan2(vec_cross(e1, e2), vec_dot(e1, e2));
+    soft_body_add_constraint(soft, &soft->bends, particles, angle, \
+        compliance);
+}
+
+void soft_body_add_area(
+    SoftBody *soft, size_t first, size_t count, double compliance
+) {
+    assert(soft);
+    assert(count >= 3);
+    assert(first + count <= soft->x.size);
+    assert(compliance >= 0);
+    IndexVec_push(&soft->area_first, first);
+    IndexVec_push(&soft->area_count, count);
+    DoubleVec_push(&soft->area_rest, soft_body_area(soft, first, count));
+    DoubleVec_push(&soft->area_compliance, compliance);
+}
+
+void soft_body_pin(SoftBody *soft, size_t particle) {
+    assert(soft);
+    assert(particle < soft->x.size);
+    VEC_AT(&soft->inv_mass, particle) = 0;
+    VEC_AT(&soft->vx, particle) = 0;
+    VEC_AT(&soft->vy, particle) = 0;
+}
+
+void soft_body_add_collider(SoftBody *soft, Body *body) {
+    assert(soft);
+    assert(body);
+    BodyPtrVec_push(&soft->colliders, body);
+    for (size_t i = 0; i < 4; i++) {
+        DoubleVec_push(&soft->collider_bounds, 0);
+    }
+}
+
+void soft_body_set_substeps(SoftBody *soft, size_t substeps) {
+    assert(soft);
+    assert(substeps > 0);
+    soft->substeps = substeps;
+}
+
+size_t soft_body_particles(SoftBody *soft) {
+    assert(soft);
+    return soft->x.size;
+}
+
+Vector soft_body_get_position(SoftBody *soft, size_t particle) {
+    assert(soft);
+    assert(particle < soft->x.size);
+    return (Vector) {VEC_AT(&soft->x, particle), VEC_AT(&soft->y, particle)};
+}
+
+Vector soft_body_get_velocity(SoftBody *soft, size_t particle) {
+    assert(soft);
+    assert(particle < soft->x.size);
+    return (Vector) {VEC_AT(&soft->vx, particle), VEC_AT(&soft->vy, particle)};
+}
+
+void soft_body_set_velocity(SoftBody *soft, size_t particle, Vector velocity) {
+    assert(soft);
+    assert(particle < soft->x.size);
+    if (VEC_AT(&soft->inv_mass, particle) == 0) {
+        return;
+    }
+    VEC_AT(&soft->vx, particle) = velocity.x;
+    VEC_AT(&soft->vy, particle) = velocity.y;
+}
+
+SoftBody *create_cloth(
+    Scene *scene, Vector corner, size_t columns, size_t rows, double spacing,
+    double mass, double compliance, double bending_compliance
+) {
+    assert(columns > 0 && rows > 0);
+    SoftBody *cloth = create_soft_body(scene);
+    for (size_t row = 0; row < rows; row++) {
+        for (size_t column = 0; column < columns; column++) {
+            Vector offset = {column * spacing, -(double) row * spacing};
+            soft_body_add_particle(cloth, vec_add(corner, offset), mass);
+        }
+    }
+    for (size_t row = 0; row < rows; row++) {
+        for (size_t column = 0; column < columns; column++) {
+            size_t i = row * columns + column;
+            if (column + 1 < columns) {
+                soft_body_add_distance(cloth, i, i + 1, compliance);
+            }
+            if (row + 1 < rows) {
+                soft_body_add_distance(cloth, i, i + columns, compliance);
+            }
+            if (column > 0 && column + 1 < columns) {
+                soft_body_add_bending(cloth, i - 1, i, i + 1, \
+                    bending_compliance);
+            }
+            if (row > 0 && row + 1 < rows) {
+                soft_body_add_bending(cloth, i - columns, i, i + columns, \
+                    bending_compliance);
+            }
+        }
+    }
+    return cloth;
+}
+
+SoftBody *create_soft_ball(
+    Scene *scene, Vector center, double radius, size_t count, double mass,
+    double compliance, double area_compliance
+) {
+    assert(count >= 3);
+    SoftBody *ball = create_soft_body(scene);
+    for (size_t i = 0; i < count; i++) {
+        double angle = 2 * M_PI * i / count;
+        soft_body_add_particle(ball, vec_add(center, \
+            (Vector) {radius * cos(angle), radius * sin(angle)}), mass);
+    }
+    for (size_t i = 0; i < count; i++) {
+        soft_body_add_distance(ball, i, (i + 1) % count, compliance);
+    }
+    soft_body_add_area(ball, 0, count, area_compliance);
+    return ball;
+}
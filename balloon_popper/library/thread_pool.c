@@ -0,0 +1,157 @@
+#include "thread_pool.h"
+#include "allocator.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+typedef struct worker {
+    struct threadPool *pool;
+    pthread_t thread;
+    size_t index;
+} Worker;
+
+/*
+ * The loop being run is described by func, aux, count and chunk.
+ * Starting one bumps generation under lock, which is how a waiting worker
+ * tells a new loop from a spurious wake-up. Chunks are claimed by advancing
+ * next_start, so threads only take the lock to start and finish a loop.
+ */
+struct threadPool {
+    size_t threads;
+    Worker *workers;
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    size_t generation;
+    // Workers that have not yet finished the current loop
+    size_t busy;
+    bool stopping;
+    ParallelFunc func;
+    void *aux;
+    size_t count;
+    size_t chunk;
+    atomic_size_t next_start;
+};
+
+/** Runs chunks of the current loop until there are none left */
+void thread_pool_run_chunks(ThreadPool *pool, size_t thread) {
+    size_t start;
+    while ((start = atomic_fetch_add(&pool->next_start, pool->chunk)) \
+            < pool->count) {
+        size_t end = pool->count - start < pool->chunk ? \
+            pool->count : start + pool->chunk;
+        pool->func(pool->aux, start, end, thread);
+    }
+}
+
+void *thread_pool_work(void *w) {
+    Worker *worker = w;
+    ThreadPool *pool = worker->pool;
+    size_t seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    while (true) {
+        while (!pool->stopping && pool->generation == seen) {
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+        if (pool->stopping) {
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+        thread_pool_run_chunks(pool, worker->index);
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0) {
+            pthread_cond_signal(&pool->work_done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+ThreadPool *thread_pool_init(size_t threads) {
+    assert(threads > 0);
+    const Allocator *allocator = allocator_global();
+    ThreadPool *pool = allocator_alloc(allocator, sizeof(ThreadPool));
+    pool->threads = threads;
+    pool->generation = 0;
+    pool->busy = 0;
+    pool->stopping = false;
+    pool->func = NULL;
+    pool->aux = NULL;
+    pool->count = 0;
+    pool->chunk = 1;
+    atomic_init(&pool->next_start, 0);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+    // The calling thread is thread 0, so only threads - 1 workers are started
+    pool->workers = NULL;
+    if (threads > 1) {
+        pool->workers = allocator_alloc(allocator, \
+            (threads - 1) * sizeof(Worker));
+    }
+    for (size_t i = 0; i + 1 < threads; i++) {
+        Worker *worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->index = i + 1;
+        int error = pthread_create(&worker->thread, NULL, thread_pool_work, \
+            worker);
+        assert(!error);
+    }
+    return pool;
+}
+
+void thread_pool_free(ThreadPool *pool) {
+    assert(pool);
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+    for (size_t i = 0; i + 1 < pool->threads; i++) {
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+    pthread_cond_destroy(&pool->work_done);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_mutex_destroy(&pool->lock);
+    const Allocator *allocator = allocator_global();
+    allocator_free(allocator, pool->workers);
+    allocator_free(allocator, pool);
+}
+
+size_t thread_pool_threads(ThreadPool *pool) {
+    assert(pool);
+    return pool->threads;
+}
+
+void thread_pool_for(
+    ThreadPool *pool, size_t count, size_t chunk, ParallelFunc func, void *aux
+) {
+    assert(chunk > 0);
+    assert(func);
+    if (!pool || pool->threads == 1 || count <= chunk) {
+        for (size_t start = 0; start < count; start += chunk) {
+            size_t end = count - start < chunk ? count : start + chunk;
+            func(aux, start, end, 0);
+        }
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->func = func;
+    pool->aux = aux;
+    pool->count = count;
+    pool->chunk = chunk;
+    atomic_store(&pool->next_start, 0);
+    pool->busy = pool->threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    thread_pool_run_chunks(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy > 0) {
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
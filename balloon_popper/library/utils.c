@@ -5,6 +5,32 @@
 
 const double CLOSENESS = 6;
 
+// Allocator the shape functions allocate from, or NULL for the global one
+const Allocator *shape_allocator = NULL;
+
+void utils_set_shape_allocator(const Allocator *allocator) {
+    shape_allocator = allocator;
+}
+
+/** Creates an empty vertex list for a shape with the given number of points */
+List *shape_init(size_t number_pts) {
+    if (shape_allocator) {
+        return list_init_with_allocator(shape_allocator, number_pts, \
+            allocator_owned);
+    }
+    return list_init(number_pts, vector_free);
+}
+
+/** Allocates a vertex for a list returned from shape_init() */
+Vector *shape_vertex(Vector v) {
+    if (shape_allocator) {
+        Vector *vertex = allocator_alloc(shape_allocator, sizeof(Vector));
+        *vertex = v;
+        return vertex;
+    }
+    return create_vector_p(v);
+}
+
 void initialize_window(Vector dimensions) {
     Vector bottom_left = vec_multiply(-0.5, dimensions);
     Vector top_right = vec_multiply(0.5, dimensions);
@@ -19,7 +45,7 @@ Scene* initialize_scene(void) {
 List* get_arrow_points(Vector pivot, double width, double height, double arrow_length) {
     // This will initialize a horizontal arrow
     size_t number_pts = 7;
-    List* points = list_init(number_pts, vector_free);
+    List* points = shape_init(number_pts);
     Vector top_left = (Vector){pivot.x, pivot.y + height/2};
     Vector bottom_left = (Vector){pivot.x, pivot.y - height/2};
     Vector bottom_right = (Vector){pivot.x + width, pivot.y - height/2};
@@ -28,63 +54,63 @@ List* get_arrow_points(Vector pivot, double width, double height, double arrow_l
     Vector top_arrow_tip = (Vector){pivot.x + width, pivot.y + height/2 + arrow_length / 2};
     Vector top_right = (Vector){pivot.x + width, pivot.y + height/2};
 
-    list_add(points, create_vector_p(top_left));
-    list_add(points, create_vector_p(bottom_left));
-    list_add(points, create_vector_p(bottom_right));
-    list_add(points, create_vector_p(bottom_arrow_tip));
-    list_add(points, create_vector_p(end_arrow_tip));
-    list_add(points, create_vector_p(top_arrow_tip));
-    list_add(points, create_vector_p(top_right));
+    list_add(points, shape_vertex(top_left));
+    list_add(points, shape_vertex(bottom_left));
+    list_add(points, shape_vertex(bottom_right));
+    list_add(points, shape_vertex(bottom_arrow_tip));
+    list_add(points, shape_vertex(end_arrow_tip));
+    list_add(points, shape_vertex(top_arrow_tip));
+    list_add(points, shape_vertex(top_right));
     return points;
 }
 
 List* get_rectangle(Vector center, double width, double height) {
     size_t number_pts = 4;
-    List* points = list_init(number_pts, vector_free);
+    List* points = shape_init(number_pts);
     Vector top_left = (Vector){center.x - width/2, center.y + height/2};
     Vector bottom_left = (Vector){center.x - width/2, center.y - height/2};
     Vector top_right = (Vector){center.x + width/2, center.y + height/2};
     Vector bottom_right = (Vector){center.x + width/2, center.y - height/2};
-    list_add(points, create_vector_p(top_left));
-    list_add(points, create_vector_p(bottom_left));
-    list_add(points, create_vector_p(bottom_right));
-    list_add(points, create_vector_p(top_right));
+    list_add(points, shape_vertex(top_left));
+    list_add(points, shape_vertex(bottom_left));
+    list_add(points, shape_vertex(bottom_right));
+    list_add(points, shape_vertex(top_right));
     return points;
 }
 
 List* get_partial_circle(double radius, int begin, int end, Vector center) {
     size_t number_pts = 50;
     size_t circle_sections = 12;
-    List* points = list_init(number_pts, vector_free);
+    List* points = shape_init(number_pts);
     double angle = 2 * M_PI / number_pts;
 
-    list_add(points, create_vector_p(center));
+    list_add(points, shape_vertex(center));
     for (size_t i = begin * number_pts / circle_sections; \
         i < end * number_pts / circle_sections; i++) {
         Vector vertex = {center.x + radius * cos(i * angle), center.y + \
             radius *sin(i * angle)};
-        list_add(points , create_vector_p(vertex));
+        list_add(points , shape_vertex(vertex));
     }
     return points;
 }
 
 List* get_oval_points(Vector center, double x_span, double y_span) {
     size_t number_pts = 52;
-    List* points = list_init(number_pts, vector_free);
+    List* points = shape_init(number_pts);
     double angle = 2 * M_PI / number_pts;
     double height = y_span / 2;
     double width = x_span / 2;
     for (size_t i = 0; i < number_pts; i++) {
           Vector vertex = {center.x + width * cos(i * angle), center.y + \
               height * sin(i * angle)};
-          list_add(points , create_vector_p(vertex));
+          list_add(points , shape_vertex(vertex));
       }
     return points;
 }
 
 List* get_bloon_points(Vector center, double x_span, double y_span) {
     size_t number_pts = 104;
-    List* points = list_init(number_pts, vector_free);
+    List* points = shape_init(number_pts);
     double angle = 2 * M_PI / number_pts;
     double height = y_span / 2;
     double width = x_span / 2;
@@ -92,48 +118,48 @@ List* get_bloon_points(Vector center, double x_span, double y_span) {
       if (i != 78) {
           Vector vertex = {center.x + width * cos(i * angle), center.y + \
               height * sin(i * angle)};
-          list_add(points , create_vector_p(vertex));
+          list_add(points , shape_vertex(vertex));
         }
       else {
         Vector vertex1 = {center.x + width * cos(i * angle) - (x_span / 8), center.y + \
             height * sin(i * angle) - (y_span / 10)};
-          list_add(points , create_vector_p(vertex1));
+          list_add(points , shape_vertex(vertex1));
         Vector vertex2 = {center.x + width * cos(i * angle) + (x_span / 8), center.y + \
               height * sin(i * angle) - (y_span / 10)};
-            list_add(points , create_vector_p(vertex2));
+            list_add(points , shape_vertex(vertex2));
       }
     }
     return points;
 }
 
 List* get_dart_points(Vector tip, double length, double thickness) {
-    List* points = list_init(9, vector_free);
+    List* points = shape_init(9);
     Vector vertex1 = tip;
-    list_add(points , create_vector_p(vertex1));
+    list_add(points , shape_vertex(vertex1));
     Vector vertex10 = {tip.x - (length / 6), tip.y + (thickness / 4)};
-    list_add(points , create_vector_p(vertex10));
+    list_add(points , shape_vertex(vertex10));
   //  Vector vertex2 = {tip.x - (length / 3), tip.y + (thickness / 2)};
-    //list_add(points , create_vector_p(vertex2));
+    //list_add(points , shape_vertex(vertex2));
     Vector vertex3 = {tip.x - (length / 3), tip.y + thickness};
-    list_add(points , create_vector_p(vertex3));
+    list_add(points , shape_vertex(vertex3));
     Vector vertex4 = {tip.x - ((2 * length) / 3), tip.y + thickness};
-    list_add(points , create_vector_p(vertex4));
+    list_add(points , shape_vertex(vertex4));
     Vector vertex12 = {tip.x - ((3 * length) / 4), tip.y + (thickness / 2)};
-    list_add(points , create_vector_p(vertex12));
+    list_add(points , shape_vertex(vertex12));
     Vector vertex5 = {tip.x - length, tip.y + thickness * 3};
-    list_add(points , create_vector_p(vertex5));
+    list_add(points , shape_vertex(vertex5));
     Vector vertex6 = {tip.x - length, tip.y - thickness * 3};
-    list_add(points , create_vector_p(vertex6));
+    list_add(points , shape_vertex(vertex6));
     Vector vertex13 = {tip.x - ((3 * length) / 4), tip.y - (thickness / 2)};
-    list_add(points , create_vector_p(vertex13));
+    list_add(points , shape_vertex(vertex13));
     Vector vertex7 = {tip.x - ((2 * length) / 3), tip.y - thickness};
-    list_add(points , create_vector_p(vertex7));
+    list_add(points , shape_vertex(vertex7));
     Vector vertex8 = {tip.x - (length / 3), tip.y - thickness};
-    list_add(points , create_vector_p(vertex8));
+    list_add(points , shape_vertex(vertex8));
     //Vector vertex9 = {tip.x - (length / 3), tip.y - (thickness / 2)};
-    //list_add(points , create_vector_p(vertex9));
+    //list_add(points , shape_vertex(vertex9));
     Vector vertex11 = {tip.x - (length / 6), tip.y - (thickness / 4)};
-    list_add(points , create_vector_p(vertex11));
+    list_add(points , shape_vertex(vertex11));
     return points;
 }
 
@@ -232,7 +258,7 @@ bool check_out_of_bounds(Body *star, Vector bound, bool check_x, \
 
 /* uses trigonometry to get the inner and outer vertices of an n pointed star */
 List *get_star_points(size_t num_of_points, double radius, Vector center) {
-  List *star = list_init(num_of_points * 2, (FreeFunc) vector_free);
+  List *star = shape_init(num_of_points * 2);
   double angle = M_PI / 2;
   double vertex_shift = M_PI / num_of_points;
 
@@ -251,23 +277,23 @@ List *get_star_points(size_t num_of_points, double radius, Vector center) {
 
     Vector outer_point = vec_subtract(center, update_vec1);
     Vector inner_point = vec_subtract(center, update_vec2);
-    list_add(star, create_vector_p(outer_point));
-    list_add(star, create_vector_p(inner_point));
+    list_add(star, shape_vertex(outer_point));
+    list_add(star, shape_vertex(inner_point));
   }
   return star;
 }
 
 List* get_bullet_points(Vector center, double height, double width) {
   size_t number_pts = 4;
-  List* points = list_init(number_pts, vector_free);
+  List* points = shape_init(number_pts);
   Vector v1 = {center.x + (width / 2), center.y + (height / 2)};
   Vector v2 = {center.x - (width / 2), center.y + (height / 2)};
   Vector v3 = {center.x - (width / 2), center.y - (height / 2)};
   Vector v4 = {center.x + (width / 2), center.y - (height / 2)};
-  list_add(points, create_vector_p(v1));
-  list_add(points, create_vector_p(v2));
-  list_add(points, create_vector_p(v3));
-  list_add(points, create_vector_p(v4));
+  list_add(points, shape_vertex(v1));
+  list_add(points, shape_vertex(v2));
+  list_add(points, shape_vertex(v3));
+  list_add(points, shape_vertex(v4));
   return points;
 }
 
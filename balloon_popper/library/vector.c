@@ -1,4 +1,5 @@
 #include "vector.h"
+#include "allocator.h"
 #include <stdlib.h>
 #include <math.h>
 #include <assert.h>
@@ -17,15 +18,14 @@ Vector vec_init(double x, double y) {
 }
 
 Vector *create_vector_p(Vector v) {
-  Vector *new_vec = malloc(sizeof(Vector));
-  assert(new_vec);
+  Vector *new_vec = allocator_alloc(allocator_global(), sizeof(Vector));
   *new_vec = v;
   return new_vec;
 }
 
 void vector_free(void *v) {
   assert(v);
-  free(v);
+  allocator_free(allocator_global(), v);
 }
 
 Vector vec_add(Vector v1, Vector v2) {
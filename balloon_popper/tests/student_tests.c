@@ -1,5 +1,12 @@
+#include "collision.h"
+#include "constraints.h"
 #include "forces.h"
+#include "game_loop.h"
+#include "soft_body.h"
 #include "test_util.h"
+#include "thread_pool.h"
+#include "utils.h"
+#include "vec.h"
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
@@ -148,6 +155,1488 @@ void test_zero_drag_no_slow_down() {
     scene_free(scene);
 }
 
+// Tests that handles keep referring to their body and go stale on removal
+void test_body_handles() {
+    Scene *scene = scene_init();
+    BodyHandle first = scene_spawn_body(scene, make_shape(), 1, \
+        (RGBColor) {0, 0, 0}, NULL, NULL);
+    BodyHandle second = scene_add_body(scene, \
+        body_init(make_shape(), 2, (RGBColor) {0, 0, 0}));
+    BodyHandle third = scene_spawn_body(scene, make_shape(), 3, \
+        (RGBColor) {0, 0, 0}, NULL, NULL);
+    assert(first != BODY_HANDLE_NULL && first != second && second != third);
+    assert(scene_get_body_by_handle(scene, BODY_HANDLE_NULL) == NULL);
+    assert(body_get_mass(scene_get_body_by_handle(scene, second)) == 2);
+
+    // Removing the first body shifts indices but not handles
+    body_remove(scene_get_body_by_handle(scene, first));
+    scene_tick(scene, 0);
+    assert(scene_get_body_by_handle(scene, first) == NULL);
+    assert(scene_get_body(scene, 0) == scene_get_body_by_handle(scene, second));
+    assert(body_get_mass(scene_get_body_by_handle(scene, third)) == 3);
+
+    // The freed slot is reused, but the old handle stays stale
+    BodyHandle fourth = scene_spawn_body(scene, make_shape(), 4, \
+        (RGBColor) {0, 0, 0}, NULL, NULL);
+    assert(fourth != first);
+    assert(scene_get_body_by_handle(scene, first) == NULL);
+    assert(body_get_mass(scene_get_body_by_handle(scene, fourth)) == 4);
+    assert(body_get_handle(scene_get_body_by_handle(scene, fourth)) == fourth);
+    scene_free(scene);
+}
+
+Scene *make_body_arrays_scene(bool use_arrays) {
+    Scene *scene = scene_init();
+    // Half the bodies are added before switching storage, half after
+    for (int i = 0; i < 6; i++) {
+        if (i == 3) {
+            scene_set_body_arrays(scene, use_arrays);
+        }
+        double mass = i == 0 ? INFINITY : i + 1;
+        BodyHandle handle = scene_spawn_body(scene, make_shape(), mass, \
+            (RGBColor) {0, 0, 0}, NULL, NULL);
+        Body *body = scene_get_body_by_handle(scene, handle);
+        body_set_centroid(body, (Vector) {10 * i, 5 * i * i});
+        body_set_velocity(body, (Vector) {i, -i});
+    }
+    create_newtonian_gravity(scene, 1e3, scene_get_body(scene, 1), \
+        scene_get_body(scene, 2));
+    create_spring(scene, 2, scene_get_body(scene, 0), scene_get_body(scene, 3));
+    create_drag(scene, 0.5, scene_get_body(scene, 4));
+    return scene;
+}
+
+void test_body_arrays_match_bodies() {
+    const double DT = 1e-3;
+    const int STEPS = 2000;
+    Scene *bodies = make_body_arrays_scene(false);
+    Scene *arrays = make_body_arrays_scene(true);
+    for (int i = 0; i < STEPS; i++) {
+        if (i == STEPS / 2) {
+            // Removing a body moves the last one into its array index
+            body_remove(scene_get_body(bodies, 2));
+            body_remove(scene_get_body(arrays, 2));
+        }
+        body_add_impulse(scene_get_body(bodies, 1), (Vector) {1e-3, 0});
+        body_add_impulse(scene_get_body(arrays, 1), (Vector) {1e-3, 0});
+        scene_tick(bodies, DT);
+        scene_tick(arrays, DT);
+        assert(scene_bodies(bodies) == scene_bodies(arrays));
+        for (size_t j = 0; j < scene_bodies(bodies); j++) {
+            Body *expected = scene_get_body(bodies, j);
+            Body *actual = scene_get_body(arrays, j);
+            assert(vec_equal(body_get_centroid(expected), \
+                body_get_centroid(actual)));
+            assert(vec_equal(body_get_velocity(expected), \
+                body_get_velocity(actual)));
+            Vector *expected_vertex = list_get(body_get_shape(expected), 0);
+            Vector *actual_vertex = list_get(body_get_shape(actual), 0);
+            assert(vec_equal(*expected_vertex, *actual_vertex));
+        }
+    }
+    // Switching back keeps the state the arrays held
+    Vector centroid = body_get_centroid(scene_get_body(arrays, 1));
+    scene_set_body_arrays(arrays, false);
+    assert(vec_equal(centroid, body_get_centroid(scene_get_body(arrays, 1))));
+    scene_free(bodies);
+    scene_free(arrays);
+}
+
+/** Fills a scene with a level built entirely in its arena */
+void build_arena_level(Scene *scene) {
+    Arena *arena = scene_get_arena(scene);
+    utils_set_shape_allocator(arena_allocator(arena));
+    BodyHandle anchor = scene_spawn_body(scene, get_rectangle(VEC_ZERO, 2, 2), \
+        INFINITY, (RGBColor) {0, 0, 0}, NULL, NULL);
+    for (int i = 0; i < 50; i++) {
+        Role *role = arena_alloc(arena, sizeof(Role));
+        *role = REMOVE_ON_COLLISION;
+        BodyHandle handle = scene_spawn_body(scene, \
+            get_bloon_points((Vector) {10 * i, 10}, 5, 6), 1, \
+            (RGBColor) {0, 0, 0}, role, arena_release);
+        Body *body = scene_get_body_by_handle(scene, handle);
+        create_spring(scene, 1, body, scene_get_body_by_handle(scene, anchor));
+        create_physics_collision(scene, 1, body, \
+            scene_get_body_by_handle(scene, anchor));
+    }
+    utils_set_shape_allocator(NULL);
+}
+
+void test_scene_reset() {
+    Scene *scene = scene_init();
+    build_arena_level(scene);
+    BodyHandle first = body_get_handle(scene_get_body(scene, 0));
+    // Bodies and forces with heap memory are freed individually
+    BodyHandle heap = scene_add_body(scene, \
+        body_init(make_shape(), 1, (RGBColor) {0, 0, 0}));
+    create_drag(scene, 1, scene_get_body_by_handle(scene, heap));
+    scene_tick(scene, 1e-3);
+
+    scene_reset(scene);
+    assert(scene_bodies(scene) == 0);
+    assert(scene_forces(scene) == 0);
+    assert(scene_get_body_by_handle(scene, first) == NULL);
+    assert(scene_get_body_by_handle(scene, heap) == NULL);
+
+    // Rebuilding the same level reuses the arena's memory
+    build_arena_level(scene);
+    size_t chunks = arena_chunks(scene_get_arena(scene));
+    for (int i = 0; i < 3; i++) {
+        scene_reset(scene);
+        build_arena_level(scene);
+        scene_tick(scene, 1e-3);
+    }
+    assert(arena_chunks(scene_get_arena(scene)) == chunks);
+    assert(scene_bodies(scene) == 51);
+    // 50 collisions, and one batch for all 50 springs
+    assert(scene_forces(scene) == 51);
+    BodyHandle rebuilt = body_get_handle(scene_get_body(scene, 0));
+    assert(rebuilt != first);
+    assert(scene_get_body_by_handle(scene, first) == NULL);
+    scene_free(scene);
+}
+
+void test_scene_spawn_many() {
+    const size_t COUNT = 20;
+    Scene *scene = scene_init();
+    ShapePrefab *prefab = prefab_init(get_rectangle((Vector) {5, 5}, 2, 4));
+    assert(vec_isclose(prefab_get_centroid(prefab), (Vector) {5, 5}));
+    Transform transforms[COUNT];
+    for (size_t i = 0; i < COUNT; i++) {
+        transforms[i] = (Transform) {(Vector) {10 * i, -3}, M_PI / 2};
+    }
+    BodyHandle handles[COUNT];
+    scene_spawn_many(scene, prefab, transforms, COUNT, 2, \
+        (RGBColor) {0, 0, 0}, handles);
+    assert(scene_bodies(scene) == COUNT);
+    for (size_t i = 0; i < COUNT; i++) {
+        Body *body = scene_get_body_by_handle(scene, handles[i]);
+        assert(body == scene_get_body(scene, i));
+        assert(vec_isclose(body_get_centroid(body), transforms[i].position));
+        assert(isclose(body_get_angle(body), M_PI / 2));
+        assert(isclose(body_get_mass(body), 2));
+        // The 2x4 rectangle is turned on its side
+        List *shape = body_get_shape(body);
+        assert(list_size(shape) == 4);
+        for (size_t j = 0; j < list_size(shape); j++) {
+            Vector offset = vec_subtract(*(Vector *) list_get(shape, j), \
+                transforms[i].position);
+            assert(isclose(fabs(offset.x), 2) && isclose(fabs(offset.y), 1));
+        }
+    }
+
+    // Spawning the same batch again after a reset reuses the arena
+    size_t chunks = arena_chunks(scene_get_arena(scene));
+    for (int i = 0; i < 3; i++) {
+        scene_reset(scene);
+        scene_spawn_many(scene, prefab, transforms, COUNT, 2, \
+            (RGBColor) {0, 0, 0}, NULL);
+        scene_tick(scene, 1e-3);
+    }
+    assert(arena_chunks(scene_get_arena(scene)) == chunks);
+    assert(scene_bodies(scene) == COUNT);
+    assert(scene_get_body_by_handle(scene, handles[0]) == NULL);
+    // The scene holds its own reference to the prefab until it is freed
+    prefab_release(prefab);
+    assert(prefab_size(prefab) == 4);
+    scene_free(scene);
+}
+
+/** Counts the blocks allocated through it that have not been freed */
+typedef struct {
+    size_t live_blocks;
+    size_t total_blocks;
+} AllocationCount;
+
+void *counting_alloc(void *context, size_t size) {
+    AllocationCount *count = context;
+    count->live_blocks++;
+    count->total_blocks++;
+    return malloc(size);
+}
+
+void *counting_realloc(void *context, void *block, size_t size) {
+    AllocationCount *count = context;
+    if (!block) {
+        count->live_blocks++;
+        count->total_blocks++;
+    }
+    return realloc(block, size);
+}
+
+void counting_free(void *context, void *block) {
+    AllocationCount *count = context;
+    if (block) {
+        count->live_blocks--;
+    }
+    free(block);
+}
+
+void test_allocator() {
+    AllocationCount count = {0, 0};
+    Allocator counting = {counting_alloc, counting_realloc, counting_free, \
+        &count};
+
+    // Installed globally, it is used for lists, vectors and bodies
+    allocator_set_global(&counting);
+    assert(allocator_global() == &counting);
+    Body *body = body_init(make_shape(), 1, (RGBColor) {0, 0, 0});
+    assert(count.live_blocks > 0);
+    List *list = list_init(0, vector_free);
+    for (int i = 0; i < 10; i++) {
+        list_add(list, create_vector_p((Vector) {i, i}));
+    }
+    size_t before = count.total_blocks;
+    list_remove(list, 0);
+    assert(list_size(list) == 9);
+    list_free(list);
+    body_free(body);
+    allocator_set_global(NULL);
+    assert(allocator_global() == allocator_heap());
+    assert(count.live_blocks == 0);
+    assert(count.total_blocks == before);
+
+    // Installed in a scene, it provides all of the scene's memory
+    Scene *scene = scene_init_with_allocator(&counting);
+    size_t scene_blocks = count.total_blocks;
+    build_arena_level(scene);
+    scene_set_body_arrays(scene, true);
+    scene_tick(scene, 1e-3);
+    assert(count.total_blocks > scene_blocks);
+    scene_free(scene);
+    assert(count.live_blocks == 0);
+
+    // Lists can own elements from their own allocator
+    list = list_init_with_allocator(&counting, 1, allocator_owned);
+    assert(list_get_allocator(list) == &counting);
+    for (int i = 0; i < 4; i++) {
+        Vector *v = allocator_alloc(&counting, sizeof(Vector));
+        *v = (Vector) {i, 0};
+        list_add(list, v);
+    }
+    list_set(list, 0, allocator_alloc(&counting, sizeof(Vector)));
+    list_free(list);
+    assert(count.live_blocks == 0);
+}
+
+DEFINE_VEC(Vector)
+
+void test_vec() {
+    VectorVec vec;
+    VectorVec_init(&vec, allocator_global());
+    VectorVec_reserve(&vec, 3);
+    assert(vec.capacity == 3);
+    for (int i = 0; i < 10; i++) {
+        VectorVec_push(&vec, (Vector) {i, -i});
+    }
+    assert(vec.size == 10);
+    assert(vec.capacity >= 10);
+    assert(vec_equal(VectorVec_get(&vec, 4), (Vector) {4, -4}));
+    VEC_AT(&vec, 4).x = 40;
+    assert(VectorVec_get(&vec, 4).x == 40);
+
+    // swap_remove moves the last element into the hole
+    Vector removed = VectorVec_swap_remove(&vec, 1);
+    assert(vec_equal(removed, (Vector) {1, -1}));
+    assert(vec_equal(VEC_AT(&vec, 1), (Vector) {9, -9}));
+    // remove keeps the order of the rest
+    removed = VectorVec_remove(&vec, 0);
+    assert(vec_equal(removed, (Vector) {0, 0}));
+    assert(vec_equal(VEC_AT(&vec, 0), (Vector) {9, -9}));
+    assert(vec_equal(VEC_AT(&vec, 1), (Vector) {2, -2}));
+    assert(vec_equal(VectorVec_pop(&vec), (Vector) {8, -8}));
+    assert(vec.size == 7);
+
+    double sum = 0;
+    VEC_FOREACH(Vector, v, &vec) {
+        sum += v->y;
+    }
+    assert(sum == -(9 + 2 + 3 + 4 + 5 + 6 + 7));
+
+    VectorVec_shrink(&vec);
+    assert(vec.capacity == 7);
+    VectorVec_clear(&vec);
+    assert(vec.size == 0);
+    VectorVec_shrink(&vec);
+    assert(vec.capacity == 0 && vec.data == NULL);
+    VectorVec_push(&vec, VEC_ZERO);
+    VectorVec_free(&vec);
+}
+
+void test_list_inline() {
+    AllocationCount count = {0, 0};
+    Allocator counting = {counting_alloc, counting_realloc, counting_free, \
+        &count};
+    int values[5] = {0, 1, 2, 3, 4};
+
+    // The header and the first items share one allocation
+    List *list = list_init_with_allocator(&counting, 2, NULL);
+    list_add(list, &values[0]);
+    list_add(list, &values[1]);
+    assert(count.live_blocks == 1);
+    // Growing past them spills the items into their own array
+    list_add(list, &values[2]);
+    assert(count.live_blocks == 2);
+    for (int i = 0; i < 3; i++) {
+        assert(list_get(list, i) == &values[i]);
+    }
+    list_free(list);
+    assert(count.live_blocks == 0);
+
+    // A list in caller memory does not allocate until it spills
+    void *memory = malloc(list_inline_size(2));
+    list = list_init_in(memory, &counting, 2, NULL);
+    list_add(list, &values[3]);
+    list_add(list, &values[4]);
+    assert(count.total_blocks == 2);
+    list_remove(list, 0);
+    assert(list_size(list) == 1 && list_get(list, 0) == &values[4]);
+    for (int i = 0; i < 5; i++) {
+        list_add(list, &values[i]);
+    }
+    assert(count.live_blocks == 1);
+    assert(list_get(list, 5) == &values[4]);
+    list_free(list);
+    assert(count.live_blocks == 0);
+    free(memory);
+}
+
+void test_body_integrate() {
+    const double DT = 1e-2;
+    // One body ticked the old way, by both tick functions
+    Body *expected = body_init(make_shape(), 2, (RGBColor) {0, 0, 0});
+    body_set_velocity(expected, (Vector) {1, 2});
+    // The same body in scenes that integrate it in one pass
+    Scene *scenes[2];
+    BodyHandle handles[2];
+    for (int k = 0; k < 2; k++) {
+        scenes[k] = scene_init();
+        scene_set_body_arrays(scenes[k], k == 1);
+        scene_set_default_motion(scenes[k], \
+            MOTION_FORCES | MOTION_ACCELERATION);
+        handles[k] = scene_add_body(scenes[k], \
+            body_init(make_shape(), 2, (RGBColor) {0, 0, 0}));
+        Body *body = scene_get_body_by_handle(scenes[k], handles[k]);
+        assert(body_get_motion(body) == (MOTION_FORCES | MOTION_ACCELERATION));
+        body_set_velocity(body, (Vector) {1, 2});
+    }
+    for (int i = 0; i < 100; i++) {
+        Vector force = {sin(i), cos(i)};
+        body_add_force(expected, force);
+        body_tick(expected, DT);
+        body_tick_no_forces(expected, DT);
+        for (int k = 0; k < 2; k++) {
+            Body *body = scene_get_body_by_handle(scenes[k], handles[k]);
+            body_add_force(body, force);
+            scene_tick(scenes[k], DT);
+            assert(vec_isclose(body_get_centroid(body), \
+                body_get_centroid(expected)));
+            assert(vec_isclose(body_get_velocity(body), \
+                body_get_velocity(expected)));
+            assert(vec_isclose(*(Vector *) list_get(body_get_shape(body), 0), \
+                *(Vector *) list_get(body_get_shape(expected), 0)));
+        }
+    }
+
+    // Bodies that only follow their acceleration ignore forces
+    for (int k = 0; k < 2; k++) {
+        Body *body = scene_get_body_by_handle(scenes[k], handles[k]);
+        body_set_motion(body, MOTION_ACCELERATION);
+        body_set_velocity(body, VEC_ZERO);
+        body_set_acceleration(body, (Vector) {0, -1});
+        Vector start = body_get_centroid(body);
+        body_add_force(body, (Vector) {100, 0});
+        scene_tick(scenes[k], 1);
+        assert(vec_isclose(body_get_centroid(body), \
+            vec_add(start, (Vector) {0, -0.5})));
+        assert(vec_isclose(body_get_velocity(body), (Vector) {0, -1}));
+        scene_free(scenes[k]);
+    }
+    body_free(expected);
+}
+
+double spring_energy(double k, Body *body1, Body *body2) {
+    double distance = vec_distance(body_get_centroid(body1), \
+        body_get_centroid(body2));
+    return k * distance * distance / 2 + \
+        kinetic_energy(body1) + kinetic_energy(body2);
+}
+
+void test_integrators() {
+    const double K = 3, DT = 1e-2;
+    const int STEPS = 1000;
+    // Each integrator's largest relative energy error over 10 s with a step
+    // 10000 times larger than test_energy_conservation_with_drag()'s
+    const Integrator INTEGRATORS[] = {
+        INTEGRATOR_SYMPLECTIC_EULER, INTEGRATOR_VELOCITY_VERLET, INTEGRATOR_RK4
+    };
+    const double TOLERANCES[] = {2e-2, 5e-4, 1e-8};
+    for (size_t k = 0; k < 3; k++) {
+        Scene *scene = scene_init();
+        scene_set_integrator(scene, INTEGRATORS[k]);
+        Body *mass1 = body_init(make_shape(), 1, (RGBColor) {0, 0, 0});
+        body_set_velocity(mass1, (Vector) {0, 1});
+        scene_add_body(scene, mass1);
+        Body *mass2 = body_init(make_shape(), 2, (RGBColor) {0, 0, 0});
+        body_set_centroid(mass2, (Vector) {10, 0});
+        body_set_velocity(mass2, (Vector) {0, -0.5});
+        scene_add_body(scene, mass2);
+        create_spring(scene, K, mass1, mass2);
+        double initial_energy = spring_energy(K, mass1, mass2);
+        for (int i = 0; i < STEPS; i++) {
+            scene_tick(scene, DT);
+            double energy = spring_energy(K, mass1, mass2);
+            assert(within(TOLERANCES[k], energy / initial_energy, 1));
+        }
+        scene_free(scene);
+    }
+
+    // Drag depends on velocity, so RK4 re-evaluates it at each stage
+    const double M = 2, GAMMA = 0.5, V = 3;
+    Scene *scene = scene_init();
+    scene_set_integrator(scene, INTEGRATOR_RK4);
+    Body *body = body_init(make_shape(), M, (RGBColor) {0, 0, 0});
+    body_set_velocity(body, (Vector) {V, 0});
+    scene_add_body(scene, body);
+    create_drag(scene, GAMMA, body);
+    for (int i = 0; i < 100; i++) {
+        scene_tick(scene, 0.1);
+    }
+    double expected = V * exp(-GAMMA / M * 10);
+    assert(within(1e-7, body_get_velocity(body).x, expected));
+    assert(within(1e-6, body_get_centroid(body).x, \
+        M / GAMMA * (V - expected)));
+    scene_free(scene);
+}
+
+void test_adaptive_step() {
+    const double K = 3, DT = 0.1;
+    const int TICKS = 100;
+    size_t steps[2];
+    const double TOLERANCES[] = {1e-6, 1e-9};
+    for (size_t k = 0; k < 2; k++) {
+        Scene *scene = scene_init();
+        scene_set_integrator(scene, INTEGRATOR_ADAPTIVE);
+        scene_set_tolerance(scene, TOLERANCES[k]);
+        Body *mass1 = body_init(make_shape(), 1, (RGBColor) {0, 0, 0});
+        body_set_velocity(mass1, (Vector) {0, 1});
+        scene_add_body(scene, mass1);
+        Body *mass2 = body_init(make_shape(), 2, (RGBColor) {0, 0, 0});
+        body_set_centroid(mass2, (Vector) {10, 0});
+        body_set_velocity(mass2, (Vector) {0, -0.5});
+        scene_add_body(scene, mass2);
+        create_spring(scene, K, mass1, mass2);
+        double initial_energy = spring_energy(K, mass1, mass2);
+        for (int i = 0; i < TICKS; i++) {
+            scene_tick(scene, DT);
+            double energy = spring_energy(K, mass1, mass2);
+            assert(within(1e3 * TOLERANCES[k], energy / initial_energy, 1));
+        }
+        // Ticks are split into substeps as needed, and never merged
+        steps[k] = scene_steps_taken(scene);
+        assert(steps[k] >= TICKS);
+        // The first tick tries a whole tick, which is far too long
+        assert(scene_steps_rejected(scene) > 0);
+        scene_free(scene);
+    }
+    // A tighter tolerance takes more steps
+    assert(steps[1] > steps[0]);
+}
+
+void test_substeps() {
+    // A body crossing a thin wall within one tick only hits it in substeps
+    const double SPEED = 1000, DT = 0.05;
+    for (int substep = 0; substep < 2; substep++) {
+        Scene *scene = scene_init();
+        Body *wall = body_init(get_rectangle(VEC_ZERO, 0.5, 100), INFINITY, \
+            (RGBColor) {0, 0, 0});
+        scene_add_body(scene, wall);
+        Body *bullet = body_init(get_rectangle((Vector) {-10.1, 0}, 1, 1), 1, \
+            (RGBColor) {0, 0, 0});
+        body_set_velocity(bullet, (Vector) {SPEED, 0});
+        if (substep) {
+            body_set_max_displacement(bullet, 0.25);
+            assert(body_get_motion(bullet) & MOTION_SUBSTEP);
+        }
+        scene_add_body(scene, bullet);
+        // Adding the body does not clear the flag
+        assert(!substep || (body_get_motion(bullet) & MOTION_SUBSTEP));
+        create_physics_collision(scene, 1, bullet, wall);
+        scene_tick(scene, DT);
+        Vector velocity = body_get_velocity(bullet);
+        if (substep) {
+            assert(vec_isclose(velocity, (Vector) {-SPEED, 0}));
+            assert(body_get_centroid(bullet).x < 0);
+        } else {
+            assert(vec_isclose(velocity, (Vector) {SPEED, 0}));
+            assert(body_get_centroid(bullet).x > 0);
+        }
+        // The wall took one step and did not move
+        assert(vec_isclose(body_get_centroid(wall), VEC_ZERO));
+        scene_free(scene);
+    }
+
+    Body *body = body_init(make_shape(), 1, (RGBColor) {0, 0, 0});
+    body_set_max_displacement(body, 1);
+    body_set_motion(body, MOTION_ACCELERATION);
+    assert(body_get_motion(body) == (MOTION_ACCELERATION | MOTION_SUBSTEP));
+    body_set_max_displacement(body, INFINITY);
+    assert(body_get_motion(body) == MOTION_ACCELERATION);
+    body_free(body);
+}
+
+void count_collisions(Body *body1, Body *body2, Vector axis, void *aux) {
+    (*(size_t *) aux)++;
+}
+
+void test_body_types() {
+    const double DT = 0.1;
+    Scene *scene = scene_init();
+    // A static body never moves, whatever acts on it
+    Body *wall = body_init(get_rectangle((Vector) {10, 0}, 1, 100), 1, \
+        (RGBColor) {0, 0, 0});
+    body_set_velocity(wall, (Vector) {1, 0});
+    body_set_type(wall, BODY_STATIC);
+    assert(body_get_type(wall) == BODY_STATIC);
+    assert(vec_isclose(body_get_velocity(wall), VEC_ZERO));
+    body_set_acceleration(wall, (Vector) {0, -10});
+    scene_add_body(scene, wall);
+    Body *other_wall = body_init(get_rectangle((Vector) {10, 0}, 1, 1), \
+        INFINITY, (RGBColor) {0, 0, 0});
+    body_set_type(other_wall, BODY_STATIC);
+    scene_add_body(scene, other_wall);
+    // A kinematic body follows its velocity and ignores forces
+    Body *paddle = body_init(get_rectangle((Vector) {-10, 0}, 1, 1), 1, \
+        (RGBColor) {0, 0, 0});
+    body_set_type(paddle, BODY_KINEMATIC);
+    body_set_velocity(paddle, (Vector) {5, 0});
+    scene_add_body(scene, paddle);
+    Body *ball = body_init(get_rectangle((Vector) {-5, 0}, 1, 1), 1, \
+        (RGBColor) {0, 0, 0});
+    scene_add_body(scene, ball);
+    size_t collisions = 0;
+    create_collision(scene, wall, other_wall, count_collisions, &collisions, \
+        NULL);
+    create_physics_collision(scene, 1, paddle, ball);
+    for (int i = 0; i < 10; i++) {
+        body_add_force(wall, (Vector) {100, 100});
+        body_add_force(paddle, (Vector) {0, 100});
+        scene_tick(scene, DT);
+        assert(vec_isclose(body_get_centroid(wall), (Vector) {10, 0}));
+        assert(body_get_centroid(paddle).y == 0);
+    }
+    assert(isclose(body_get_centroid(paddle).x, -5));
+    // The paddle hit the ball as if it were infinitely massive
+    assert(vec_isclose(body_get_velocity(paddle), (Vector) {5, 0}));
+    assert(vec_isclose(body_get_velocity(ball), (Vector) {10, 0}));
+    // Overlapping static bodies are never checked against each other
+    assert(collisions == 0);
+    scene_free(scene);
+}
+
+void test_sleeping() {
+    const double DT = 0.1;
+    for (int arrays = 0; arrays < 2; arrays++) {
+        Scene *scene = scene_init();
+        scene_set_body_arrays(scene, arrays);
+        scene_set_sleeping(scene, 0.5, 3);
+        Body *wall = body_init(get_rectangle((Vector) {10, 0}, 1, 1), \
+            INFINITY, (RGBColor) {0, 0, 0});
+        body_set_type(wall, BODY_STATIC);
+        scene_add_body(scene, wall);
+        Body *resting = body_init(get_rectangle((Vector) {10, 0}, 1, 1), 1, \
+            (RGBColor) {0, 0, 0});
+        body_set_velocity(resting, (Vector) {0.25, 0});
+        scene_add_body(scene, resting);
+        Body *ball = body_init(get_rectangle((Vector) {-10, 0}, 1, 1), 1, \
+            (RGBColor) {0, 0, 0});
+        scene_add_body(scene, ball);
+        size_t collisions = 0;
+        create_collision(scene, resting, wall, count_collisions, \
+            &collisions, NULL);
+        create_physics_collision(scene, 1, ball, resting);
+        // Slow bodies sleep after 3 ticks at rest; static ones never do
+        for (int i = 0; i < 2; i++) {
+            scene_tick(scene, DT);
+        }
+        assert(scene_sleeping_bodies(scene) == 0);
+        assert(scene_awake_bodies(scene) == 2);
+        scene_tick(scene, DT);
+        assert(body_is_sleeping(resting) && body_is_sleeping(ball));
+        assert(!body_is_sleeping(wall));
+        assert(scene_sleeping_bodies(scene) == 2);
+        assert(scene_awake_bodies(scene) == 0);
+        assert(vec_isclose(body_get_velocity(resting), VEC_ZERO));
+        // Sleeping bodies ignore added forces, and the collision between
+        // the sleeping body and the static one stops being checked
+        collisions = 0;
+        Vector position = body_get_centroid(resting);
+        for (int i = 0; i < 5; i++) {
+            body_add_force(resting, (Vector) {100, 100});
+            scene_tick(scene, DT);
+        }
+        assert(vec_equal(body_get_centroid(resting), position));
+        assert(body_is_sleeping(resting));
+        assert(collisions == 0);
+        // Setting a velocity wakes a body, and it wakes what it hits
+        body_set_velocity(ball, (Vector) {100, 0});
+        assert(!body_is_sleeping(ball));
+        for (int i = 0; i < 4 && body_is_sleeping(resting); i++) {
+            scene_tick(scene, DT);
+        }
+        assert(!body_is_sleeping(resting));
+        assert(body_get_velocity(resting).x > 0);
+        assert(scene_awake_bodies(scene) == 2);
+        scene_free(scene);
+    }
+}
+
+void count_iterations(void *aux, size_t start, size_t end, size_t thread) {
+    size_t *visits = aux;
+    // Each thread counts into its own slot of the first 4
+    assert(thread < 4);
+    for (size_t i = start; i < end; i++) {
+        visits[4 + i]++;
+    }
+    visits[thread] += end - start;
+}
+
+void test_thread_pool() {
+    const size_t N = 1000;
+    size_t *visits = malloc((4 + N) * sizeof(size_t));
+    ThreadPool *pools[] = {NULL, thread_pool_init(1), thread_pool_init(4)};
+    for (size_t p = 0; p < 3; p++) {
+        for (size_t round = 0; round < 10; round++) {
+            for (size_t i = 0; i < 4 + N; i++) {
+                visits[i] = 0;
+            }
+            thread_pool_for(pools[p], N, 7, count_iterations, visits);
+            for (size_t i = 0; i < N; i++) {
+                assert(visits[4 + i] == 1);
+            }
+            assert(visits[0] + visits[1] + visits[2] + visits[3] == N);
+        }
+        if (pools[p]) {
+            thread_pool_free(pools[p]);
+        }
+    }
+    free(visits);
+}
+
+/**
+ * Builds a scene of n moving bodies,
+ * pulled around by springs and slowed by drag if forces is set
+ */
+Scene *make_parallel_scene(size_t n, bool arrays, bool forces, size_t threads) {
+    Scene *scene = scene_init();
+    scene_set_body_arrays(scene, arrays);
+    scene_set_threads(scene, threads);
+    for (size_t i = 0; i < n; i++) {
+        Body *body = body_init(get_rectangle((Vector) {i % 50, i / 50}, 1, 1), \
+            1 + i % 3, (RGBColor) {0, 0, 0});
+        body_set_velocity(body, (Vector) {sin(i), cos(i)});
+        if (i % 5 == 0) {
+            body_set_motion(body, MOTION_FORCES | MOTION_ACCELERATION);
+            body_set_acceleration(body, (Vector) {0, -1});
+        }
+        scene_add_body(scene, body);
+        if (forces) {
+            create_drag(scene, 0.1, body);
+            if (i > 0) {
+                create_spring(scene, 0.5, scene_get_body(scene, i - 1), body);
+            }
+        }
+    }
+    return scene;
+}
+
+/** Ticks two scenes with the same bodies and checks they end up identical */
+void check_same_ticks(Scene *scene1, Scene *scene2) {
+    for (int i = 0; i < 10; i++) {
+        // Forces added outside the force creators are kept too
+        body_add_force(scene_get_body(scene1, i), (Vector) {i, 1});
+        body_add_force(scene_get_body(scene2, i), (Vector) {i, 1});
+        scene_tick(scene1, 0.01);
+        scene_tick(scene2, 0.01);
+    }
+    // The results are identical, not just close
+    for (size_t i = 0; i < scene_bodies(scene1); i++) {
+        Body *body1 = scene_get_body(scene1, i);
+        Body *body2 = scene_get_body(scene2, i);
+        assert(vec_equal(body_get_centroid(body1), body_get_centroid(body2)));
+        assert(vec_equal(body_get_velocity(body1), body_get_velocity(body2)));
+        Vector *vertex1 = list_get(body_get_shape(body1), 0);
+        Vector *vertex2 = list_get(body_get_shape(body2), 0);
+        assert(vec_equal(*vertex1, *vertex2));
+    }
+}
+
+void test_parallel_tick() {
+    // Enough bodies to be split between the threads
+    const size_t N = 3000;
+    for (int arrays = 0; arrays < 2; arrays++) {
+        // Integrating in parallel gives the same bits as one thread
+        Scene *serial = make_parallel_scene(N, arrays, false, 1);
+        Scene *parallel = make_parallel_scene(N, arrays, false, 4);
+        assert(scene_get_threads(serial) == 1);
+        assert(scene_get_threads(parallel) == 4);
+        check_same_ticks(serial, parallel);
+        scene_free(serial);
+        scene_free(parallel);
+
+        // Forces summed from per-thread buffers give the same bits
+        // every time with the same thread count
+        Scene *parallel1 = make_parallel_scene(N, arrays, true, 4);
+        Scene *parallel2 = make_parallel_scene(N, arrays, true, 4);
+        check_same_ticks(parallel1, parallel2);
+        // and stay close to the serial result
+        serial = make_parallel_scene(N, arrays, true, 1);
+        for (int i = 0; i < 10; i++) {
+            body_add_force(scene_get_body(serial, i), (Vector) {i, 1});
+            scene_tick(serial, 0.01);
+        }
+        for (size_t i = 0; i < N; i++) {
+            assert(vec_within(1e-9, body_get_centroid(scene_get_body(serial, i)), \
+                body_get_centroid(scene_get_body(parallel1, i))));
+        }
+        scene_free(serial);
+        scene_free(parallel1);
+        scene_free(parallel2);
+    }
+}
+
+void test_force_batches() {
+    const double K = 2, G = 3, GAMMA = 0.5, DT = 0.01;
+    Scene *scene = scene_init();
+    Body *bodies[4];
+    for (size_t i = 0; i < 4; i++) {
+        bodies[i] = body_init(get_rectangle((Vector) {10 * i, 0}, 1, 1), \
+            1 + i, (RGBColor) {0, 0, 0});
+        scene_add_body(scene, bodies[i]);
+    }
+    create_spring(scene, K, bodies[0], bodies[1]);
+    create_spring(scene, K, bodies[1], bodies[2]);
+    create_newtonian_gravity(scene, G, bodies[0], bodies[3]);
+    create_newtonian_gravity(scene, G, bodies[2], bodies[3]);
+    create_drag(scene, GAMMA, bodies[3]);
+    // One batch per kind
+    assert(scene_forces(scene) == 3);
+    body_set_velocity(bodies[3], (Vector) {0, 4});
+    scene_tick(scene, DT);
+    // F = kx, F = G m1 m2 / r^2 and F = -gamma v, over one tick
+    double gravity0 = G * 1 * 4 / (30 * 30);
+    double gravity2 = G * 3 * 4 / (10 * 10);
+    assert(vec_isclose(body_get_velocity(bodies[0]), \
+        (Vector) {(K * 10 + gravity0) * DT, 0}));
+    assert(vec_isclose(body_get_velocity(bodies[1]), VEC_ZERO));
+    assert(vec_isclose(body_get_velocity(bodies[2]), \
+        (Vector) {(-K * 10 + gravity2) * DT / 3, 0}));
+    assert(vec_isclose(body_get_velocity(bodies[3]), \
+        (Vector) {-(gravity0 + gravity2) * DT / 4, 4 - GAMMA * 4 * DT / 4}));
+
+    // Removing a body drops only the terms on it, from the next tick on
+    body_remove(bodies[1]);
+    scene_tick(scene, DT);
+    assert(scene_forces(scene) == 3);
+    body_set_velocity(bodies[0], VEC_ZERO);
+    double distance = body_get_centroid(bodies[3]).x \
+        - body_get_centroid(bodies[0]).x;
+    scene_tick(scene, DT);
+    assert(isclose(body_get_velocity(bodies[0]).x, \
+        G * 4 / (distance * distance) * DT));
+    scene_free(scene);
+
+    // Batches fill up, so a large scene has several to spread over threads
+    scene = scene_init();
+    Body *anchor = body_init(make_shape(), INFINITY, (RGBColor) {0, 0, 0});
+    scene_add_body(scene, anchor);
+    for (size_t i = 0; i < 5000; i++) {
+        Body *body = body_init(make_shape(), 1, (RGBColor) {0, 0, 0});
+        scene_add_body(scene, body);
+        create_spring(scene, K, anchor, body);
+    }
+    assert(scene_forces(scene) == 2);
+    scene_tick(scene, DT);
+    scene_free(scene);
+}
+
+void test_nbody_gravity() {
+    const double G = 3, SOFTENING = 0.5, DT = 0.01;
+    // Not a multiple of the kernel's lanes, so its padding is exercised too
+    const size_t N = 7;
+    Scene *scene = scene_init();
+    List *bodies = list_init(N, NULL);
+    for (size_t i = 0; i < N; i++) {
+        Vector center = {pseudo_rand_decimal(-10, 10), \
+            pseudo_rand_decimal(-10, 10)};
+        Body *body = body_init(get_rectangle(center, 1, 1), 1 + i, \
+            (RGBColor) {0, 0, 0});
+        scene_add_body(scene, body);
+        list_add(bodies, body);
+    }
+    create_nbody_gravity(scene, G, bodies, SOFTENING);
+    list_free(bodies);
+    assert(scene_forces(scene) == 1);
+
+    // F = G m1 m2 r / (|r|^2 + softening^2)^(3/2), summed over the pairs
+    Vector expected[N];
+    for (size_t i = 0; i < N; i++) {
+        Body *body = scene_get_body(scene, i);
+        expected[i] = VEC_ZERO;
+        for (size_t j = 0; j < N; j++) {
+            Body *other = scene_get_body(scene, j);
+            if (j == i) {
+                continue;
+            }
+            Vector r = vec_subtract(body_get_centroid(other), \
+                body_get_centroid(body));
+            double r2 = vec_dot(r, r) + SOFTENING * SOFTENING;
+            double scale = G * body_get_mass(body) * body_get_mass(other) \
+                / (r2 * sqrt(r2));
+            expected[i] = vec_add(expected[i], vec_multiply(scale, r));
+        }
+    }
+    scene_tick(scene, DT);
+    Vector momentum = VEC_ZERO;
+    for (size_t i = 0; i < N; i++) {
+        Body *body = scene_get_body(scene, i);
+        assert(vec_isclose(body_get_velocity(body), \
+            vec_multiply(DT / body_get_mass(body), expected[i])));
+        momentum = vec_add(momentum, \
+            vec_multiply(body_get_mass(body), body_get_velocity(body)));
+    }
+    // Every pull has an equal and opposite one
+    assert(fabs(momentum.x) < 1e-9 && fabs(momentum.y) < 1e-9);
+    scene_free(scene);
+
+    // Softening keeps the force finite as bodies meet, and a removed body
+    // stops pulling from the tick after
+    scene = scene_init();
+    bodies = list_init(3, NULL);
+    for (size_t i = 0; i < 3; i++) {
+        Body *body = body_init(make_shape(), 1, (RGBColor) {0, 0, 0});
+        scene_add_body(scene, body);
+        list_add(bodies, body);
+    }
+    Body *moved = list_get(bodies, 2);
+    body_set_centroid(moved, (Vector) {1, 0});
+    create_nbody_gravity(scene, 1, bodies, 0.75);
+    scene_tick(scene, DT);
+    Body *first = list_get(bodies, 0);
+    Body *second = list_get(bodies, 1);
+    assert(vec_isclose(body_get_velocity(first), body_get_velocity(second)));
+    body_remove(moved);
+    scene_tick(scene, DT);
+    body_set_velocity(first, VEC_ZERO);
+    scene_tick(scene, DT);
+    assert(vec_isclose(body_get_velocity(first), VEC_ZERO));
+    list_free(bodies);
+    scene_free(scene);
+}
+
+/**
+ * Makes a scene of stars like grav_demo's, at random points of a 1000 by 500
+ * screen with masses from 2 to 10, and adds them to a list.
+ * The same seed always gives the same stars.
+ */
+Scene *make_star_scene(size_t n, unsigned seed, List *stars) {
+    srand(seed);
+    Scene *scene = scene_init();
+    for (size_t i = 0; i < n; i++) {
+        int radius = pseudo_rand_int(2, 10);
+        Vector center = rand_center((Vector) {1000, 500});
+        Body *star = body_init(get_star_points(4, radius, center), radius, \
+            (RGBColor) {0, 0, 0});
+        scene_add_body(scene, star);
+        list_add(stars, star);
+    }
+    return scene;
+}
+
+/**
+ * Gets the relative root-mean-square difference between the velocities of
+ * two scenes' bodies
+ */
+double velocity_error(Scene *scene, Scene *exact) {
+    double error = 0, total = 0;
+    for (size_t i = 0; i < scene_bodies(exact); i++) {
+        Vector velocity = body_get_velocity(scene_get_body(exact, i));
+        Vector difference = vec_subtract(velocity, \
+            body_get_velocity(scene_get_body(scene, i)));
+        error += vec_dot(difference, difference);
+        total += vec_dot(velocity, velocity);
+    }
+    return sqrt(error / total);
+}
+
+void test_barnes_hut_gravity() {
+    const double G = 10, SOFTENING = 6, DT = 0.01;
+    const size_t N = 50;
+    const unsigned SEED = 3;
+    // Checked against the exact forces on grav_demo's stars
+    List *stars = list_init(N, NULL);
+    Scene *exact = make_star_scene(N, SEED, stars);
+    create_nbody_gravity(exact, G, stars, SOFTENING);
+    list_free(stars);
+    scene_tick(exact, DT);
+    const double THETAS[] = {1, 0.5, 0.3, 0};
+    const double TOLERANCES[] = {2e-2, 2e-3, 3e-4, 1e-9};
+    for (size_t t = 0; t < sizeof(THETAS) / sizeof(THETAS[0]); t++) {
+        stars = list_init(N, NULL);
+        Scene *scene = make_star_scene(N, SEED, stars);
+        create_barnes_hut_gravity(scene, G, stars, SOFTENING, THETAS[t]);
+        list_free(stars);
+        assert(scene_forces(scene) == 1);
+        scene_tick(scene, DT);
+        assert(velocity_error(scene, exact) < TOLERANCES[t]);
+        if (THETAS[t] > 0) {
+            scene_free(scene);
+            continue;
+        }
+        // Removed stars stop pulling from the tick after, in both
+        body_remove(scene_get_body(scene, 7));
+        body_remove(scene_get_body(exact, 7));
+        for (size_t i = 0; i < 2; i++) {
+            scene_tick(scene, DT);
+            scene_tick(exact, DT);
+        }
+        assert(velocity_error(scene, exact) < 1e-9);
+        scene_free(scene);
+    }
+    scene_free(exact);
+
+    // Each body's force is summed on one thread, so the thread count does
+    // not change the results at all
+    const size_t LARGE_N = 3000;
+    Scene *scenes[2];
+    for (size_t s = 0; s < 2; s++) {
+        stars = list_init(LARGE_N, NULL);
+        scenes[s] = make_star_scene(LARGE_N, SEED, stars);
+        scene_set_threads(scenes[s], s == 0 ? 1 : 4);
+        create_barnes_hut_gravity(scenes[s], G, stars, SOFTENING, 0.5);
+        list_free(stars);
+        for (size_t i = 0; i < 3; i++) {
+            scene_tick(scenes[s], DT);
+        }
+    }
+    for (size_t i = 0; i < LARGE_N; i++) {
+        Body *serial = scene_get_body(scenes[0], i);
+        Body *parallel = scene_get_body(scenes[1], i);
+        assert(vec_equal(body_get_velocity(serial), \
+            body_get_velocity(parallel)));
+    }
+    scene_free(scenes[0]);
+    scene_free(scenes[1]);
+}
+
+void test_uniform_gravity() {
+    const Vector GRAVITY = {0, -10};
+    const double DT = 0.01;
+    const int STEPS = 100;
+    const Integrator INTEGRATORS[] = {
+        INTEGRATOR_AVERAGE_VELOCITY, INTEGRATOR_AVERAGE_VELOCITY, \
+        INTEGRATOR_AVERAGE_VELOCITY, INTEGRATOR_RK4
+    };
+    for (int k = 0; k < 4; k++) {
+        // Bodies, arrays, arrays on a thread pool, and RK4
+        Scene *scene = scene_init();
+        scene_set_body_arrays(scene, k >= 1 && k <= 2);
+        scene_set_threads(scene, k == 2 ? 4 : 1);
+        scene_set_integrator(scene, INTEGRATORS[k]);
+        assert(vec_equal(scene_get_gravity(scene), VEC_ZERO));
+        scene_set_gravity(scene, GRAVITY);
+        assert(vec_equal(scene_get_gravity(scene), GRAVITY));
+        Body *bodies[7];
+        for (int i = 0; i < 7; i++) {
+            bodies[i] = body_init(get_rectangle((Vector) {10 * i, 0}, 1, 1), \
+                i == 6 ? INFINITY : i + 1, (RGBColor) {0, 0, 0});
+            scene_add_body(scene, bodies[i]);
+        }
+        assert(body_get_gravity_scale(bodies[0]) == 1);
+        // Every body falls at the same rate whatever its mass
+        body_set_velocity(bodies[1], (Vector) {1, 0});
+        body_set_gravity_scale(bodies[2], 0);
+        body_set_gravity_scale(bodies[3], 2);
+        body_set_type(bodies[4], BODY_STATIC);
+        body_set_type(bodies[5], BODY_KINEMATIC);
+        body_set_velocity(bodies[5], (Vector) {0, 1});
+        // Substeps feel the field too
+        body_set_max_displacement(bodies[0], 0.02);
+        for (int i = 0; i < STEPS; i++) {
+            scene_tick(scene, DT);
+        }
+        // No force creators are needed
+        assert(scene_forces(scene) == 0);
+        double t = DT * STEPS;
+        Vector fall = vec_multiply(t * t / 2, GRAVITY);
+        assert(vec_within(1e-9, body_get_velocity(bodies[0]), \
+            vec_multiply(t, GRAVITY)));
+        assert(vec_within(1e-9, body_get_centroid(bodies[0]), fall));
+        assert(vec_within(1e-9, body_get_centroid(bodies[1]), \
+            vec_add((Vector) {10 + t, 0}, fall)));
+        assert(vec_within(1e-9, body_get_centroid(bodies[2]), \
+            (Vector) {20, 0}));
+        assert(vec_within(1e-9, body_get_centroid(bodies[3]), \
+            vec_add((Vector) {30, 0}, vec_multiply(2, fall))));
+        assert(vec_within(1e-9, body_get_centroid(bodies[4]), \
+            (Vector) {40, 0}));
+        assert(vec_within(1e-9, body_get_centroid(bodies[5]), \
+            (Vector) {50, t}));
+        assert(vec_within(1e-9, body_get_centroid(bodies[6]), \
+            (Vector) {60, 0}));
+        scene_free(scene);
+    }
+}
+
+/**
+ * Makes a scene with a chain of n bodies of mass 1 joined by springs of
+ * constant k, each moving with a random velocity, and drag gamma on each.
+ * The springs and drag are in a spring network if implicit is set.
+ */
+Scene *make_chain_scene(
+    size_t n, double k, double gamma, bool implicit, size_t threads
+) {
+    Scene *scene = scene_init();
+    scene_set_threads(scene, threads);
+    srand(7);
+    for (size_t i = 0; i < n; i++) {
+        BodyHandle handle = scene_spawn_body(scene, \
+            get_rectangle((Vector) {i, 0}, 0.5, 0.5), 1, \
+            (RGBColor) {0, 0, 0}, NULL, NULL);
+        body_set_velocity(scene_get_body_by_handle(scene, handle), \
+            (Vector) {pseudo_rand_decimal(-1, 1), pseudo_rand_decimal(-1, 1)});
+    }
+    SpringNetwork *network = implicit ? create_spring_network(scene) : NULL;
+    for (size_t i = 0; i < n; i++) {
+        Body *body = scene_get_body(scene, i);
+        if (implicit) {
+            if (i > 0) {
+                spring_network_add_spring(network, k, \
+                    scene_get_body(scene, i - 1), body);
+            }
+            spring_network_add_drag(network, gamma, body);
+        } else {
+            if (i > 0) {
+                create_spring(scene, k, scene_get_body(scene, i - 1), body);
+            }
+            create_drag(scene, gamma, body);
+        }
+    }
+    return scene;
+}
+
+/** The kinetic energy of a chain scene, plus its springs' potential energy */
+double chain_energy(Scene *scene, double k) {
+    double energy = 0;
+    for (size_t i = 0; i < scene_bodies(scene); i++) {
+        Body *body = scene_get_body(scene, i);
+        energy += kinetic_energy(body);
+        if (i > 0) {
+            double stretch = vec_distance(body_get_centroid(body), \
+                body_get_centroid(scene_get_body(scene, i - 1)));
+            energy += k * stretch * stretch / 2;
+        }
+    }
+    return energy;
+}
+
+void test_spring_network() {
+    // With small steps, the network matches the explicit springs and drag
+    Scene *explicit = make_chain_scene(10, 5, 0.5, false, 1);
+    Scene *implicit = make_chain_scene(10, 5, 0.5, true, 1);
+    assert(scene_forces(implicit) == 1);
+    for (int i = 0; i < 10000; i++) {
+        scene_tick(explicit, 1e-4);
+        scene_tick(implicit, 1e-4);
+    }
+    for (size_t i = 0; i < 10; i++) {
+        Body *expected = scene_get_body(explicit, i);
+        Body *actual = scene_get_body(implicit, i);
+        assert(vec_within(1e-3, body_get_centroid(expected), \
+            body_get_centroid(actual)));
+    }
+    scene_free(explicit);
+    scene_free(implicit);
+
+    // Stiff springs blow up explicitly with a step they are stable at
+    const double K = 1e4, DT = 0.05;
+    explicit = make_chain_scene(100, K, 0, false, 1);
+    implicit = make_chain_scene(100, K, 0, true, 1);
+    double initial = chain_energy(implicit, K);
+    double last_energy = initial;
+    for (int i = 0; i < 100; i++) {
+        scene_tick(explicit, DT);
+        scene_tick(implicit, DT);
+        // Backward Euler only ever takes energy out of undamped springs
+        double energy = chain_energy(implicit, K);
+        assert(energy <= last_energy);
+        last_energy = energy;
+    }
+    assert(!(chain_energy(explicit, K) < 1e6 * initial));
+    scene_free(explicit);
+    scene_free(implicit);
+
+    // A chain hung from a static body settles where each spring holds up
+    // the bodies below it, even with a large step
+    const size_t N = 10;
+    const double G = 10;
+    Scene *scene = scene_init();
+    scene_set_gravity(scene, (Vector) {0, -G});
+    SpringNetwork *network = create_spring_network(scene);
+    Body *previous = NULL;
+    for (size_t i = 0; i <= N; i++) {
+        Body *body = body_init(get_rectangle((Vector) {i, 0}, 0.5, 0.5), \
+            i == 0 ? INFINITY : 1, (RGBColor) {0, 0, 0});
+        scene_add_body(scene, body);
+        if (i == 0) {
+            body_set_type(body, BODY_STATIC);
+        } else {
+            spring_network_add_spring(network, 100, previous, body);
+            spring_network_add_drag(network, 1, body);
+        }
+        previous = body;
+    }
+    for (int i = 0; i < 1000; i++) {
+        scene_tick(scene, 0.1);
+    }
+    double y = 0;
+    for (size_t i = 1; i <= N; i++) {
+        y -= (N - i + 1) * G / 100;
+        assert(vec_within(1e-6, body_get_centroid(scene_get_body(scene, i)), \
+            (Vector) {0, y}));
+    }
+    // Removing a body drops its springs, and the rest of the chain falls
+    body_remove(scene_get_body(scene, N / 2));
+    for (int i = 0; i < 10; i++) {
+        scene_tick(scene, 0.1);
+    }
+    assert(scene_bodies(scene) == N);
+    assert(body_get_centroid(scene_get_body(scene, 1)).y > -G / 100 * N);
+    assert(body_get_velocity(scene_get_body(scene, N - 1)).y < -1);
+    scene_free(scene);
+
+    // Solving on several threads gives the same bits as one
+    Scene *serial = make_chain_scene(1000, K, 1, true, 1);
+    Scene *parallel = make_chain_scene(1000, K, 1, true, 4);
+    for (int i = 0; i < 10; i++) {
+        scene_tick(serial, DT);
+        scene_tick(parallel, DT);
+    }
+    for (size_t i = 0; i < 1000; i++) {
+        assert(vec_equal(body_get_centroid(scene_get_body(serial, i)), \
+            body_get_centroid(scene_get_body(parallel, i))));
+    }
+    scene_free(serial);
+    scene_free(parallel);
+}
+
+/** Adds a small square of a given mass to a scene, at rest at a point */
+Body *add_constrained_body(Scene *scene, Vector centroid, double mass) {
+    BodyHandle handle = scene_spawn_body(scene, \
+        get_rectangle(centroid, 0.1, 0.1), mass, (RGBColor) {0, 0, 0}, \
+        NULL, NULL);
+    return scene_get_body_by_handle(scene, handle);
+}
+
+/**
+ * Makes a scene with a chain of n bodies hanging from a static one at the
+ * origin, each joined to the last by a distance constraint of length 1
+ */
+Scene *make_constrained_chain(size_t n, size_t iterations) {
+    Scene *scene = scene_init();
+    scene_set_gravity(scene, (Vector) {0, -10});
+    Body *previous = add_constrained_body(scene, VEC_ZERO, 1);
+    body_set_type(previous, BODY_STATIC);
+    for (size_t i = 1; i <= n; i++) {
+        Body *body = add_constrained_body(scene, (Vector) {i, 0}, 1);
+        create_distance_constraint(scene, previous, body, 1);
+        previous = body;
+    }
+    constraints_set_iterations(scene, iterations);
+    return scene;
+}
+
+/** The most any link of a chain scene is stretched or squashed */
+double chain_error(Scene *scene) {
+    double error = 0;
+    for (size_t i = 1; i < scene_bodies(scene); i++) {
+        double distance = vec_distance( \
+            body_get_centroid(scene_get_body(scene, i - 1)), \
+            body_get_centroid(scene_get_body(scene, i)));
+        error = fmax(error, fabs(distance - 1));
+    }
+    return error;
+}
+
+void test_constraints() {
+    const double DT = 1.0 / 60;
+    // A rod keeps its length and the bodies' momentum
+    Scene *scene = scene_init();
+    assert(constraints_get_iterations(scene) == CONSTRAINT_DEFAULT_ITERATIONS);
+    Body *light = add_constrained_body(scene, VEC_ZERO, 1);
+    Body *heavy = add_constrained_body(scene, (Vector) {2, 0}, 3);
+    body_set_velocity(light, (Vector) {-1, 2});
+    body_set_velocity(heavy, (Vector) {1, -1});
+    create_distance_constraint(scene, light, heavy, 2);
+    // Constraints are solved by one batch, not force creators
+    assert(scene_forces(scene) == 0);
+    for (int i = 0; i < 100; i++) {
+        scene_tick(scene, DT);
+        assert(isclose(vec_distance(body_get_centroid(light), \
+            body_get_centroid(heavy)), 2));
+        Vector momentum = vec_add(body_get_velocity(light), \
+            vec_multiply(3, body_get_velocity(heavy)));
+        assert(vec_within(1e-9, momentum, (Vector) {2, -1}));
+    }
+    scene_free(scene);
+
+    // A pendulum swings on a rod of fixed length without gaining energy,
+    // with each integrator
+    const Integrator INTEGRATORS[] = {
+        INTEGRATOR_AVERAGE_VELOCITY, INTEGRATOR_SYMPLECTIC_EULER, \
+        INTEGRATOR_RK4
+    };
+    for (int k = 0; k < 3; k++) {
+        scene = make_constrained_chain(1, 1);
+        scene_set_integrator(scene, INTEGRATORS[k]);
+        Body *bob = scene_get_body(scene, 1);
+        double lowest = 0;
+        for (int i = 0; i < 300; i++) {
+            scene_tick(scene, DT);
+            assert(chain_error(scene) < 1e-9);
+            Vector position = body_get_centroid(bob);
+            assert(position.y < 1e-9);
+            double energy = kinetic_energy(bob) + 10 * position.y;
+            assert(energy < 1e-6);
+            lowest = fmin(lowest, position.y);
+        }
+        assert(lowest < -0.99);
+        assert(vec_equal(body_get_centroid(scene_get_body(scene, 0)), \
+            VEC_ZERO));
+        scene_free(scene);
+    }
+
+    // A pinned body stays put under gravity
+    scene = scene_init();
+    scene_set_gravity(scene, (Vector) {0, -10});
+    Body *pinned = add_constrained_body(scene, (Vector) {1, 1}, 1);
+    create_pin_constraint(scene, pinned, (Vector) {5, 5});
+    for (int i = 0; i < 100; i++) {
+        scene_tick(scene, DT);
+        assert(vec_within(1e-12, body_get_centroid(pinned), \
+            (Vector) {5, 5}));
+    }
+    scene_free(scene);
+
+    // A rope is slack until it is stretched to its length
+    scene = scene_init();
+    Body *still = add_constrained_body(scene, VEC_ZERO, 1);
+    Body *leaving = add_constrained_body(scene, (Vector) {1, 0}, 1);
+    body_set_velocity(leaving, (Vector) {1, 0});
+    create_rope_constraint(scene, still, leaving, 2);
+    for (int i = 0; i < 60; i++) {
+        scene_tick(scene, DT);
+        assert(vec_equal(body_get_centroid(still), VEC_ZERO));
+    }
+    assert(isclose(body_get_centroid(leaving).x, 2));
+    for (int i = 0; i < 60; i++) {
+        scene_tick(scene, DT);
+        assert(vec_distance(body_get_centroid(still), \
+            body_get_centroid(leaving)) < 2 + 1e-9);
+    }
+    // Once taut it drags the other body along
+    assert(body_get_velocity(still).x > 0.4);
+    assert(isclose(body_get_velocity(still).x + \
+        body_get_velocity(leaving).x, 1));
+    scene_free(scene);
+
+    // More passes hold a long chain closer to its length
+    Scene *rough = make_constrained_chain(20, 2);
+    Scene *fine = make_constrained_chain(20, 50);
+    assert(constraints_get_iterations(fine) == 50);
+    double rough_error = 0, fine_error = 0;
+    for (int i = 0; i < 120; i++) {
+        scene_tick(rough, DT);
+        scene_tick(fine, DT);
+        rough_error = fmax(rough_error, chain_error(rough));
+        fine_error = fmax(fine_error, chain_error(fine));
+    }
+    assert(fine_error < rough_error / 10);
+    scene_free(rough);
+
+    // Removing a body frees the links below it to fall
+    body_remove(scene_get_body(fine, 10));
+    for (int i = 0; i < 60; i++) {
+        scene_tick(fine, DT);
+    }
+    assert(scene_bodies(fine) == 20);
+    assert(body_get_centroid(scene_get_body(fine, 9)).y > -10);
+    assert(body_get_centroid(scene_get_body(fine, 19)).y < -20);
+    scene_free(fine);
+}
+
+/** The most any of a cloth's links along its rows and columns is stretched */
+double cloth_stretch(SoftBody *cloth, size_t columns, double spacing) {
+    double stretch = 0;
+    for (size_t i = 0; i < soft_body_particles(cloth); i++) {
+        Vector position = soft_body_get_position(cloth, i);
+        size_t neighbours[] = {i % columns + 1 < columns ? i + 1 : i, \
+            i + columns < soft_body_particles(cloth) ? i + columns : i};
+        for (size_t n = 0; n < 2; n++) {
+            if (neighbours[n] != i) {
+                double length = vec_distance(position, \
+                    soft_body_get_position(cloth, neighbours[n]));
+                stretch = fmax(stretch, length / spacing - 1);
+            }
+        }
+    }
+    return stretch;
+}
+
+/** Makes a scene with a 20 by 20 cloth hanging from its top corners */
+Scene *make_cloth_scene(
+    size_t threads, double compliance, size_t substeps, SoftBody **cloth
+) {
+    Scene *scene = scene_init();
+    scene_set_threads(scene, threads);
+    scene_set_gravity(scene, (Vector) {0, -10});
+    *cloth = create_cloth(scene, VEC_ZERO, 20, 20, 0.1, 0.01, compliance, \
+        1e-3);
+    soft_body_pin(*cloth, 0);
+    soft_body_pin(*cloth, 19);
+    soft_body_set_substeps(*cloth, substeps);
+    return scene;
+}
+
+void test_soft_bodies() {
+    const double DT = 1.0 / 60;
+    // A point is pushed out of a polygon the shortest way,
+    // whichever way the polygon winds
+    List *square = make_shape();
+    assert(vec_isclose(find_point_collision(square, (Vector) {0.5, 0.2}), \
+        (Vector) {0.5, 0}));
+    assert(vec_isclose(find_point_collision(square, (Vector) {0.1, -0.7}), \
+        (Vector) {0, -0.3}));
+    assert(vec_equal(find_point_collision(square, (Vector) {1.5, 0}), \
+        VEC_ZERO));
+    List *clockwise = list_init(4, NULL);
+    for (size_t i = 0; i < 4; i++) {
+        list_add(clockwise, list_get(square, 3 - i));
+    }
+    Vector exit = find_point_collision(clockwise, (Vector) {-0.6, 0});
+    assert(vec_isclose(exit, (Vector) {-0.4, 0}));
+    list_free(clockwise);
+    list_free(square);
+
+    // A stiff cloth hangs from its pins without stretching much, and
+    // stretches less with more substeps. A compliant one stretches more.
+    SoftBody *stiff, *rough, *soft;
+    Scene *stiff_scene = make_cloth_scene(1, 0, 40, &stiff);
+    Scene *rough_scene = make_cloth_scene(1, 0, \
+        SOFT_BODY_DEFAULT_SUBSTEPS, &rough);
+    Scene *soft_scene = make_cloth_scene(1, 1e-3, 40, &soft);
+    assert(soft_body_particles(stiff) == 400);
+    // Soft bodies are solved by batches, not force creators
+    assert(scene_forces(stiff_scene) == 0);
+    for (int i = 0; i < 120; i++) {
+        scene_tick(stiff_scene, DT);
+        scene_tick(rough_scene, DT);
+        scene_tick(soft_scene, DT);
+    }
+    assert(vec_equal(soft_body_get_position(stiff, 19), \
+        (Vector) {19 * 0.1, 0}));
+    assert(vec_equal(soft_body_get_velocity(stiff, 0), VEC_ZERO));
+    assert(soft_body_get_position(stiff, 399).y < -1.5);
+    assert(cloth_stretch(stiff, 20, 0.1) < 0.01);
+    assert(cloth_stretch(rough, 20, 0.1) > 2 * cloth_stretch(stiff, 20, 0.1));
+    assert(cloth_stretch(soft, 20, 0.1) > 2 * cloth_stretch(stiff, 20, 0.1));
+    scene_free(stiff_scene);
+    scene_free(rough_scene);
+    scene_free(soft_scene);
+
+    // Solving on several threads gives the same bits as one
+    SoftBody *serial_cloth, *parallel_cloth;
+    Scene *serial = make_cloth_scene(1, 1e-6, 10, &serial_cloth);
+    Scene *parallel = make_cloth_scene(4, 1e-6, 10, &parallel_cloth);
+    for (int i = 0; i < 30; i++) {
+        scene_tick(serial, DT);
+        scene_tick(parallel, DT);
+    }
+    for (size_t i = 0; i < 400; i++) {
+        assert(vec_equal(soft_body_get_position(serial_cloth, i), \
+            soft_body_get_position(parallel_cloth, i)));
+    }
+    scene_free(serial);
+    scene_free(parallel);
+
+    // A ball bounces on a floor without going through it, gaining energy
+    // or losing its area, and falls once the floor is removed
+    Scene *scene = scene_init();
+    scene_set_gravity(scene, (Vector) {0, -10});
+    BodyHandle handle = scene_spawn_body(scene, \
+        get_rectangle((Vector) {0, -1}, 10, 2), 1, (RGBColor) {0, 0, 0}, \
+        NULL, NULL);
+    Body *floor = scene_get_body_by_handle(scene, handle);
+    body_set_type(floor, BODY_STATIC);
+    SoftBody *ball = create_soft_ball(scene, (Vector) {0, 2}, 1, 32, 0.1, \
+        1e-4, 0);
+    soft_body_add_collider(ball, floor);
+    const double AREA = 16 * sin(2 * M_PI / 32);
+    double lowest = INFINITY;
+    for (int i = 0; i < 180; i++) {
+        scene_tick(scene, DT);
+        double area = 0, height = 0;
+        for (size_t p = 0; p < 32; p++) {
+            Vector position = soft_body_get_position(ball, p);
+            assert(position.y > -1e-9);
+            area += vec_cross(position, \
+                soft_body_get_position(ball, (p + 1) % 32)) / 2;
+            height += position.y / 32;
+            lowest = fmin(lowest, position.y);
+        }
+        assert(fabs(area / AREA - 1) < 0.01);
+        assert(height < 2.5);
+    }
+    assert(lowest < 1e-6);
+    body_remove(floor);
+    for (int i = 0; i < 60; i++) {
+        scene_tick(scene, DT);
+    }
+    assert(soft_body_get_position(ball, 0).y < -1);
+    scene_free(scene);
+}
+
+void test_game_loop() {
+    // Steps of 1/4 s are exact in floating point
+    GameLoop *loop = game_loop_init(0.25, 3);
+    assert(game_loop_advance(loop, 0.625) == 2);
+    assert(isclose(game_loop_alpha(loop), 0.5));
+    assert(game_loop_advance(loop, 0.125) == 1);
+    assert(isclose(game_loop_alpha(loop), 0));
+    // A long frame runs at most 3 steps and drops the rest
+    assert(game_loop_advance(loop, 2.125) == 3);
+    assert(isclose(game_loop_dropped_time(loop), 1.25));
+    assert(isclose(game_loop_alpha(loop), 0.5));
+    assert(game_loop_advance(loop, 0) == 0);
+
+    // Ticking a scene interpolates between the last two steps
+    Scene *scene = scene_init();
+    Body *moving = body_init(make_shape(), 1, (RGBColor) {0, 0, 0});
+    body_set_velocity(moving, (Vector) {1, 0});
+    scene_add_body(scene, moving);
+    assert(game_loop_tick_scene(loop, scene, 0.25) == 1);
+    assert(vec_isclose(body_get_centroid(moving), (Vector) {0.25, 0}));
+    const Vector *offsets = game_loop_render_offsets(loop, scene);
+    assert(vec_isclose(offsets[0], (Vector) {-0.125, 0}));
+    // Bodies added since then are drawn where they are
+    scene_add_body(scene, body_init(make_shape(), 1, (RGBColor) {0, 0, 0}));
+    offsets = game_loop_render_offsets(loop, scene);
+    assert(vec_isclose(offsets[0], (Vector) {-0.125, 0}));
+    assert(vec_isclose(offsets[1], VEC_ZERO));
+    scene_free(scene);
+    game_loop_free(loop);
+}
+
 int main(int argc, char *argv[]) {
     // Run all tests if there are no command-line arguments
     bool all_tests = argc == 1;
@@ -161,6 +1650,29 @@ int main(int argc, char *argv[]) {
     DO_TEST(test_newtonian_gravity)
     DO_TEST(test_drag)
     DO_TEST(test_zero_drag_no_slow_down)
+    DO_TEST(test_body_handles)
+    DO_TEST(test_body_arrays_match_bodies)
+    DO_TEST(test_scene_reset)
+    DO_TEST(test_scene_spawn_many)
+    DO_TEST(test_allocator)
+    DO_TEST(test_vec)
+    DO_TEST(test_list_inline)
+    DO_TEST(test_body_integrate)
+    DO_TEST(test_game_loop)
+    DO_TEST(test_integrators)
+    DO_TEST(test_adaptive_step)
+    DO_TEST(test_substeps)
+    DO_TEST(test_body_types)
+    DO_TEST(test_sleeping)
+    DO_TEST(test_thread_pool)
+    DO_TEST(test_parallel_tick)
+    DO_TEST(test_force_batches)
+    DO_TEST(test_nbody_gravity)
+    DO_TEST(test_barnes_hut_gravity)
+    DO_TEST(test_uniform_gravity)
+    DO_TEST(test_spring_network)
+    DO_TEST(test_constraints)
+    DO_TEST(test_soft_bodies)
 
     puts("forces_test PASS");
     return 0;